@@ -14,6 +14,16 @@
 
 #include "dbdimp.h"
 
+#if defined(HAS_MMAP) && defined(I_SYS_MMAN)
+#include <sys/mman.h>
+#define DBD_DRIZZLE_HAS_MMAP 1
+#endif
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define DBD_DRIZZLE_HAS_SSE2 1
+#endif
+
 #if defined(WIN32)  &&  defined(WORD)
 #undef WORD
 typedef short WORD;
@@ -175,6 +185,163 @@ static enum enum_field_types drizzle_to_perl_type(enum enum_field_types type)
 }
 */
 
+/*
+  Writes a value to ptr as an SQL literal: with is_num the number it
+  starts with, otherwise the value quoted and escaped. ptr needs room for
+  2*vallen+3 bytes. Returns the end of what was written.
+*/
+static char *sql_literal(char *ptr, char *valbuf, STRLEN vallen, bool is_num)
+{
+  char *cp, *end;
+
+  if (!is_num)
+  {
+    *ptr++ = '\'';
+    ptr += drizzle_escape_string(ptr, valbuf, vallen);
+    *ptr++ = '\'';
+  }
+  else
+  {
+    parse_number(valbuf, vallen, &end);
+    for (cp= valbuf; cp < end; cp++)
+      *ptr++= *cp;
+  }
+  return ptr;
+}
+
+/*
+  SQL types whose values are sent unquoted
+*/
+static bool is_numeric_type(int type)
+{
+  switch (type)
+  {
+    case SQL_NUMERIC:
+    case SQL_DECIMAL:
+    case SQL_INTEGER:
+    case SQL_SMALLINT:
+    case SQL_FLOAT:
+    case SQL_REAL:
+    case SQL_DOUBLE:
+    case SQL_BIGINT:
+    case SQL_TINYINT:
+      return TRUE;
+  }
+  return FALSE;
+}
+
+/*
+  An array reference bound to a placeholder stands for a list of values,
+  as in IN (?). Returns the array, or NULL for other values.
+*/
+static AV *param_list(SV *value)
+{
+  if (value && SvROK(value) && !sv_isobject(value) &&
+      SvTYPE(SvRV(value)) == SVt_PVAV)
+    return (AV*) SvRV(value);
+  return NULL;
+}
+
+/*
+  The range of elements of the list bound to ph that is sent
+*/
+static void param_list_range(imp_sth_ph_t *ph, AV *av, I32 *first, I32 *last)
+{
+  *first= ph->list_offset;
+  *last= av_len(av);
+  if (ph->list_count && *first + ph->list_count - 1 < *last)
+    *last= *first + ph->list_count - 1;
+}
+
+/*
+  Upper bound of the bytes param_list_sql() writes
+*/
+static STRLEN param_list_size(imp_sth_ph_t *ph, AV *av)
+{
+  STRLEN size= 4, vallen;
+  I32 i, first, last;
+  SV **svp;
+
+  param_list_range(ph, av, &first, &last);
+  for (i= first; i <= last; i++)
+  {
+    /* The only fetch of a magical element; param_list_sql() uses its value */
+    if ((svp= av_fetch(av, i, FALSE)))
+      SvGETMAGIC(*svp);
+    if (svp && SvOK(*svp))
+    {
+      (void) SvPV_nomg(*svp, vallen);
+      size+= 2*vallen + 4;
+    }
+    else
+      size+= 5;
+  }
+  return size;
+}
+
+/*
+  Writes the list bound to ph as comma separated literals, or NULL if it
+  is empty, which no IN () matches. Elements are left unquoted if they
+  are numbers and the placeholder has a numeric type, or with
+  bind_type_guessing.
+*/
+static char *param_list_sql(char *ptr, imp_sth_ph_t *ph, AV *av,
+                            bool bind_type_guessing)
+{
+  bool numeric= bind_type_guessing || is_numeric_type(ph->type);
+  I32 i, first, last;
+  char *valbuf, *end;
+  STRLEN vallen;
+  SV **svp;
+
+  param_list_range(ph, av, &first, &last);
+  if (first > last)
+  {
+    memcpy(ptr, "NULL", 4);
+    return ptr + 4;
+  }
+  for (i= first; i <= last; i++)
+  {
+    if (i > first)
+      *ptr++= ',';
+    if (!(svp= av_fetch(av, i, FALSE)) || !SvOK(*svp))
+    {
+      memcpy(ptr, "NULL", 4);
+      ptr+= 4;
+      continue;
+    }
+    valbuf= SvPV_nomg(*svp, vallen);
+    ptr= sql_literal(ptr, valbuf, vallen,
+                     numeric && !parse_number(valbuf, vallen, &end));
+  }
+  return ptr;
+}
+
+/*
+  Appends value to buf as an SQL literal, NULL if undefined. As for
+  placeholders without a type, numbers are left unquoted only with
+  bind_type_guessing.
+*/
+static void sv_cat_literal(SV *buf, SV *value, bool bind_type_guessing)
+{
+  char *valbuf, *end;
+  STRLEN vallen, cur= SvCUR(buf);
+  bool is_num;
+
+  SvGETMAGIC(value);
+  if (!SvOK(value))
+  {
+    sv_catpvn(buf, "NULL", 4);
+    return;
+  }
+  valbuf= SvPV_nomg(value, vallen);
+  is_num= bind_type_guessing && !parse_number(valbuf, vallen, &end);
+  SvGROW(buf, cur + 2*vallen + 4);
+  end= sql_literal(SvPVX(buf) + cur, valbuf, vallen, is_num);
+  SvCUR_set(buf, end - SvPVX(buf));
+  *SvEND(buf)= '\0';
+}
+
 /*
   constructs an SQL statement previously prepared with
   actual values replacing placeholders
@@ -190,7 +357,7 @@ static char *parse_params(
 
   char *salloc, *statement_ptr;
   char *statement_ptr_end, *ptr, *valbuf;
-  char *cp, *end;
+  char *end;
   int alen, i;
   int slen= *slen_ptr;
   int limit_flag= 0;
@@ -209,24 +376,30 @@ static char *parse_params(
     --slen;
   }
 
-  /* Calculate the number of bytes being allocated for the statement */
+  /*
+    Calculate the number of bytes being allocated for the statement. Get
+    magic, as of values bound with drizzle_bind_by_ref, runs only here, so
+    the values written below are the ones measured.
+  */
   alen= slen;
 
   for (i= 0, ph= params; i < num_params; i++, ph++)
   {
     int defined= 0;
+    AV *list;
     if (ph->value)
     {
-      if (SvMAGICAL(ph->value))
-        mg_get(ph->value);
+      SvGETMAGIC(ph->value);
       if (SvOK(ph->value))
         defined=1;
     }
     if (!defined)
       alen+= 3;  /* Erase '?', insert 'NULL' */
+    else if ((list= param_list(ph->value)))
+      alen+= param_list_size(ph, list);
     else
     {
-      valbuf= SvPV(ph->value, vallen);
+      valbuf= SvPV_nomg(ph->value, vallen);
       alen+= 2+vallen+1;
       /* this will most likely not happen since line 214 */
       /* of drizzle.xs hardcodes all types to SQL_VARCHAR */
@@ -235,7 +408,7 @@ static char *parse_params(
         //if (bind_type_guessing > 1 )
         if (bind_type_guessing)
         {
-          valbuf= SvPV(ph->value, vallen);
+          valbuf= SvPV_nomg(ph->value, vallen);
           ph->type= SQL_INTEGER;
 
           if (parse_number(valbuf, vallen, &end) != 0)
@@ -316,27 +489,17 @@ static char *parse_params(
           *ptr++ = 'L';
           *ptr++ = 'L';
         }
+        else if (param_list(ph->value))
+          ptr= param_list_sql(ptr, ph, param_list(ph->value),
+                              bind_type_guessing);
         else
         {
           int is_num = FALSE;
 
-          valbuf= SvPV(ph->value, vallen);
+          valbuf= SvPV_nomg(ph->value, vallen);
           if (valbuf)
           {
-            switch (ph->type)
-            {
-              case SQL_NUMERIC:
-              case SQL_DECIMAL:
-              case SQL_INTEGER:
-              case SQL_SMALLINT:
-              case SQL_FLOAT:
-              case SQL_REAL:
-              case SQL_DOUBLE:
-              case SQL_BIGINT:
-              case SQL_TINYINT:
-                is_num = TRUE;
-                break;
-            }
+            is_num = is_numeric_type(ph->type);
 
             /* (note this sets *end, which we use if is_num) */
             /* PMG */
@@ -354,18 +517,7 @@ static char *parse_params(
             if (limit_flag == 1)
               is_num = TRUE;
 
-            if (!is_num)
-            {
-              *ptr++ = '\'';
-              ptr += drizzle_escape_string(ptr, valbuf, vallen);
-              *ptr++ = '\'';
-            }
-            else
-            {
-              //parse_number(valbuf, vallen, &end);
-              for (cp= valbuf; cp < end; cp++)
-                  *ptr++= *cp;
-            }
+            ptr= sql_literal(ptr, valbuf, vallen, is_num);
           }
         }
         break;
@@ -389,602 +541,1177 @@ static char *parse_params(
   return(salloc);
 }
 
-int bind_param(imp_sth_ph_t *ph, SV *value, IV sql_type)
+/*
+  Binds value to ph. With by_ref the caller's SV itself is kept and read
+  when the statement is executed; otherwise the value is copied, into the
+  SV of the last value when that is our own.
+*/
+int bind_param(imp_sth_ph_t *ph, SV *value, IV sql_type, bool by_ref)
 {
-  if (ph->value)
+  if (ph->value && !ph->by_ref && !by_ref && SvREFCNT(ph->value) == 1)
+    sv_setsv(ph->value, value);
+  else
   {
-    if (SvMAGICAL(ph->value))
-      mg_get(ph->value);
-    (void) SvREFCNT_dec(ph->value);
+    if (by_ref)
+      SvREFCNT_inc(value);
+    if (ph->value)
+    {
+      if (SvMAGICAL(ph->value) && !ph->by_ref)
+        mg_get(ph->value);
+      (void) SvREFCNT_dec(ph->value);
+    }
+    ph->value= by_ref ? value : newSVsv(value);
+    ph->by_ref= by_ref;
   }
 
-  ph->value= newSVsv(value);
-
   if (sql_type)
     ph->type = sql_type;
 
   return TRUE;
 }
 
-static const sql_type_info_t SQL_GET_TYPE_INFO_values[]= {
-  /* 0 */
-  { "varchar",    SQL_VARCHAR,                    255, "'",  "'",  "max length",
-    1, 0, 3, 0, 0, 0, "variable length string",
-    0, 0, 0,
-    SQL_VARCHAR, 0, 0,
-    DRIZZLE_COLUMN_TYPE_VARCHAR,  0,
-  },
-  /* 1 */
-  { "decimal",   SQL_DECIMAL,                      15, NULL, NULL, "precision,scale",
-    1, 0, 3, 0, 0, 0, "double",
-    0, 6, 2,
-    SQL_DECIMAL, 0, 0,
-    DRIZZLE_COLUMN_TYPE_NEWDECIMAL,     1
-  },
-  /* 2 */
-  { "tinyint",   SQL_TINYINT,                       3, NULL, NULL, NULL,
-    1, 0, 3, 0, 0, 0, "Tiny integer",
-    0, 0, 10,
-    SQL_TINYINT, 0, 0,
-    DRIZZLE_COLUMN_TYPE_TINY,     1
-  },
-  /* 3 */
-  { "smallint",  SQL_SMALLINT,                      5, NULL, NULL, NULL,
-    1, 0, 3, 0, 0, 0, "Short integer",
-    0, 0, 10,
-    SQL_SMALLINT, 0, 0,
-    DRIZZLE_COLUMN_TYPE_LONG,     1
-  },
-  /* 4 */
-  { "integer",   SQL_INTEGER,                      5, NULL, NULL, NULL,
-    1, 0, 3, 0, 0, 0, "integer",
-    0, 0, 10,
-    SQL_INTEGER, 0, 0,
-    DRIZZLE_COLUMN_TYPE_LONG,     1
-  },
-  /* 5 */
-  { "float",     SQL_REAL,                          7,  NULL, NULL, NULL,
-    1, 0, 0, 0, 0, 0, "float",
-    0, 2, 10,
-    SQL_FLOAT, 0, 0,
-    DRIZZLE_COLUMN_TYPE_DOUBLE,     1
-  },
-  /* 6 */
-  { "double",    SQL_FLOAT,                       15,  NULL, NULL, NULL,
-    1, 0, 3, 0, 0, 0, "double",
-    0, 4, 2,
-    SQL_FLOAT, 0, 0,
-    DRIZZLE_COLUMN_TYPE_DOUBLE,     1
-  },
-  /* 7 */
-  { "double",    SQL_DOUBLE,                       15,  NULL, NULL, NULL,
-    1, 0, 3, 0, 0, 0, "double",
-    0, 4, 10,
-    SQL_DOUBLE, 0, 0,
-    DRIZZLE_COLUMN_TYPE_DOUBLE,     1
-  },
-  /*
-    DRIZZLE_COLUMN_TYPE_NULL ?
-  */
-  /* 8 */
-  { "timestamp", SQL_TIMESTAMP,                    14, "'", "'", NULL,
-    0, 0, 3, 0, 0, 0, "timestamp",
-    0, 0, 0,
-    SQL_TIMESTAMP, 0, 0,
-    DRIZZLE_COLUMN_TYPE_TIMESTAMP,     0
-  },
-  /* 9 */
-  { "bigint",    SQL_BIGINT,                       19, NULL, NULL, NULL,
-    1, 0, 3, 0, 0, 0, "Longlong integer",
-    0, 0, 10,
-    SQL_BIGINT, 0, 0,
-    DRIZZLE_COLUMN_TYPE_LONGLONG,     1
-  },
-  /* 10 */
-  { "mediumint", SQL_INTEGER,                       8, NULL, NULL, NULL,
-    1, 0, 3, 0, 0, 0, "Medium integer",
-    0, 0, 10,
-    SQL_INTEGER, 0, 0,
-    DRIZZLE_COLUMN_TYPE_LONG,     1
-  },
-  /* 11 */
-  { "time", SQL_TIME, 6, "'",  "'",  NULL,
-    1, 0, 3, 0, 0, 0, "time",
-    0, 0, 0,
-    SQL_TIME, 0, 0,
-    DRIZZLE_COLUMN_TYPE_TIME,     0
-  },
-  /* 12 */
-  { "datetime",  SQL_TIMESTAMP, 21, "'",  "'",  NULL,
-    1, 0, 3, 0, 0, 0, "datetime",
-    0, 0, 0,
-    SQL_TIMESTAMP, 0, 0,
-    DRIZZLE_COLUMN_TYPE_DATETIME,     0
-  },
-  /* 13 */
-  /*{ "date", SQL_DATE, 10, "'",  "'",  NULL,
-    1, 0, 3, 0, 0, 0, "date",
-    0, 0, 0,
-    SQL_DATE, 0, 0,
-    DRIZZLE_COLUMN_TYPE_NEWDATE,     0
-  },
-  */
-  /* 14 */
-  { "enum",      SQL_VARCHAR,                     255, "'",  "'",  NULL,
-    1, 0, 1, 0, 0, 0, "enum(value1,value2,value3...)",
-    0, 0, 0,
-    0, 0, 0,
-    DRIZZLE_COLUMN_TYPE_ENUM,     0
-  },
-  /* 15 */
-  { "blob",       SQL_LONGVARBINARY,              65535, "'",  "'",  NULL,
-    1, 0, 3, 0, 0, 0, "binary large object (0-65535)",
-    0, 0, 0,
-    SQL_LONGVARBINARY, 0, 0,
-    DRIZZLE_COLUMN_TYPE_BLOB,     0
-  },
-  { "tinyblob",  SQL_VARBINARY,                 255, "'",  "'",  NULL,
-    1, 0, 3, 0, 0, 0, "binary large object (0-255) ",
-    0, 0, 0,
-    SQL_VARBINARY, 0, 0,
-    DRIZZLE_COLUMN_TYPE_BLOB,        0
-  },
-  { "mediumblob", SQL_LONGVARBINARY,           16777215, "'",  "'",  NULL,
-    1, 0, 3, 0, 0, 0, "binary large object",
-    0, 0, 0,
-    SQL_LONGVARBINARY, 0, 0,
-    DRIZZLE_COLUMN_TYPE_BLOB, 0
-  },
-  { "longblob",   SQL_LONGVARBINARY,         2147483647, "'",  "'",  NULL,
-    1, 0, 3, 0, 0, 0, "binary large object, use mediumblob instead",
-    0, 0, 0,
-    SQL_LONGVARBINARY, 0, 0,
-    DRIZZLE_COLUMN_TYPE_BLOB,   0
-  },
-  { "char",       SQL_CHAR,                       255, "'",  "'",  "max length",
-    1, 0, 3, 0, 0, 0, "string",
-    0, 0, 0,
-    SQL_CHAR, 0, 0,
-    DRIZZLE_COLUMN_TYPE_VARCHAR,   0
-  },
+/*
+  Names of the result_cap_actions, as used for drizzle_max_result_action
+*/
+static const char *result_cap_action_names[]= { "error", "stream", "spill" };
 
-  { "decimal",            SQL_NUMERIC,            15,  NULL, NULL, "precision,scale",
-    1, 0, 3, 0, 0, 0, "double",
-    0, 6, 2,
-    SQL_NUMERIC, 0, 0,
-    DRIZZLE_COLUMN_TYPE_NEWDECIMAL,   1
-  },
-  { "tinyint unsigned",   SQL_TINYINT,              3, NULL, NULL, NULL,
-    1, 0, 3, 1, 0, 0, "Tiny integer unsigned",
-    0, 0, 10,
-    SQL_TINYINT, 0, 0,
-    DRIZZLE_COLUMN_TYPE_TINY,        1
-  },
-  { "smallint unsigned",  SQL_SMALLINT,             5, NULL, NULL, NULL,
-    1, 0, 3, 1, 0, 0, "Short integer unsigned",
-    0, 0, 10,
-    SQL_SMALLINT, 0, 0,
-    DRIZZLE_COLUMN_TYPE_LONG,       1
-  },
-  { "mediumint unsigned", SQL_INTEGER,              8, NULL, NULL, NULL,
-    1, 0, 3, 1, 0, 0, "Medium integer unsigned",
-    0, 0, 10,
-    SQL_INTEGER, 0, 0,
-    DRIZZLE_COLUMN_TYPE_LONG,       1
-  },
-  { "int unsigned",       SQL_INTEGER,             10, NULL, NULL, NULL,
-    1, 0, 3, 1, 0, 0, "integer unsigned",
-    0, 0, 10,
-    SQL_INTEGER, 0, 0,
-    DRIZZLE_COLUMN_TYPE_LONG,        1
-  },
-  { "int",                SQL_INTEGER,             10, NULL, NULL, NULL,
-    1, 0, 3, 0, 0, 0, "integer",
-    0, 0, 10,
-    SQL_INTEGER, 0, 0,
-    DRIZZLE_COLUMN_TYPE_LONG,        1
-  },
-  { "integer unsigned",   SQL_INTEGER,             10, NULL, NULL, NULL,
-    1, 0, 3, 1, 0, 0, "integer",
-    0, 0, 10,
-    SQL_INTEGER, 0, 0,
-    DRIZZLE_COLUMN_TYPE_LONG,        1
-  },
-  { "bigint unsigned",    SQL_BIGINT,              20, NULL, NULL, NULL,
-    1, 0, 3, 1, 0, 0, "Longlong integer unsigned",
-    0, 0, 10,
-    SQL_BIGINT, 0, 0,
-    DRIZZLE_COLUMN_TYPE_LONGLONG,    1
-  },
-  { "text",               SQL_LONGVARCHAR,      65535, "'",  "'",  NULL,
-    1, 0, 3, 0, 0, 0, "large text object (0-65535)",
-    0, 0, 0,
-    SQL_LONGVARCHAR, 0, 0,
-    DRIZZLE_COLUMN_TYPE_BLOB,        0
-  },
-  { "mediumtext",         SQL_LONGVARCHAR,   16777215, "'",  "'",  NULL,
-    1, 0, 3, 0, 0, 0, "large text object",
-    0, 0, 0,
-    SQL_LONGVARCHAR, 0, 0,
-    DRIZZLE_COLUMN_TYPE_BLOB, 0
-  },
-  { "mediumint unsigned auto_increment", SQL_INTEGER, 8, NULL, NULL, NULL,
-    0, 0, 3, 1, 0, 1, "Medium integer unsigned auto_increment", 0, 0, 10,
-    SQL_INTEGER, 0, 0, DRIZZLE_COLUMN_TYPE_LONG, 1,
-  },
-  { "tinyint unsigned auto_increment", SQL_TINYINT, 3, NULL, NULL, NULL,
-    0, 0, 3, 1, 0, 1, "tinyint unsigned auto_increment", 0, 0, 10,
-    SQL_TINYINT, 0, 0, DRIZZLE_COLUMN_TYPE_TINY, 1
-  },
+/*
+  Maps a drizzle_max_result_action value to one of the result_cap_actions.
+  Without mmap() there is no way to read back a spilled result, so we
+  stream instead.
+*/
+static int result_cap_action(SV *value)
+{
+  char *action= SvOK(value) ? SvPV_nolen(value) : "error";
 
-  { "smallint auto_increment", SQL_SMALLINT, 5, NULL, NULL, NULL,
-    0, 0, 3, 0, 0, 1, "smallint auto_increment", 0, 0, 10,
-    SQL_SMALLINT, 0, 0, DRIZZLE_COLUMN_TYPE_LONG, 1
-  },
+  if (strEQ(action, "stream"))
+    return RESULT_CAP_STREAM;
+  if (strEQ(action, "spill"))
+  {
+#ifdef DBD_DRIZZLE_HAS_MMAP
+    return RESULT_CAP_SPILL;
+#else
+    return RESULT_CAP_STREAM;
+#endif
+  }
+  return RESULT_CAP_ERROR;
+}
 
-  { "int unsigned auto_increment", SQL_INTEGER, 10, NULL, NULL, NULL,
-    0, 0, 3, 1, 0, 1, "integer unsigned auto_increment", 0, 0, 10,
-    SQL_INTEGER, 0, 0, DRIZZLE_COLUMN_TYPE_LONG, 1
-  },
+/*
+  Names of the datetime_as_modes, as used for drizzle_datetime_as
+*/
+static const char *datetime_as_names[]= { "string", "epoch", "epoch_ms" };
 
-  { "mediumint", SQL_INTEGER, 7, NULL, NULL, NULL,
-    1, 0, 3, 0, 0, 0, "Medium integer", 0, 0, 10,
-    SQL_INTEGER, 0, 0, DRIZZLE_COLUMN_TYPE_LONG, 1
-  },
+/*
+  Maps a drizzle_datetime_as value to one of the datetime_as_modes, -1 if
+  it names none of them
+*/
+static int datetime_as_mode(SV *value)
+{
+  char *mode= SvOK(value) ? SvPV_nolen(value) : "string";
+  int i;
 
-  { "bit", SQL_BIT, 1, NULL, NULL, NULL,
-    1, 0, 3, 0, 0, 0, "char(1)", 0, 0, 0,
-    SQL_BIT, 0, 0, DRIZZLE_COLUMN_TYPE_LONG, 0
-  },
+  for (i= 0; i <= DATETIME_AS_EPOCH_MS; i++)
+    if (strEQ(mode, datetime_as_names[i]))
+      return i;
+  return -1;
+}
 
-  { "numeric", SQL_NUMERIC, 19, NULL, NULL, "precision,scale",
-    1, 0, 3, 0, 0, 0, "numeric", 0, 19, 10,
-    SQL_NUMERIC, 0, 0, DRIZZLE_COLUMN_TYPE_NEWDECIMAL, 1,
-  },
+/*
+  Maps a drizzle_datetime_offset value, seconds or [+-]HH[:MM], to seconds
+  east of UTC. Returns FALSE if value is neither.
+*/
+static bool datetime_offset(SV *value, IV *offset)
+{
+  const char *p;
+  IV hours= 0, minutes= 0;
+  int sign= 1, digits;
 
-  { "integer unsigned auto_increment", SQL_INTEGER, 10, NULL, NULL, NULL,
-    0, 0, 3, 1, 0, 1, "integer unsigned auto_increment", 0, 0, 10,
-    SQL_INTEGER, 0, 0, DRIZZLE_COLUMN_TYPE_LONG, 1,
-  },
+  *offset= 0;
+  if (!SvOK(value))
+    return TRUE;
+  if (looks_like_number(value))
+  {
+    *offset= SvIV(value);
+    return TRUE;
+  }
+  p= SvPV_nolen(value);
+  if (*p == '+' || *p == '-')
+    sign= *p++ == '-' ? -1 : 1;
+  for (digits= 0; isDIGIT(*p); digits++)
+    hours= hours*10 + (*p++ - '0');
+  if (!digits || digits > 2 || hours > 23)
+    return FALSE;
+  if (*p == ':')
+  {
+    for (digits= 0; isDIGIT(*++p); digits++)
+      minutes= minutes*10 + (*p - '0');
+    if (digits != 2 || minutes > 59)
+      return FALSE;
+  }
+  if (*p)
+    return FALSE;
+  *offset= sign * (hours*3600 + minutes*60);
+  return TRUE;
+}
 
-  { "mediumint unsigned", SQL_INTEGER, 8, NULL, NULL, NULL,
-    1, 0, 3, 1, 0, 0, "Medium integer unsigned", 0, 0, 10,
-    SQL_INTEGER, 0, 0, DRIZZLE_COLUMN_TYPE_LONG, 1
-  },
+/*
+  Whether the len bytes at p are all ASCII, so they need no UTF-8 check.
+  Looks at 16 bytes at a time with SSE2, a word at a time otherwise.
+*/
+static bool ascii_only(const char *p, size_t len)
+{
+  const char *end= p + len;
+  UV word;
 
-  { "smallint unsigned auto_increment", SQL_SMALLINT, 5, NULL, NULL, NULL,
-    0, 0, 3, 1, 0, 1, "smallint unsigned auto_increment", 0, 0, 10,
-    SQL_SMALLINT, 0, 0, DRIZZLE_COLUMN_TYPE_LONG, 1
-  },
+#ifdef DBD_DRIZZLE_HAS_SSE2
+  for (; end - p >= 16; p+= 16)
+    if (_mm_movemask_epi8(_mm_loadu_si128((const __m128i*) p)))
+      return FALSE;
+#endif
+  for (; end - p >= (ptrdiff_t) sizeof(UV); p+= sizeof(UV))
+  {
+    memcpy(&word, p, sizeof(UV));
+    if (word & ((UV) -1 / 0xff * 0x80))
+      return FALSE;
+  }
+  for (; p < end; p++)
+    if (*p & 0x80)
+      return FALSE;
+  return TRUE;
+}
 
-  { "int auto_increment", SQL_INTEGER, 10, NULL, NULL, NULL,
-    0, 0, 3, 0, 0, 1, "integer auto_increment", 0, 0, 10,
-    SQL_INTEGER, 0, 0, DRIZZLE_COLUMN_TYPE_LONG, 1
-  },
+/*
+  The length of the len bytes at p without trailing blanks, for
+  ChopBlanks. Compares a word at a time while they are all blanks.
+*/
+static size_t chop_blanks_len(const char *p, size_t len)
+{
+  const UV blanks= (UV) -1 / 0xff * ' ';
+  UV word;
 
-  { "long varbinary", SQL_LONGVARBINARY, 16777215, "0x", NULL, NULL,
-    1, 0, 3, 0, 0, 0, "mediumblob", 0, 0, 0,
-    SQL_LONGVARBINARY, 0, 0, DRIZZLE_COLUMN_TYPE_BLOB, 0
-  },
+  while (len >= sizeof(UV))
+  {
+    memcpy(&word, p + len - sizeof(UV), sizeof(UV));
+    if (word != blanks)
+      break;
+    len-= sizeof(UV);
+  }
+  while (len && p[len-1] == ' ')
+    --len;
+  return len;
+}
 
-  { "double auto_increment", SQL_FLOAT, 15, NULL, NULL, NULL,
-    0, 0, 3, 0, 0, 1, "double auto_increment", 0, 4, 2,
-    SQL_FLOAT, 0, 0, DRIZZLE_COLUMN_TYPE_DOUBLE, 1
-  },
+/*
+  Sets sv to the value of a fetched field, undef for NULL, as fetch
+  returns it. With intern the value is a shared string, which equal
+  values and copies of them use as well.
+*/
+static void drizzle_field_sv(SV *sv, drizzle_field_t field, size_t len,
+                             drizzle_column_st *col, bool chop_blanks,
+                             bool enable_utf8, bool intern)
+{
+  bool utf8= FALSE;
 
-  { "double auto_increment", SQL_DOUBLE, 15, NULL, NULL, NULL,
-    0, 0, 3, 0, 0, 1, "double auto_increment", 0, 4, 10,
-    SQL_DOUBLE, 0, 0, DRIZZLE_COLUMN_TYPE_DOUBLE, 1
-  },
+  if (!field)
+  {
+    (void) SvOK_off(sv);  /*  Field is NULL, return undef  */
+    return;
+  }
+  if (chop_blanks)
+    len= chop_blanks_len(field, len);
 
-  { "integer auto_increment", SQL_INTEGER, 10, NULL, NULL, NULL,
-    0, 0, 3, 0, 0, 1, "integer auto_increment", 0, 0, 10,
-    SQL_INTEGER, 0, 0, DRIZZLE_COLUMN_TYPE_LONG, 1,
-  },
+  /* UTF8: what sv_utf8_decode does, but ASCII is told apart fast */
+  /*HELMUT*/
+#if defined(sv_utf8_decode)
+  if (enable_utf8 && !(drizzle_column_flags(col) & DRIZZLE_COLUMN_FLAGS_BINARY))
+    utf8= !ascii_only(field, len) && is_utf8_string((U8*) field, len);
+#endif
+  /* END OF UTF8 */
 
-  { "bigint auto_increment", SQL_BIGINT, 19, NULL, NULL, NULL,
-    0, 0, 3, 0, 0, 1, "bigint auto_increment", 0, 0, 10,
-    SQL_BIGINT, 0, 0, DRIZZLE_COLUMN_TYPE_LONGLONG, 1
-  },
+  if (intern)
+  {
+    SV *shared= newSVpvn_share(field, utf8 ? -(I32) len : (I32) len, 0);
 
-  { "bit auto_increment", SQL_BIT, 1, NULL, NULL, NULL,
-    0, 0, 3, 0, 0, 1, "char(1) auto_increment", 0, 0, 0,
-    SQL_BIT, 0, 0, DRIZZLE_COLUMN_TYPE_TINY, 1
-  },
+    sv_setsv(sv, shared);
+    SvREFCNT_dec(shared);
+    return;
+  }
+  sv_setpvn(sv, field, len);
+  if (utf8)
+    SvUTF8_on(sv);
+  else
+    SvUTF8_off(sv);
+}
 
-  { "mediumint auto_increment", SQL_INTEGER, 7, NULL, NULL, NULL,
-    0, 0, 3, 0, 0, 1, "Medium integer auto_increment", 0, 0, 10,
-    SQL_INTEGER, 0, 0, DRIZZLE_COLUMN_TYPE_LONG, 1
-  },
+/*
+  Whether to intern the value of column i for drizzle_intern_columns.
+  While a column is sampled, its distinct values are counted as well.
+*/
+static bool drizzle_st_intern_value(imp_sth_t *imp_sth, int i,
+                                    drizzle_field_t field, size_t len)
+{
+  if (!field || i >= imp_sth->intern_count)
+    return FALSE;
+  switch (imp_sth->intern[i]) {
+  case INTERN_ON:
+    return TRUE;
+  case INTERN_SAMPLE:
+    (void) hv_store(imp_sth->intern_seen[i], field, (I32) len, &sv_yes, 0);
+    return TRUE;
+  }
+  return FALSE;
+}
 
-  { "float auto_increment", SQL_REAL, 7, NULL, NULL, NULL,
-    0, 0, 0, 0, 0, 1, "float auto_increment", 0, 2, 10,
-    SQL_FLOAT, 0, 0, DRIZZLE_COLUMN_TYPE_DOUBLE, 1
-  },
+/*
+  Frees what drizzle_st_intern_setup() worked out for the last result
+*/
+static void drizzle_st_intern_free(imp_sth_t *imp_sth)
+{
+  int i;
 
-  { "long varchar", SQL_LONGVARCHAR, 16777215, "'", "'", NULL,
-    1, 0, 3, 0, 0, 0, "mediumtext", 0, 0, 0,
-    SQL_LONGVARCHAR, 0, 0, DRIZZLE_COLUMN_TYPE_BLOB, 1
+  if (imp_sth->intern_seen)
+    for (i= 0; i < imp_sth->intern_count; i++)
+      if (imp_sth->intern_seen[i])
+        SvREFCNT_dec((SV*) imp_sth->intern_seen[i]);
+  Safefree(imp_sth->intern);
+  Safefree(imp_sth->intern_seen);
+  imp_sth->intern_count= 0;
+  imp_sth->intern_sampling= FALSE;
+}
 
-  },
+/*
+  Whether fetch returns col as a time for drizzle_datetime_as
+*/
+static bool datetime_column(drizzle_column_st *col)
+{
+  switch (drizzle_column_type(col)) {
+  case DRIZZLE_COLUMN_TYPE_DATE:
+  case DRIZZLE_COLUMN_TYPE_NEWDATE:
+  case DRIZZLE_COLUMN_TYPE_DATETIME:
+  case DRIZZLE_COLUMN_TYPE_TIMESTAMP:
+    return TRUE;
+  default:
+    return FALSE;
+  }
+}
 
-  { "tinyint auto_increment", SQL_TINYINT, 3, NULL, NULL, NULL,
-    0, 0, 3, 0, 0, 1, "tinyint auto_increment", 0, 0, 10,
-    SQL_TINYINT, 0, 0, DRIZZLE_COLUMN_TYPE_TINY, 1
-  },
+/*
+  Sets sv to the time in the len bytes at p, YYYY-MM-DD with an optional
+  HH:MM:SS and fraction, as seconds or milliseconds since 1970 for the
+  given datetime_as mode. offset is what the value is ahead of UTC.
+  Returns FALSE, leaving sv alone, for what is not a valid date, like
+  the zero date.
+*/
+static bool datetime_sv(SV *sv, const char *p, size_t len, int as, IV offset)
+{
+  static const char seps[]= "-- ::";
+  const char *end= p + len;
+  IV f[6]= { 0, 0, 0, 0, 0, 0 }, y, era, yoe, doy, days, secs, ms= 0;
+  NV frac= 0, scale= 1;
+  int i, digits;
 
-  { "bigint unsigned auto_increment", SQL_BIGINT, 20, NULL, NULL, NULL,
-    0, 0, 3, 1, 0, 1, "bigint unsigned auto_increment", 0, 0, 10,
-    SQL_BIGINT, 0, 0, DRIZZLE_COLUMN_TYPE_LONGLONG, 1
-  },
+  for (i= 0; i < 6 && p < end; i++)
+  {
+    if (i && *p++ != seps[i-1] && !(i == 3 && p[-1] == 'T'))
+      return FALSE;
+    if (p == end || !isDIGIT(*p))
+      return FALSE;
+    while (p < end && isDIGIT(*p))
+      f[i]= f[i]*10 + (*p++ - '0');
+  }
+  if (i != 3 && i != 6)
+    return FALSE;
+  if (i == 6 && p < end && *p == '.')
+  {
+    for (digits= 0, p++; p < end && isDIGIT(*p); p++, digits++)
+    {
+      frac+= (*p - '0') * (scale/= 10);
+      if (digits < 3)
+        ms= ms*10 + (*p - '0');
+    }
+    for (; digits < 3; digits++)
+      ms*= 10;
+  }
+  if (p != end || f[1] < 1 || f[1] > 12 || f[2] < 1 || f[2] > 31 ||
+      f[3] > 23 || f[4] > 59 || f[5] > 60)
+    return FALSE;
 
-/* END MORE STUFF */
-};
+  /* Days since 1970-01-01 in the proleptic Gregorian calendar */
+  y= f[0] - (f[1] <= 2);
+  era= (y >= 0 ? y : y - 399) / 400;
+  yoe= y - era*400;
+  doy= (153*(f[1] + (f[1] > 2 ? -3 : 9)) + 2)/5 + f[2] - 1;
+  days= era*146097 + yoe*365 + yoe/4 - yoe/100 + doy - 719468;
+  secs= days*86400 + f[3]*3600 + f[4]*60 + f[5] - offset;
+
+  if (as == DATETIME_AS_EPOCH_MS)
+    sv_setiv(sv, secs*1000 + ms);
+  else if (frac)
+    sv_setnv(sv, (NV) secs + frac);
+  else
+    sv_setiv(sv, secs);
+  return TRUE;
+}
 
 /*
-  static const sql_type_info_t* native2sql (int t)
+  Sets sv to field, column i of the current row of imp_sth, as fetch
+  returns it
 */
-static const sql_type_info_t *native2sql(int t)
+static void drizzle_st_field_sv(imp_sth_t *imp_sth, SV *sv, int i,
+                                drizzle_column_st *col,
+                                drizzle_field_t field, size_t len)
 {
-  switch (t) {
-    case DRIZZLE_COLUMN_TYPE_VARCHAR:  return &SQL_GET_TYPE_INFO_values[0];
-    case DRIZZLE_COLUMN_TYPE_NEWDECIMAL:  return &SQL_GET_TYPE_INFO_values[1];
-    case DRIZZLE_COLUMN_TYPE_TINY:        return &SQL_GET_TYPE_INFO_values[2];
-    case DRIZZLE_COLUMN_TYPE_LONG:        return &SQL_GET_TYPE_INFO_values[4];
-    case DRIZZLE_COLUMN_TYPE_DOUBLE:      return &SQL_GET_TYPE_INFO_values[7];
-    case DRIZZLE_COLUMN_TYPE_TIMESTAMP:   return &SQL_GET_TYPE_INFO_values[8];
-    case DRIZZLE_COLUMN_TYPE_LONGLONG:    return &SQL_GET_TYPE_INFO_values[9];
-    case DRIZZLE_COLUMN_TYPE_TIME:        return &SQL_GET_TYPE_INFO_values[11];
-    case DRIZZLE_COLUMN_TYPE_DATETIME:    return &SQL_GET_TYPE_INFO_values[12];
-                                   /*case DRIZZLE_COLUMN_TYPE_NEWDATE:     return &SQL_GET_TYPE_INFO_values[13];*/
-    case DRIZZLE_COLUMN_TYPE_ENUM:        return &SQL_GET_TYPE_INFO_values[14];
-    case DRIZZLE_COLUMN_TYPE_BLOB:        return &SQL_GET_TYPE_INFO_values[15];
-    default:                     return &SQL_GET_TYPE_INFO_values[0];
-  }
+  D_imp_dbh_from_sth;
+
+  if (field && imp_sth->datetime_as != DATETIME_AS_STRING &&
+      datetime_column(col) &&
+      datetime_sv(sv, field, len, imp_sth->datetime_as,
+                  imp_sth->datetime_offset))
+    return;
+  drizzle_field_sv(sv, field, len, col, DBIc_is(imp_sth, DBIcf_ChopBlanks),
+                   imp_dbh->enable_utf8,
+                   drizzle_st_intern_value(imp_sth, i, field, len));
 }
 
+/*
+  With drizzle_lazy_columns, fetch leaves the SVs of the row array pending
+  and get magic on each fills it from the row when it is first read
+*/
+static void lazy_column_fill(imp_sth_t *imp_sth, int i)
+{
+  drizzle_column_st *col;
 
-#define SQL_GET_TYPE_INFO_num \
-	(sizeof(SQL_GET_TYPE_INFO_values)/sizeof(sql_type_info_t))
+  imp_sth->lazy_pending[i]= FALSE;
+  drizzle_column_seek(imp_sth->result, i);
+  col= drizzle_column_next(imp_sth->result);
+  drizzle_st_field_sv(imp_sth, imp_sth->lazy_svs[i], i, col,
+                      imp_sth->lazy_row[i], imp_sth->lazy_lengths[i]);
+}
 
+static int lazy_column_get(pTHX_ SV *sv, MAGIC *mg)
+{
+  imp_sth_t *imp_sth= (imp_sth_t*) mg->mg_ptr;
+  int i= mg->mg_private;
 
-/***************************************************************************
- *
- *  Name:    dbd_init
- *
- *  Purpose: Called when the driver is installed by DBI
- *
- *  Input:   dbistate - pointer to the DBIS variable, used for some
- *               DBI internal things
- *
- *  Returns: Nothing
- *
- **************************************************************************/
-
-void dbd_init(dbistate_t* dbistate)
-{
-    DBIS = dbistate;
+  if (imp_sth->lazy_row && i < imp_sth->lazy_count &&
+      imp_sth->lazy_svs[i] == sv && imp_sth->lazy_pending[i])
+    lazy_column_fill(imp_sth, i);
+  return 0;
 }
 
+static MGVTBL lazy_column_vtbl= { lazy_column_get };
 
-/**************************************************************************
- *
- *  Name:    do_error, do_warn
- *
- *  Purpose: Called to associate an error code and an error message
- *           to some handle
- *
- *  Input:   h - the handle in error condition
- *           rc - the error code
- *           what - the error message
- *
- *  Returns: Nothing
- *
- **************************************************************************/
-
-void do_error(SV* h, int rc, const char* what, const char* sqlstate)
+/*
+  Takes the lazy magic off the SV of column i and lets go of it
+*/
+static void lazy_column_release(imp_sth_t *imp_sth, int i)
 {
-  D_imp_xxh(h);
-  STRLEN lna;
-  SV *errstr;
-  SV *errstate;
+  SV *sv= imp_sth->lazy_svs[i];
 
-  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-    PerlIO_printf(DBILOGFP, "\t\t--> do_error\n");
-  errstr= DBIc_ERRSTR(imp_xxh);
-  sv_setiv(DBIc_ERR(imp_xxh), (IV)rc);	/* set err early	*/
-  sv_setpv(errstr, what);
+  if (!sv)
+    return;
+  sv_unmagicext(sv, PERL_MAGIC_ext, &lazy_column_vtbl);
+  SvREFCNT_dec(sv);
+  imp_sth->lazy_svs[i]= NULL;
+}
 
-  if (sqlstate)
+/*
+  Puts row into the row array av for drizzle_lazy_columns. SVs of av that
+  came from DBI get the magic once and are kept; others, like the
+  variables of bind_col, are filled right away.
+*/
+static void drizzle_st_lazy_row(imp_sth_t *imp_sth, AV *av, drizzle_row_t row,
+                                size_t *lengths, int num_fields)
+{
+  drizzle_column_st *col;
+  SV *sv;
+  int i;
+
+  if (imp_sth->lazy_count != num_fields)
   {
-    errstate= DBIc_STATE(imp_xxh);
-    sv_setpvn(errstate, sqlstate, 5);
+    for (i= 0; i < imp_sth->lazy_count; i++)
+      lazy_column_release(imp_sth, i);
+    Renew(imp_sth->lazy_svs, num_fields ? num_fields : 1, SV*);
+    Renew(imp_sth->lazy_pending, num_fields ? num_fields : 1, char);
+    Zero(imp_sth->lazy_svs, num_fields, SV*);
+    imp_sth->lazy_count= num_fields;
   }
+  imp_sth->lazy_row= row;
+  imp_sth->lazy_lengths= lengths;
 
-  /* NO EFFECT DBIh_EVENT2(h, ERROR_event, DBIc_ERR(imp_xxh), errstr); */
-  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-    PerlIO_printf(DBILOGFP, "%s error %d recorded: %s\n",
-    what, rc, SvPV(errstr,lna));
-  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-    PerlIO_printf(DBILOGFP, "\t\t<-- do_error\n");
+  drizzle_column_seek(imp_sth->result, 0);
+  for (i= 0; i < num_fields; i++)
+  {
+    col= drizzle_column_next(imp_sth->result);
+    sv= AvARRAY(av)[i];
+    if (sv != imp_sth->lazy_svs[i])
+    {
+      lazy_column_release(imp_sth, i);
+      if (!SvMAGICAL(sv) && SvREFCNT(sv) == 1)
+      {
+        sv_magicext(sv, NULL, PERL_MAGIC_ext, &lazy_column_vtbl,
+                    (char*) imp_sth, 0)->mg_private= (U16) i;
+        imp_sth->lazy_svs[i]= SvREFCNT_inc(sv);
+      }
+    }
+
+    if (sv == imp_sth->lazy_svs[i])
+      imp_sth->lazy_pending[i]= TRUE;
+    else
+    {
+      imp_sth->lazy_pending[i]= FALSE;
+      drizzle_st_field_sv(imp_sth, sv, i, col, row[i], lengths[i]);
+    }
+  }
 }
 
 /*
-  void do_warn(SV* h, int rc, char* what)
+  Once the last fetched row goes away, fills the columns of it that have
+  not been read (when the row is freed) or makes them undef (when fetch
+  moves on)
 */
-void do_warn(SV* h, int rc, char* what)
+static void drizzle_st_lazy_done(imp_sth_t *imp_sth, bool fill)
 {
-  D_imp_xxh(h);
-  STRLEN lna;
-
-  SV *errstr = DBIc_ERRSTR(imp_xxh);
-  sv_setiv(DBIc_ERR(imp_xxh), (IV)rc);	/* set err early	*/
-  sv_setpv(errstr, what);
-  /* NO EFFECT DBIh_EVENT2(h, WARN_event, DBIc_ERR(imp_xxh), errstr);*/
-  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-    PerlIO_printf(DBILOGFP, "%s warning %d recorded: %s\n",
-    what, rc, SvPV(errstr,lna));
-  warn("%s", what);
-}
-
-#define DBD_DRIZZLE_NAMESPACE "DBD::drizzle::QUIET";
+  int i;
 
-#define doquietwarn(s) \
-  { \
-    SV* sv = perl_get_sv(DBD_DRIZZLE_NAMESPACE, FALSE);  \
-    if (!sv  ||  !SvTRUE(sv)) { \
-      warn s; \
-    } \
+  if (!imp_sth->lazy_row)
+    return;
+  for (i= 0; i < imp_sth->lazy_count; i++)
+  {
+    if (!imp_sth->lazy_pending[i])
+      continue;
+    if (fill)
+      lazy_column_fill(imp_sth, i);
+    else
+    {
+      imp_sth->lazy_pending[i]= FALSE;
+      (void) SvOK_off(imp_sth->lazy_svs[i]);
+    }
   }
+  imp_sth->lazy_row= NULL;
+}
 
+/*
+  Takes the lazy magic off the row array for good
+*/
+static void drizzle_st_lazy_free(imp_sth_t *imp_sth)
+{
+  int i;
 
-/***************************************************************************
- *
- *  Name:    drizzle_dr_connect
- *
- *  Purpose: Replacement for drizzle_connect
- *
- *  Input:   drizzle_con_st *con - Pointer to a DRIZZLE structure being
- *             initialized
- *           char* drizzle_socket - Name of a UNIX socket being used
- *             or NULL
- *           char* host - Host name being used or NULL for localhost
- *           char* port - Port number being used or NULL for default
- *           char* user - User name being used or NULL
- *           char* password - Password being used or NULL
- *           char* dbname - Database name being used or NULL
- *           char* imp_dbh - Pointer to internal dbh structure
- *
- *  Returns: The sock argument for success, NULL otherwise;
- *           you have to call do_error in the latter case.
- *
- **************************************************************************/
+  for (i= 0; i < imp_sth->lazy_count; i++)
+    lazy_column_release(imp_sth, i);
+  Safefree(imp_sth->lazy_svs);
+  Safefree(imp_sth->lazy_pending);
+  imp_sth->lazy_count= 0;
+}
 
-int drizzle_dr_connect(
-                            SV* dbh,
-                            drizzle_con_st *con,
-                            char* drizzle_socket,
-                            char* host,
-                            char* port,
-                            char* user,
-                            char* password,
-                            char* dbname,
-                            imp_dbh_t *imp_dbh)
+/*
+  Returns the closing quote of the string, identifier or quoted name
+  starting at p, or end if there is none
+*/
+static const char *skip_quoted(const char *p, const char *end)
 {
-  int portNr;
-  bool mysql_protocol= false;
-  unsigned int client_flag;
-  drizzle_return_t ret;
-  drizzle_st *drizzle;
+  char end_token= *p;
 
-  D_imp_xxh(dbh);
+  while (++p < end && *p != end_token)
+    if (*p == '\\' && p + 1 < end)
+      p++;
+  return p;
+}
 
-  portNr= (port && *port) ? atoi(port) : 0;
 /*
-#ifdef DRIZZLE_NO_CLIENT_FOUND_ROWS
-  client_flag = 0;
-#else
-  client_flag = CLIENT_FOUND_ROWS;
-#endif
+  For drizzle_write_combine: if sql is an INSERT or REPLACE ending in a
+  single VALUES (...) row that holds all the placeholders, returns the
+  offset of that row and stores its length in *row_len. Otherwise, as for
+  INSERT ... SELECT, multiple rows or ON DUPLICATE KEY UPDATE, returns 0.
 */
-  drizzle = imp_dbh->drizzle;
+static STRLEN insert_values_row(char *sql, STRLEN len, STRLEN *row_len)
+{
+  const char *p= sql, *end= sql + len, *values= NULL, *row;
+  int depth= 0;
 
-  /* too many connects */
-  //drizzle_con_create(drizzle, con);
+  while (p < end && isspace(*p))
+    p++;
+  if (!(end - p > 6 && !strncasecmp(p, "insert", 6)) &&
+      !(end - p > 7 && !strncasecmp(p, "replace", 7)))
+    return 0;
 
-  if (imp_dbh)
+  for (; p < end; p++)
   {
-    SV* sv = DBIc_IMP_DATA(imp_dbh);
-
-    DBIc_set(imp_dbh, DBIcf_AutoCommit, &sv_yes);
-    if (sv  &&  SvROK(sv))
+    if (*p == '`' || *p == '\'' || *p == '"')
     {
-      HV* hv = (HV*) SvRV(sv);
-      SV** svp;
-      STRLEN lna;
+      if ((p= skip_quoted(p, end)) == end)
+        return 0;
+    }
+    else if ((*p == 'v' || *p == 'V') && end - p > 6 &&
+             !strncasecmp(p, "values", 6) &&
+             !isALNUM(p[-1]) && !isALNUM(p[6]))
+      values= p + 6;
+  }
+  if (!values)
+    return 0;
 
-      if ((svp = hv_fetch(hv, "drizzle_con_mysql",
-                          strlen("drizzle_con_mysql"), FALSE))  &&
-          *svp && SvTRUE(*svp))
-      {
-        mysql_protocol= true;
-      }
-#if defined FUTURE_FEATURES
-      if ((svp = hv_fetch(hv, "drizzle_compression", 17, FALSE))  &&
-          *svp && SvTRUE(*svp))
-      {
-        drizzle_con_set_options(con, DRIZZLE_OPT_COMPRESS, NULL);
-      }
-      if ((svp = hv_fetch(hv, "drizzle_connect_timeout", 21, FALSE))
-          &&  *svp  &&  SvTRUE(*svp))
-      {
-        int to = SvIV(*svp);
-        drizzleclient_options(con, DRIZZLE_OPT_CONNECT_TIMEOUT,
-                        (const char *)&to);
-      }
-      if ((svp = hv_fetch(hv, "drizzle_read_default_file", 23, FALSE)) &&
-          *svp  &&  SvTRUE(*svp))
-      {
-        char* df = SvPV(*svp, lna);
-        drizzleclient_options(con, DRIZZLE_READ_DEFAULT_FILE, df);
-      }
-      if ((svp = hv_fetch(hv, "drizzle_read_default_group", 24,
-                          FALSE))  &&
-          *svp  &&  SvTRUE(*svp)) {
-        char* gr = SvPV(*svp, lna);
+  for (p= values; p < end && isspace(*p); p++)
+    ;
+  if (p == end || *p != '(')
+    return 0;
+  for (row= p; p < end; p++)
+  {
+    if (*p == '`' || *p == '\'' || *p == '"')
+    {
+      if ((p= skip_quoted(p, end)) == end)
+        return 0;
+    }
+    else if (*p == '(')
+      depth++;
+    else if (*p == ')' && --depth == 0)
+      break;
+  }
+  if (p == end)
+    return 0;
+  *row_len= ++p - row;
+  while (p < end && (isspace(*p) || *p == ';'))
+    p++;
+  if (p != end || count_params((char *) row) != count_params(sql))
+    return 0;
+  return row - sql;
+}
 
-        drizzleclient_options(con, DRIZZLE_READ_DEFAULT_GROUP, gr);
-      }
-      if ((svp = hv_fetch(hv,
-                          "drizzle_client_found_rows", 23, FALSE)) && *svp)
-      {
-        if (SvTRUE(*svp))
-          client_flag |= CLIENT_FOUND_ROWS;
-        else
-          client_flag &= ~CLIENT_FOUND_ROWS;
-      }
-      if ((svp = hv_fetch(hv, "drizzle_unbuffered_result", 16, FALSE)) && *svp)
-        imp_dbh->unbuffered_result = SvTRUE(*svp);
-#endif
-      if ((svp = hv_fetch(hv, "drizzle_bind_type_guessing", 26, FALSE)) && *svp)
-      {
-        imp_dbh->bind_type_guessing= SvTRUE(*svp);
-        if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-          PerlIO_printf(DBILOGFP,
-                        "imp_dbh->bind_type_guessing: %d\n",
-                        imp_dbh->bind_type_guessing);
-      }
+/*
+  Sets the drizzle_write_combine limits of imp_sth from value, a hash
+  ref with max_rows and max_bytes, any other true value for the
+  defaults, or a false one to turn combining off
+*/
+static void write_combine_limits(imp_sth_t *imp_sth, SV *value)
+{
+  SV **svp;
+  HV *hv;
 
-#if defined(CLIENT_MULTI_STATEMENTS)
-      if ((svp = hv_fetch(hv, "drizzle_multi_statements", 22, FALSE)) && *svp)
-      {
-        if (SvTRUE(*svp))
-          client_flag |= CLIENT_MULTI_STATEMENTS;
-        else
-          client_flag &= ~CLIENT_MULTI_STATEMENTS;
-      }
-#endif
-      /* HELMUT */
-#if defined FUTURE_FEATURES
-#if defined(sv_utf8_decode)
-      if ((svp = hv_fetch(hv, "drizzle_enable_utf8", 17, FALSE)) && *svp)
-      {
-      }
-#endif
-#endif
+  imp_sth->combine_max_rows= 0;
+  imp_sth->combine_max_bytes= 0;
+  if (!value || !SvTRUE(value))
+    return;
+  if (SvROK(value) && SvTYPE(SvRV(value)) == SVt_PVHV)
+  {
+    hv= (HV*) SvRV(value);
+    if ((svp= hv_fetch(hv, "max_rows", 8, FALSE)) && SvOK(*svp))
+      imp_sth->combine_max_rows= SvUV(*svp);
+    if ((svp= hv_fetch(hv, "max_bytes", 9, FALSE)) && SvOK(*svp))
+      imp_sth->combine_max_bytes= SvUV(*svp);
+  }
+  if (!imp_sth->combine_max_rows)
+    imp_sth->combine_max_rows= WRITE_COMBINE_ROWS;
+  if (!imp_sth->combine_max_bytes)
+    imp_sth->combine_max_bytes= WRITE_COMBINE_BYTES;
+}
 
-#if defined(DBD_DRIZZLE_WITH_SSL) && (defined(CLIENT_SSL))
-      if ((svp = hv_fetch(hv, "drizzle_ssl", 9, FALSE))  &&  *svp)
-      {
-        if (SvTRUE(*svp))
-        {
-          char *client_key = NULL;
-          char *client_cert = NULL;
-          char *ca_file = NULL;
-          char *ca_path = NULL;
-          char *cipher = NULL;
-          STRLEN lna;
-          /*
+static const sql_type_info_t SQL_GET_TYPE_INFO_values[]= {
+  /* 0 */
+  { "varchar",    SQL_VARCHAR,                    255, "'",  "'",  "max length",
+    1, 0, 3, 0, 0, 0, "variable length string",
+    0, 0, 0,
+    SQL_VARCHAR, 0, 0,
+    DRIZZLE_COLUMN_TYPE_VARCHAR,  0,
+  },
+  /* 1 */
+  { "decimal",   SQL_DECIMAL,                      15, NULL, NULL, "precision,scale",
+    1, 0, 3, 0, 0, 0, "double",
+    0, 6, 2,
+    SQL_DECIMAL, 0, 0,
+    DRIZZLE_COLUMN_TYPE_NEWDECIMAL,     1
+  },
+  /* 2 */
+  { "tinyint",   SQL_TINYINT,                       3, NULL, NULL, NULL,
+    1, 0, 3, 0, 0, 0, "Tiny integer",
+    0, 0, 10,
+    SQL_TINYINT, 0, 0,
+    DRIZZLE_COLUMN_TYPE_TINY,     1
+  },
+  /* 3 */
+  { "smallint",  SQL_SMALLINT,                      5, NULL, NULL, NULL,
+    1, 0, 3, 0, 0, 0, "Short integer",
+    0, 0, 10,
+    SQL_SMALLINT, 0, 0,
+    DRIZZLE_COLUMN_TYPE_LONG,     1
+  },
+  /* 4 */
+  { "integer",   SQL_INTEGER,                      5, NULL, NULL, NULL,
+    1, 0, 3, 0, 0, 0, "integer",
+    0, 0, 10,
+    SQL_INTEGER, 0, 0,
+    DRIZZLE_COLUMN_TYPE_LONG,     1
+  },
+  /* 5 */
+  { "float",     SQL_REAL,                          7,  NULL, NULL, NULL,
+    1, 0, 0, 0, 0, 0, "float",
+    0, 2, 10,
+    SQL_FLOAT, 0, 0,
+    DRIZZLE_COLUMN_TYPE_DOUBLE,     1
+  },
+  /* 6 */
+  { "double",    SQL_FLOAT,                       15,  NULL, NULL, NULL,
+    1, 0, 3, 0, 0, 0, "double",
+    0, 4, 2,
+    SQL_FLOAT, 0, 0,
+    DRIZZLE_COLUMN_TYPE_DOUBLE,     1
+  },
+  /* 7 */
+  { "double",    SQL_DOUBLE,                       15,  NULL, NULL, NULL,
+    1, 0, 3, 0, 0, 0, "double",
+    0, 4, 10,
+    SQL_DOUBLE, 0, 0,
+    DRIZZLE_COLUMN_TYPE_DOUBLE,     1
+  },
+  /*
+    DRIZZLE_COLUMN_TYPE_NULL ?
+  */
+  /* 8 */
+  { "timestamp", SQL_TIMESTAMP,                    14, "'", "'", NULL,
+    0, 0, 3, 0, 0, 0, "timestamp",
+    0, 0, 0,
+    SQL_TIMESTAMP, 0, 0,
+    DRIZZLE_COLUMN_TYPE_TIMESTAMP,     0
+  },
+  /* 9 */
+  { "bigint",    SQL_BIGINT,                       19, NULL, NULL, NULL,
+    1, 0, 3, 0, 0, 0, "Longlong integer",
+    0, 0, 10,
+    SQL_BIGINT, 0, 0,
+    DRIZZLE_COLUMN_TYPE_LONGLONG,     1
+  },
+  /* 10 */
+  { "mediumint", SQL_INTEGER,                       8, NULL, NULL, NULL,
+    1, 0, 3, 0, 0, 0, "Medium integer",
+    0, 0, 10,
+    SQL_INTEGER, 0, 0,
+    DRIZZLE_COLUMN_TYPE_LONG,     1
+  },
+  /* 11 */
+  { "time", SQL_TIME, 6, "'",  "'",  NULL,
+    1, 0, 3, 0, 0, 0, "time",
+    0, 0, 0,
+    SQL_TIME, 0, 0,
+    DRIZZLE_COLUMN_TYPE_TIME,     0
+  },
+  /* 12 */
+  { "datetime",  SQL_TIMESTAMP, 21, "'",  "'",  NULL,
+    1, 0, 3, 0, 0, 0, "datetime",
+    0, 0, 0,
+    SQL_TIMESTAMP, 0, 0,
+    DRIZZLE_COLUMN_TYPE_DATETIME,     0
+  },
+  /* 13 */
+  /*{ "date", SQL_DATE, 10, "'",  "'",  NULL,
+    1, 0, 3, 0, 0, 0, "date",
+    0, 0, 0,
+    SQL_DATE, 0, 0,
+    DRIZZLE_COLUMN_TYPE_NEWDATE,     0
+  },
+  */
+  /* 14 */
+  { "enum",      SQL_VARCHAR,                     255, "'",  "'",  NULL,
+    1, 0, 1, 0, 0, 0, "enum(value1,value2,value3...)",
+    0, 0, 0,
+    0, 0, 0,
+    DRIZZLE_COLUMN_TYPE_ENUM,     0
+  },
+  /* 15 */
+  { "blob",       SQL_LONGVARBINARY,              65535, "'",  "'",  NULL,
+    1, 0, 3, 0, 0, 0, "binary large object (0-65535)",
+    0, 0, 0,
+    SQL_LONGVARBINARY, 0, 0,
+    DRIZZLE_COLUMN_TYPE_BLOB,     0
+  },
+  { "tinyblob",  SQL_VARBINARY,                 255, "'",  "'",  NULL,
+    1, 0, 3, 0, 0, 0, "binary large object (0-255) ",
+    0, 0, 0,
+    SQL_VARBINARY, 0, 0,
+    DRIZZLE_COLUMN_TYPE_BLOB,        0
+  },
+  { "mediumblob", SQL_LONGVARBINARY,           16777215, "'",  "'",  NULL,
+    1, 0, 3, 0, 0, 0, "binary large object",
+    0, 0, 0,
+    SQL_LONGVARBINARY, 0, 0,
+    DRIZZLE_COLUMN_TYPE_BLOB, 0
+  },
+  { "longblob",   SQL_LONGVARBINARY,         2147483647, "'",  "'",  NULL,
+    1, 0, 3, 0, 0, 0, "binary large object, use mediumblob instead",
+    0, 0, 0,
+    SQL_LONGVARBINARY, 0, 0,
+    DRIZZLE_COLUMN_TYPE_BLOB,   0
+  },
+  { "char",       SQL_CHAR,                       255, "'",  "'",  "max length",
+    1, 0, 3, 0, 0, 0, "string",
+    0, 0, 0,
+    SQL_CHAR, 0, 0,
+    DRIZZLE_COLUMN_TYPE_VARCHAR,   0
+  },
+
+  { "decimal",            SQL_NUMERIC,            15,  NULL, NULL, "precision,scale",
+    1, 0, 3, 0, 0, 0, "double",
+    0, 6, 2,
+    SQL_NUMERIC, 0, 0,
+    DRIZZLE_COLUMN_TYPE_NEWDECIMAL,   1
+  },
+  { "tinyint unsigned",   SQL_TINYINT,              3, NULL, NULL, NULL,
+    1, 0, 3, 1, 0, 0, "Tiny integer unsigned",
+    0, 0, 10,
+    SQL_TINYINT, 0, 0,
+    DRIZZLE_COLUMN_TYPE_TINY,        1
+  },
+  { "smallint unsigned",  SQL_SMALLINT,             5, NULL, NULL, NULL,
+    1, 0, 3, 1, 0, 0, "Short integer unsigned",
+    0, 0, 10,
+    SQL_SMALLINT, 0, 0,
+    DRIZZLE_COLUMN_TYPE_LONG,       1
+  },
+  { "mediumint unsigned", SQL_INTEGER,              8, NULL, NULL, NULL,
+    1, 0, 3, 1, 0, 0, "Medium integer unsigned",
+    0, 0, 10,
+    SQL_INTEGER, 0, 0,
+    DRIZZLE_COLUMN_TYPE_LONG,       1
+  },
+  { "int unsigned",       SQL_INTEGER,             10, NULL, NULL, NULL,
+    1, 0, 3, 1, 0, 0, "integer unsigned",
+    0, 0, 10,
+    SQL_INTEGER, 0, 0,
+    DRIZZLE_COLUMN_TYPE_LONG,        1
+  },
+  { "int",                SQL_INTEGER,             10, NULL, NULL, NULL,
+    1, 0, 3, 0, 0, 0, "integer",
+    0, 0, 10,
+    SQL_INTEGER, 0, 0,
+    DRIZZLE_COLUMN_TYPE_LONG,        1
+  },
+  { "integer unsigned",   SQL_INTEGER,             10, NULL, NULL, NULL,
+    1, 0, 3, 1, 0, 0, "integer",
+    0, 0, 10,
+    SQL_INTEGER, 0, 0,
+    DRIZZLE_COLUMN_TYPE_LONG,        1
+  },
+  { "bigint unsigned",    SQL_BIGINT,              20, NULL, NULL, NULL,
+    1, 0, 3, 1, 0, 0, "Longlong integer unsigned",
+    0, 0, 10,
+    SQL_BIGINT, 0, 0,
+    DRIZZLE_COLUMN_TYPE_LONGLONG,    1
+  },
+  { "text",               SQL_LONGVARCHAR,      65535, "'",  "'",  NULL,
+    1, 0, 3, 0, 0, 0, "large text object (0-65535)",
+    0, 0, 0,
+    SQL_LONGVARCHAR, 0, 0,
+    DRIZZLE_COLUMN_TYPE_BLOB,        0
+  },
+  { "mediumtext",         SQL_LONGVARCHAR,   16777215, "'",  "'",  NULL,
+    1, 0, 3, 0, 0, 0, "large text object",
+    0, 0, 0,
+    SQL_LONGVARCHAR, 0, 0,
+    DRIZZLE_COLUMN_TYPE_BLOB, 0
+  },
+  { "mediumint unsigned auto_increment", SQL_INTEGER, 8, NULL, NULL, NULL,
+    0, 0, 3, 1, 0, 1, "Medium integer unsigned auto_increment", 0, 0, 10,
+    SQL_INTEGER, 0, 0, DRIZZLE_COLUMN_TYPE_LONG, 1,
+  },
+  { "tinyint unsigned auto_increment", SQL_TINYINT, 3, NULL, NULL, NULL,
+    0, 0, 3, 1, 0, 1, "tinyint unsigned auto_increment", 0, 0, 10,
+    SQL_TINYINT, 0, 0, DRIZZLE_COLUMN_TYPE_TINY, 1
+  },
+
+  { "smallint auto_increment", SQL_SMALLINT, 5, NULL, NULL, NULL,
+    0, 0, 3, 0, 0, 1, "smallint auto_increment", 0, 0, 10,
+    SQL_SMALLINT, 0, 0, DRIZZLE_COLUMN_TYPE_LONG, 1
+  },
+
+  { "int unsigned auto_increment", SQL_INTEGER, 10, NULL, NULL, NULL,
+    0, 0, 3, 1, 0, 1, "integer unsigned auto_increment", 0, 0, 10,
+    SQL_INTEGER, 0, 0, DRIZZLE_COLUMN_TYPE_LONG, 1
+  },
+
+  { "mediumint", SQL_INTEGER, 7, NULL, NULL, NULL,
+    1, 0, 3, 0, 0, 0, "Medium integer", 0, 0, 10,
+    SQL_INTEGER, 0, 0, DRIZZLE_COLUMN_TYPE_LONG, 1
+  },
+
+  { "bit", SQL_BIT, 1, NULL, NULL, NULL,
+    1, 0, 3, 0, 0, 0, "char(1)", 0, 0, 0,
+    SQL_BIT, 0, 0, DRIZZLE_COLUMN_TYPE_LONG, 0
+  },
+
+  { "numeric", SQL_NUMERIC, 19, NULL, NULL, "precision,scale",
+    1, 0, 3, 0, 0, 0, "numeric", 0, 19, 10,
+    SQL_NUMERIC, 0, 0, DRIZZLE_COLUMN_TYPE_NEWDECIMAL, 1,
+  },
+
+  { "integer unsigned auto_increment", SQL_INTEGER, 10, NULL, NULL, NULL,
+    0, 0, 3, 1, 0, 1, "integer unsigned auto_increment", 0, 0, 10,
+    SQL_INTEGER, 0, 0, DRIZZLE_COLUMN_TYPE_LONG, 1,
+  },
+
+  { "mediumint unsigned", SQL_INTEGER, 8, NULL, NULL, NULL,
+    1, 0, 3, 1, 0, 0, "Medium integer unsigned", 0, 0, 10,
+    SQL_INTEGER, 0, 0, DRIZZLE_COLUMN_TYPE_LONG, 1
+  },
+
+  { "smallint unsigned auto_increment", SQL_SMALLINT, 5, NULL, NULL, NULL,
+    0, 0, 3, 1, 0, 1, "smallint unsigned auto_increment", 0, 0, 10,
+    SQL_SMALLINT, 0, 0, DRIZZLE_COLUMN_TYPE_LONG, 1
+  },
+
+  { "int auto_increment", SQL_INTEGER, 10, NULL, NULL, NULL,
+    0, 0, 3, 0, 0, 1, "integer auto_increment", 0, 0, 10,
+    SQL_INTEGER, 0, 0, DRIZZLE_COLUMN_TYPE_LONG, 1
+  },
+
+  { "long varbinary", SQL_LONGVARBINARY, 16777215, "0x", NULL, NULL,
+    1, 0, 3, 0, 0, 0, "mediumblob", 0, 0, 0,
+    SQL_LONGVARBINARY, 0, 0, DRIZZLE_COLUMN_TYPE_BLOB, 0
+  },
+
+  { "double auto_increment", SQL_FLOAT, 15, NULL, NULL, NULL,
+    0, 0, 3, 0, 0, 1, "double auto_increment", 0, 4, 2,
+    SQL_FLOAT, 0, 0, DRIZZLE_COLUMN_TYPE_DOUBLE, 1
+  },
+
+  { "double auto_increment", SQL_DOUBLE, 15, NULL, NULL, NULL,
+    0, 0, 3, 0, 0, 1, "double auto_increment", 0, 4, 10,
+    SQL_DOUBLE, 0, 0, DRIZZLE_COLUMN_TYPE_DOUBLE, 1
+  },
+
+  { "integer auto_increment", SQL_INTEGER, 10, NULL, NULL, NULL,
+    0, 0, 3, 0, 0, 1, "integer auto_increment", 0, 0, 10,
+    SQL_INTEGER, 0, 0, DRIZZLE_COLUMN_TYPE_LONG, 1,
+  },
+
+  { "bigint auto_increment", SQL_BIGINT, 19, NULL, NULL, NULL,
+    0, 0, 3, 0, 0, 1, "bigint auto_increment", 0, 0, 10,
+    SQL_BIGINT, 0, 0, DRIZZLE_COLUMN_TYPE_LONGLONG, 1
+  },
+
+  { "bit auto_increment", SQL_BIT, 1, NULL, NULL, NULL,
+    0, 0, 3, 0, 0, 1, "char(1) auto_increment", 0, 0, 0,
+    SQL_BIT, 0, 0, DRIZZLE_COLUMN_TYPE_TINY, 1
+  },
+
+  { "mediumint auto_increment", SQL_INTEGER, 7, NULL, NULL, NULL,
+    0, 0, 3, 0, 0, 1, "Medium integer auto_increment", 0, 0, 10,
+    SQL_INTEGER, 0, 0, DRIZZLE_COLUMN_TYPE_LONG, 1
+  },
+
+  { "float auto_increment", SQL_REAL, 7, NULL, NULL, NULL,
+    0, 0, 0, 0, 0, 1, "float auto_increment", 0, 2, 10,
+    SQL_FLOAT, 0, 0, DRIZZLE_COLUMN_TYPE_DOUBLE, 1
+  },
+
+  { "long varchar", SQL_LONGVARCHAR, 16777215, "'", "'", NULL,
+    1, 0, 3, 0, 0, 0, "mediumtext", 0, 0, 0,
+    SQL_LONGVARCHAR, 0, 0, DRIZZLE_COLUMN_TYPE_BLOB, 1
+
+  },
+
+  { "tinyint auto_increment", SQL_TINYINT, 3, NULL, NULL, NULL,
+    0, 0, 3, 0, 0, 1, "tinyint auto_increment", 0, 0, 10,
+    SQL_TINYINT, 0, 0, DRIZZLE_COLUMN_TYPE_TINY, 1
+  },
+
+  { "bigint unsigned auto_increment", SQL_BIGINT, 20, NULL, NULL, NULL,
+    0, 0, 3, 1, 0, 1, "bigint unsigned auto_increment", 0, 0, 10,
+    SQL_BIGINT, 0, 0, DRIZZLE_COLUMN_TYPE_LONGLONG, 1
+  },
+
+/* END MORE STUFF */
+};
+
+/*
+  static const sql_type_info_t* native2sql (int t)
+*/
+static const sql_type_info_t *native2sql(int t)
+{
+  switch (t) {
+    case DRIZZLE_COLUMN_TYPE_VARCHAR:  return &SQL_GET_TYPE_INFO_values[0];
+    case DRIZZLE_COLUMN_TYPE_NEWDECIMAL:  return &SQL_GET_TYPE_INFO_values[1];
+    case DRIZZLE_COLUMN_TYPE_TINY:        return &SQL_GET_TYPE_INFO_values[2];
+    case DRIZZLE_COLUMN_TYPE_LONG:        return &SQL_GET_TYPE_INFO_values[4];
+    case DRIZZLE_COLUMN_TYPE_DOUBLE:      return &SQL_GET_TYPE_INFO_values[7];
+    case DRIZZLE_COLUMN_TYPE_TIMESTAMP:   return &SQL_GET_TYPE_INFO_values[8];
+    case DRIZZLE_COLUMN_TYPE_LONGLONG:    return &SQL_GET_TYPE_INFO_values[9];
+    case DRIZZLE_COLUMN_TYPE_TIME:        return &SQL_GET_TYPE_INFO_values[11];
+    case DRIZZLE_COLUMN_TYPE_DATETIME:    return &SQL_GET_TYPE_INFO_values[12];
+                                   /*case DRIZZLE_COLUMN_TYPE_NEWDATE:     return &SQL_GET_TYPE_INFO_values[13];*/
+    case DRIZZLE_COLUMN_TYPE_ENUM:        return &SQL_GET_TYPE_INFO_values[14];
+    case DRIZZLE_COLUMN_TYPE_BLOB:        return &SQL_GET_TYPE_INFO_values[15];
+    default:                     return &SQL_GET_TYPE_INFO_values[0];
+  }
+}
+
+
+#define SQL_GET_TYPE_INFO_num \
+	(sizeof(SQL_GET_TYPE_INFO_values)/sizeof(sql_type_info_t))
+
+
+/***************************************************************************
+ *
+ *  Name:    dbd_init
+ *
+ *  Purpose: Called when the driver is installed by DBI
+ *
+ *  Input:   dbistate - pointer to the DBIS variable, used for some
+ *               DBI internal things
+ *
+ *  Returns: Nothing
+ *
+ **************************************************************************/
+
+void dbd_init(dbistate_t* dbistate)
+{
+    DBIS = dbistate;
+}
+
+
+/**************************************************************************
+ *
+ *  Name:    do_error, do_warn
+ *
+ *  Purpose: Called to associate an error code and an error message
+ *           to some handle
+ *
+ *  Input:   h - the handle in error condition
+ *           rc - the error code
+ *           what - the error message
+ *
+ *  Returns: Nothing
+ *
+ **************************************************************************/
+
+void do_error(SV* h, int rc, const char* what, const char* sqlstate)
+{
+  D_imp_xxh(h);
+  STRLEN lna;
+  SV *errstr;
+  SV *errstate;
+
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBILOGFP, "\t\t--> do_error\n");
+  errstr= DBIc_ERRSTR(imp_xxh);
+  sv_setiv(DBIc_ERR(imp_xxh), (IV)rc);	/* set err early	*/
+  sv_setpv(errstr, what);
+
+  if (sqlstate)
+  {
+    errstate= DBIc_STATE(imp_xxh);
+    sv_setpvn(errstate, sqlstate, 5);
+  }
+
+  /* NO EFFECT DBIh_EVENT2(h, ERROR_event, DBIc_ERR(imp_xxh), errstr); */
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBILOGFP, "%s error %d recorded: %s\n",
+    what, rc, SvPV(errstr,lna));
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBILOGFP, "\t\t<-- do_error\n");
+}
+
+/*
+  void do_warn(SV* h, int rc, char* what)
+*/
+void do_warn(SV* h, int rc, char* what)
+{
+  D_imp_xxh(h);
+  STRLEN lna;
+
+  SV *errstr = DBIc_ERRSTR(imp_xxh);
+  sv_setiv(DBIc_ERR(imp_xxh), (IV)rc);	/* set err early	*/
+  sv_setpv(errstr, what);
+  /* NO EFFECT DBIh_EVENT2(h, WARN_event, DBIc_ERR(imp_xxh), errstr);*/
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBILOGFP, "%s warning %d recorded: %s\n",
+    what, rc, SvPV(errstr,lna));
+  warn("%s", what);
+}
+
+#define DBD_DRIZZLE_NAMESPACE "DBD::drizzle::QUIET";
+
+#define doquietwarn(s) \
+  { \
+    SV* sv = perl_get_sv(DBD_DRIZZLE_NAMESPACE, FALSE);  \
+    if (!sv  ||  !SvTRUE(sv)) { \
+      warn s; \
+    } \
+  }
+
+
+/***************************************************************************
+ *
+ *  Name:    drizzle_dr_connect
+ *
+ *  Purpose: Replacement for drizzle_connect
+ *
+ *  Input:   drizzle_con_st *con - Pointer to a DRIZZLE structure being
+ *             initialized
+ *           char* drizzle_socket - Name of a UNIX socket being used
+ *             or NULL
+ *           char* host - Host name being used or NULL for localhost
+ *           char* port - Port number being used or NULL for default
+ *           char* user - User name being used or NULL
+ *           char* password - Password being used or NULL
+ *           char* dbname - Database name being used or NULL
+ *           char* imp_dbh - Pointer to internal dbh structure
+ *
+ *  Returns: The sock argument for success, NULL otherwise;
+ *           you have to call do_error in the latter case.
+ *
+ **************************************************************************/
+
+int drizzle_dr_connect(
+                            SV* dbh,
+                            drizzle_con_st *con,
+                            char* drizzle_socket,
+                            char* host,
+                            char* port,
+                            char* user,
+                            char* password,
+                            char* dbname,
+                            imp_dbh_t *imp_dbh)
+{
+  int portNr;
+  bool mysql_protocol= false;
+  unsigned int client_flag;
+  drizzle_return_t ret;
+  drizzle_st *drizzle;
+
+  D_imp_xxh(dbh);
+
+  portNr= (port && *port) ? atoi(port) : 0;
+/*
+#ifdef DRIZZLE_NO_CLIENT_FOUND_ROWS
+  client_flag = 0;
+#else
+  client_flag = CLIENT_FOUND_ROWS;
+#endif
+*/
+  drizzle = imp_dbh->drizzle;
+
+  /* too many connects */
+  //drizzle_con_create(drizzle, con);
+
+  if (imp_dbh)
+  {
+    SV* sv = DBIc_IMP_DATA(imp_dbh);
+
+    DBIc_set(imp_dbh, DBIcf_AutoCommit, &sv_yes);
+    if (sv  &&  SvROK(sv))
+    {
+      HV* hv = (HV*) SvRV(sv);
+      SV** svp;
+      STRLEN lna;
+
+      if ((svp = hv_fetch(hv, "drizzle_con_mysql",
+                          strlen("drizzle_con_mysql"), FALSE))  &&
+          *svp && SvTRUE(*svp))
+      {
+        mysql_protocol= true;
+      }
+#if defined FUTURE_FEATURES
+      if ((svp = hv_fetch(hv, "drizzle_compression", 17, FALSE))  &&
+          *svp && SvTRUE(*svp))
+      {
+        drizzle_con_set_options(con, DRIZZLE_OPT_COMPRESS, NULL);
+      }
+      if ((svp = hv_fetch(hv, "drizzle_connect_timeout", 21, FALSE))
+          &&  *svp  &&  SvTRUE(*svp))
+      {
+        int to = SvIV(*svp);
+        drizzleclient_options(con, DRIZZLE_OPT_CONNECT_TIMEOUT,
+                        (const char *)&to);
+      }
+      if ((svp = hv_fetch(hv, "drizzle_read_default_file", 23, FALSE)) &&
+          *svp  &&  SvTRUE(*svp))
+      {
+        char* df = SvPV(*svp, lna);
+        drizzleclient_options(con, DRIZZLE_READ_DEFAULT_FILE, df);
+      }
+      if ((svp = hv_fetch(hv, "drizzle_read_default_group", 24,
+                          FALSE))  &&
+          *svp  &&  SvTRUE(*svp)) {
+        char* gr = SvPV(*svp, lna);
+
+        drizzleclient_options(con, DRIZZLE_READ_DEFAULT_GROUP, gr);
+      }
+      if ((svp = hv_fetch(hv,
+                          "drizzle_client_found_rows", 23, FALSE)) && *svp)
+      {
+        if (SvTRUE(*svp))
+          client_flag |= CLIENT_FOUND_ROWS;
+        else
+          client_flag &= ~CLIENT_FOUND_ROWS;
+      }
+      if ((svp = hv_fetch(hv, "drizzle_unbuffered_result", 16, FALSE)) && *svp)
+        imp_dbh->unbuffered_result = SvTRUE(*svp);
+#endif
+      if ((svp = hv_fetch(hv, "drizzle_bind_type_guessing", 26, FALSE)) && *svp)
+      {
+        imp_dbh->bind_type_guessing= SvTRUE(*svp);
+        if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+          PerlIO_printf(DBILOGFP,
+                        "imp_dbh->bind_type_guessing: %d\n",
+                        imp_dbh->bind_type_guessing);
+      }
+      if ((svp = hv_fetch(hv, "drizzle_max_result_bytes", 24, FALSE)) && *svp)
+        imp_dbh->max_result_bytes= SvOK(*svp) ? SvUV(*svp) : 0;
+      if ((svp = hv_fetch(hv, "drizzle_max_result_action", 25, FALSE)) && *svp)
+        imp_dbh->max_result_action= result_cap_action(*svp);
+      if ((svp = hv_fetch(hv, "drizzle_compact_rows", 20, FALSE)) && *svp)
+        imp_dbh->compact_rows= SvTRUE(*svp);
+      if ((svp = hv_fetch(hv, "drizzle_release_fetched", 23, FALSE)) && *svp)
+        imp_dbh->release_fetched= SvTRUE(*svp);
+      if ((svp = hv_fetch(hv, "drizzle_lazy_columns", 20, FALSE)) && *svp)
+        imp_dbh->lazy_columns= SvTRUE(*svp);
+      if ((svp = hv_fetch(hv, "drizzle_cancel_threshold", 24, FALSE)) && *svp)
+        imp_dbh->cancel_threshold= SvOK(*svp) ? SvUV(*svp) : 0;
+      if ((svp = hv_fetch(hv, "drizzle_max_packet_size", 23, FALSE)) && *svp
+          && SvTRUE(*svp))
+        imp_dbh->max_packet_size= SvUV(*svp);
+      if ((svp = hv_fetch(hv, "drizzle_query_timeout", 21, FALSE)) && *svp)
+        imp_dbh->query_timeout= SvOK(*svp) ? SvUV(*svp) : 0;
+      if ((svp = hv_fetch(hv, "drizzle_in_chunk", 16, FALSE)) && *svp)
+        imp_dbh->in_chunk= SvOK(*svp) ? SvUV(*svp) : 0;
+      if ((svp = hv_fetch(hv, "drizzle_aux_connections", 23, FALSE)) && *svp)
+      {
+        imp_dbh->aux_connections= SvIV(*svp);
+        if (imp_dbh->aux_connections < 0)
+          imp_dbh->aux_connections= 0;
+        else if (imp_dbh->aux_connections > MAX_AUX_CONNECTIONS)
+          imp_dbh->aux_connections= MAX_AUX_CONNECTIONS;
+      }
+
+#if defined(CLIENT_MULTI_STATEMENTS)
+      if ((svp = hv_fetch(hv, "drizzle_multi_statements", 22, FALSE)) && *svp)
+      {
+        if (SvTRUE(*svp))
+          client_flag |= CLIENT_MULTI_STATEMENTS;
+        else
+          client_flag &= ~CLIENT_MULTI_STATEMENTS;
+      }
+#endif
+      /* HELMUT */
+#if defined FUTURE_FEATURES
+#if defined(sv_utf8_decode)
+      if ((svp = hv_fetch(hv, "drizzle_enable_utf8", 17, FALSE)) && *svp)
+      {
+      }
+#endif
+#endif
+
+#if defined(DBD_DRIZZLE_WITH_SSL) && (defined(CLIENT_SSL))
+      if ((svp = hv_fetch(hv, "drizzle_ssl", 9, FALSE))  &&  *svp)
+      {
+        if (SvTRUE(*svp))
+        {
+          char *client_key = NULL;
+          char *client_cert = NULL;
+          char *ca_file = NULL;
+          char *ca_path = NULL;
+          char *cipher = NULL;
+          STRLEN lna;
+          /*
             New code to utilise MySQLs new feature that verifies that the
             server's hostname that the client connects to matches that of
             the certificate
@@ -994,1284 +1721,5073 @@ int drizzle_dr_connect(
                               28, FALSE)) &&  *svp)
             ssl_verify_true = SvTRUE(*svp);
 
-          if ((svp = hv_fetch(hv, "drizzle_ssl_client_key", 20, FALSE)) && *svp)
-            client_key = SvPV(*svp, lna);
+          if ((svp = hv_fetch(hv, "drizzle_ssl_client_key", 20, FALSE)) && *svp)
+            client_key = SvPV(*svp, lna);
+
+          if ((svp = hv_fetch(hv, "drizzle_ssl_client_cert", 21, FALSE)) &&
+              *svp)
+            client_cert = SvPV(*svp, lna);
+
+          if ((svp = hv_fetch(hv, "drizzle_ssl_ca_file", 17, FALSE)) &&
+              *svp)
+            ca_file = SvPV(*svp, lna);
+
+          if ((svp = hv_fetch(hv, "drizzle_ssl_ca_path", 17, FALSE)) &&
+              *svp)
+            ca_path = SvPV(*svp, lna);
+
+          if ((svp = hv_fetch(hv, "drizzle_ssl_cipher", 16, FALSE)) &&
+              *svp)
+            cipher = SvPV(*svp, lna);
+
+          drizzleclient_ssl_set(con, client_key, client_cert, ca_file,
+                          ca_path, cipher);
+
+          drizzleclient_options(con,
+                          DRIZZLE_OPT_SSL_VERIFY_SERVER_CERT,
+                          &ssl_verify_true);
+
+          client_flag |= CLIENT_SSL;
+        }
+      }
+#endif
+    }
+  }
+
+  //client_flag|= CLIENT_MULTI_RESULTS;
+  // XXX not sure about this logic...
+  if (imp_dbh->con != NULL)
+  {
+    imp_dbh->con= drizzle_con_add_tcp(drizzle, NULL, host, portNr,
+                                      user, password, dbname,
+                                      mysql_protocol ?
+                                        DRIZZLE_CON_MYSQL : DRIZZLE_CON_NONE);
+  }
+  ret = drizzle_con_connect(imp_dbh->con);
+
+  /* XXX Until we understand this better.. commented out
+  if (result)
+  {
+    /
+      we turn off Mysql's auto reconnect and handle re-connecting ourselves
+      so that we can keep track of when this happens.
+    * 
+    result->reconnect=0;
+  }
+  */
+  return ret == DRIZZLE_RETURN_OK ? TRUE : FALSE;
+}
+
+/*
+  safe_hv_fetch
+*/
+char *safe_hv_fetch(HV *hv, const char *name, int name_length)
+{
+  SV** svp;
+  STRLEN len;
+  char *res= NULL;
+
+  if ((svp= hv_fetch(hv, name, name_length, FALSE)))
+  {
+    res= SvPV(*svp, len);
+    if (!len)
+      res= NULL;
+  }
+  return res;
+}
+
+/*
+ Frontend for drizzle_dr_connect
+*/
+int my_login(SV* dbh, imp_dbh_t *imp_dbh)
+{
+  SV* sv;
+  HV* hv;
+  char* dbname;
+  char* host;
+  char* port;
+  char* user;
+  char* password;
+  char* drizzle_socket;
+  D_imp_xxh(dbh);
+
+#define TAKE_IMP_DATA_VERSION 1
+#if TAKE_IMP_DATA_VERSION
+  if (DBIc_has(imp_dbh, DBIcf_IMPSET))
+  { /* eg from take_imp_data() */
+    if (DBIc_has(imp_dbh, DBIcf_ACTIVE))
+    {
+      if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+        PerlIO_printf(DBILOGFP, "my_login skip connect\n");
+      /* tell our parent we've adopted an active child */
+      ++DBIc_ACTIVE_KIDS(DBIc_PARENT_COM(imp_dbh));
+      return TRUE;
+    }
+    if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+      PerlIO_printf(DBILOGFP,
+                    "my_login IMPSET but not ACTIVE so connect not skipped\n");
+  }
+#endif
+
+  sv = DBIc_IMP_DATA(imp_dbh);
+
+  if (!sv  ||  !SvROK(sv))
+    return FALSE;
+
+  hv = (HV*) SvRV(sv);
+  if (SvTYPE(hv) != SVt_PVHV)
+    return FALSE;
+
+  host=		safe_hv_fetch(hv, "host", 4);
+  port=		safe_hv_fetch(hv, "port", 4);
+  user=		safe_hv_fetch(hv, "user", 4);
+  password=	safe_hv_fetch(hv, "password", 8);
+  dbname=	safe_hv_fetch(hv, "database", 8);
+  drizzle_socket=	safe_hv_fetch(hv, "drizzle_socket", 14);
+
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBILOGFP,
+		  "imp_dbh->my_login : dbname = %s, uid = %s, pwd = %s," \
+		  "host = %s, port = %s\n",
+		  dbname ? dbname : "NULL",
+		  user ? user : "NULL",
+		  password ? password : "NULL",
+		  host ? host : "NULL",
+		  port ? port : "NULL");
+
+  if (!imp_dbh->con) {
+     Newz(908, imp_dbh->con, 1, drizzle_con_st);
+  }
+  return drizzle_dr_connect(
+                                         dbh,
+                                         imp_dbh->con,
+                                         drizzle_socket,
+                                         host,
+                                         port,
+                                         user,
+                                         password,
+                                         dbname,
+                                         imp_dbh);
+}
+
+
+/**************************************************************************
+ *
+ *  Name:    dbd_db_login6
+ *
+ *  Purpose: Called for connecting to a database and logging in.
+ *
+ *  Input:   dbh - database handle being initialized
+ *           imp_dbh - drivers private database handle data
+ *           dbname - the database we want to log into; may be like
+ *               "dbname:host" or "dbname:host:port"
+ *           user - user name to connect as
+ *           password - passwort to connect with
+ *           attr - the attributes like AutoCommit and RaiseError
+ *
+ *  Returns: TRUE for success, FALSE otherwise; do_error has already
+ *           been called in the latter case
+ *
+ **************************************************************************/
+
+int dbd_db_login6(SV* dbh, imp_dbh_t* imp_dbh, char* dbname, char* user,
+                 char* password, SV* attr) {
+#ifdef dTHR
+  dTHR;
+#endif
+  D_imp_xxh(dbh);
+
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBILOGFP,
+                  "imp_dbh->connect: dsn = %s, uid = %s, pwd = %s\n",
+                  dbname ? dbname : "NULL",
+                  user ? user : "NULL",
+                  password ? password : "NULL");
+
+  // TODO: use drizzle_con_ready()
+  imp_dbh->drizzle= &imp_dbh->_drizzle;
+  (void) drizzle_create(imp_dbh->drizzle);
+  /* let's check return value ? */
+
+    imp_dbh->con= NULL;
+  /*imp_dbh->con= drizzle_con_create(imp_dbh->drizzle, NULL);
+  if (imp_dbh->con == NULL) {
+    do_error(dbh, drizzle_errno(imp_dbh->drizzle), drizzle_error(imp_dbh->drizzle),
+             drizzle_sqlstate(imp_dbh->drizzle));
+    return FALSE;
+    }*/
+
+  imp_dbh->stats.auto_reconnects_ok= 0;
+  imp_dbh->stats.auto_reconnects_failed= 0;
+  imp_dbh->stats.result_bytes= 0;
+  imp_dbh->stats.result_streams= 0;
+  imp_dbh->stats.result_spills= 0;
+  imp_dbh->bind_type_guessing= FALSE;
+  imp_dbh->max_result_bytes= 0;
+  imp_dbh->max_result_action= RESULT_CAP_ERROR;
+  imp_dbh->compact_rows= FALSE;
+  imp_dbh->release_fetched= FALSE;
+  imp_dbh->lazy_columns= FALSE;
+  imp_dbh->in_chunk= 0;
+  imp_dbh->cancel_threshold= 0;
+  imp_dbh->query_timeout= 0;
+  imp_dbh->max_packet_size= DEFAULT_MAX_PACKET_SIZE;
+  imp_dbh->stats.queries_killed= 0;
+  imp_dbh->con_owner= NULL;
+  imp_dbh->combine_owner= NULL;
+  imp_dbh->aux_connections= 0;
+  imp_dbh->aux_count= 0;
+  imp_dbh->session_log= NULL;
+  imp_dbh->session_log_full= FALSE;
+  imp_dbh->con_synced= 0;
+  imp_dbh->stats.aux_connects= 0;
+  /* Safer we flip this to TRUE perl side if we detect a mod_perl env. */
+  imp_dbh->auto_reconnect = FALSE;
+  imp_dbh->insert_id=0;
+
+  /* HELMUT */
+#if defined(sv_utf8_decode)
+  imp_dbh->enable_utf8 = FALSE;  /* initialize drizzle_enable_utf8 */
+  imp_dbh->utf8_generation= 0;
+#endif
+
+  if (!my_login(dbh, imp_dbh))
+  {
+    do_error(dbh, drizzle_con_errno(imp_dbh->con),
+             drizzle_con_error(imp_dbh->con) ,drizzle_con_sqlstate(imp_dbh->con));
+    return FALSE;
+  }
+
+  /*
+   *  Tell DBI, that dbh->disconnect should be called for this handle
+ */
+  DBIc_ACTIVE_on(imp_dbh);
+
+  /* Tell DBI, that dbh->destroy should be called for this handle */
+  DBIc_on(imp_dbh, DBIcf_IMPSET);
+
+  return TRUE;
+}
+
+
+/***************************************************************************
+ *
+ *  Session state
+ *
+ *  Auxiliary connections are cloned from the settings given at connect
+ *  time. So that they see the schema and session variables of the main
+ *  connection, the USE and SET statements run on the dbh while there are
+ *  or may be auxiliary connections are kept in session_log, and each
+ *  connection records how many of them it has run.
+ *  drizzle_db_sync_con() runs the missing ones before a connection is
+ *  used, on a new auxiliary connection as well as on the main one when
+ *  a statement ran on an auxiliary connection first.
+ *
+ **************************************************************************/
+
+/*
+  Whether the len bytes at sql are a USE or SET statement. SET TRANSACTION
+  only applies to the next transaction of the connection it ran on.
+*/
+static bool is_session_statement(const char *sql, STRLEN len)
+{
+  const char *end= sql + len;
+
+  while (sql < end && isspace((unsigned char) *sql))
+    sql++;
+  if (end - sql > 3 && !strncasecmp(sql, "use", 3) &&
+      isspace((unsigned char) sql[3]))
+    return TRUE;
+  if (end - sql <= 3 || strncasecmp(sql, "set", 3) ||
+      !isspace((unsigned char) sql[3]))
+    return FALSE;
+  for (sql+= 3; sql < end && isspace((unsigned char) *sql); sql++)
+    ;
+  return !(end - sql >= 11 && !strncasecmp(sql, "transaction", 11));
+}
+
+/*
+  The count of session_log entries run on con, NULL if con is not one of
+  the connections of imp_dbh
+*/
+static I32 *drizzle_db_con_synced(imp_dbh_t *imp_dbh, drizzle_con_st *con)
+{
+  int i;
+
+  if (con == imp_dbh->con)
+    return &imp_dbh->con_synced;
+  for (i= 0; i < imp_dbh->aux_count; i++)
+    if (imp_dbh->aux_con[i] == con)
+      return &imp_dbh->aux_synced[i];
+  return NULL;
+}
+
+/*
+  Runs the session_log entries con has not run yet on it. Returns FALSE
+  if one failed; the error is that of con.
+*/
+static bool drizzle_db_sync_con(imp_dbh_t *imp_dbh, drizzle_con_st *con)
+{
+  I32 *synced= drizzle_db_con_synced(imp_dbh, con);
+  drizzle_result_st *result;
+  drizzle_return_t ret;
+  STRLEN len;
+  char *sql;
+
+  if (!synced || !imp_dbh->session_log)
+    return TRUE;
+  while (*synced <= av_len(imp_dbh->session_log))
+  {
+    sql= SvPV(AvARRAY(imp_dbh->session_log)[*synced], len);
+    result= drizzle_query(con, NULL, sql, len, &ret);
+    if (ret == DRIZZLE_RETURN_OK)
+      ret= drizzle_result_buffer(result);
+    if (result)
+      drizzle_result_free(result);
+    if (ret != DRIZZLE_RETURN_OK)
+      return FALSE;
+    (*synced)++;
+  }
+  return TRUE;
+}
+
+/*
+  Records a USE or SET statement that ran on con, while there are or may
+  be auxiliary connections to run it on
+*/
+static void drizzle_db_log_session(imp_dbh_t *imp_dbh, drizzle_con_st *con,
+                                   const char *sql, STRLEN len)
+{
+  I32 *synced= drizzle_db_con_synced(imp_dbh, con);
+
+  if (!imp_dbh->aux_connections && !imp_dbh->aux_count)
+    return;
+  if (!imp_dbh->session_log)
+    imp_dbh->session_log= newAV();
+  if (!imp_dbh->session_log_full &&
+      av_len(imp_dbh->session_log) + 1 >= MAX_SESSION_LOG)
+  {
+    imp_dbh->session_log_full= TRUE;
+    if (DBIc_TRACE_LEVEL(imp_dbh) >= 2)
+      PerlIO_printf(DBILOGFP, "\t\tsession log full, no longer using"
+                    " auxiliary connections\n");
+    if (DBIc_WARN(imp_dbh))
+      warn("More than %d USE and SET statements, no longer using"
+           " drizzle_aux_connections", MAX_SESSION_LOG);
+  }
+  /* Once full, the main connection still needs what ran elsewhere */
+  if (imp_dbh->session_log_full && con == imp_dbh->con)
+    return;
+  av_push(imp_dbh->session_log, newSVpvn(sql, len));
+  if (synced)
+    *synced= av_len(imp_dbh->session_log) + 1;
+}
+
+
+/***************************************************************************
+ *
+ *  Name:    drizzle_db_pick_con
+ *
+ *  Purpose: Returns the connection a new command should be sent on. That
+ *           is imp_dbh->con, unless another statement still streams an
+ *           unbuffered result on it; with drizzle_aux_connections and
+ *           AutoCommit on, an idle auxiliary connection is used then, or
+ *           a new one is cloned from imp_dbh->con. Nothing is routed
+ *           once session_log is full.
+ *
+ *  Input:   h - handle, for warnings
+ *           imp_dbh - drivers private database handle data
+ *           imp_sth - the statement about to execute, NULL for do()
+ *
+ *  Returns: The connection to use
+ *
+ **************************************************************************/
+drizzle_con_st *drizzle_db_pick_con(SV *h, imp_dbh_t *imp_dbh,
+                                    imp_sth_t *imp_sth)
+{
+  drizzle_con_st *con;
+  int i;
+
+  if (!imp_dbh->con_owner || imp_dbh->con_owner == imp_sth ||
+      !imp_dbh->aux_connections || imp_dbh->session_log_full ||
+      !DBIc_has(imp_dbh, DBIcf_AutoCommit))
+    return imp_dbh->con;
+
+  for (i= 0; i < imp_dbh->aux_count; i++)
+    if (!imp_dbh->aux_owner[i] || imp_dbh->aux_owner[i] == imp_sth)
+      return imp_dbh->aux_con[i];
+
+  return (con= drizzle_db_open_aux(h, imp_dbh)) ? con : imp_dbh->con;
+}
+
+/*
+  Opens another auxiliary connection, within drizzle_aux_connections.
+  Returns NULL if there may be no more or connecting failed.
+*/
+drizzle_con_st *drizzle_db_open_aux(SV *h, imp_dbh_t *imp_dbh)
+{
+  D_imp_xxh(h);
+  drizzle_con_st *con;
+  drizzle_return_t ret;
+
+  if (imp_dbh->aux_count >= imp_dbh->aux_connections ||
+      imp_dbh->session_log_full)
+    return NULL;
+
+  /* Same host, credentials, schema and protocol as the main connection */
+  if (!(con= drizzle_con_clone(imp_dbh->drizzle, NULL, imp_dbh->con)))
+    return NULL;
+  if ((ret= drizzle_con_connect(con)) != DRIZZLE_RETURN_OK)
+  {
+    do_warn(h, drizzle_con_errno(con), (char *) drizzle_con_error(con));
+    drizzle_con_free(con);
+    return NULL;
+  }
+
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBILOGFP, "\t\topened auxiliary connection %d\n",
+                  imp_dbh->aux_count);
+
+  imp_dbh->aux_con[imp_dbh->aux_count]= con;
+  imp_dbh->aux_owner[imp_dbh->aux_count]= NULL;
+  imp_dbh->aux_synced[imp_dbh->aux_count]= 0;
+  if (!drizzle_db_sync_con(imp_dbh, con))
+  {
+    do_warn(h, drizzle_con_errno(con), (char *) drizzle_con_error(con));
+    drizzle_con_close(con);
+    drizzle_con_free(con);
+    imp_dbh->aux_con[imp_dbh->aux_count]= NULL;
+    return NULL;
+  }
+  imp_dbh->stats.aux_connects++;
+  return imp_dbh->aux_con[imp_dbh->aux_count++];
+}
+
+/*
+  Records imp_sth as the statement streaming a result on con, or with
+  imp_sth NULL, that owner as done
+*/
+static void drizzle_db_own_con(imp_dbh_t *imp_dbh, drizzle_con_st *con,
+                               imp_sth_t *owner, imp_sth_t *imp_sth)
+{
+  int i;
+
+  if (con == imp_dbh->con)
+  {
+    if (imp_dbh->con_owner == owner)
+      imp_dbh->con_owner= imp_sth;
+    return;
+  }
+  for (i= 0; i < imp_dbh->aux_count; i++)
+    if (imp_dbh->aux_con[i] == con && imp_dbh->aux_owner[i] == owner)
+      imp_dbh->aux_owner[i]= imp_sth;
+}
+
+/*
+  Closes and frees the auxiliary connections
+*/
+static void drizzle_db_free_aux(imp_dbh_t *imp_dbh)
+{
+  int i;
+
+  for (i= 0; i < imp_dbh->aux_count; i++)
+  {
+    drizzle_con_close(imp_dbh->aux_con[i]);
+    drizzle_con_free(imp_dbh->aux_con[i]);
+    imp_dbh->aux_con[i]= NULL;
+    imp_dbh->aux_owner[i]= NULL;
+  }
+  imp_dbh->aux_count= 0;
+  imp_dbh->con_owner= NULL;
+}
+
+/***************************************************************************
+ *
+ *  Name:    drizzle_db_kill_query
+ *
+ *  Purpose: Stops the query running on con by sending KILL QUERY over a
+ *           short lived connection cloned from it. con itself is busy,
+ *           so this is the only way to reach the server.
+ *
+ *  Input:   h - handle, for warnings
+ *           imp_dbh - drivers private database handle data
+ *           con - connection running the query
+ *
+ *  Returns: TRUE if the server accepted the KILL, FALSE otherwise
+ *
+ **************************************************************************/
+static int drizzle_db_kill_query(SV *h, imp_dbh_t *imp_dbh,
+                                 drizzle_con_st *con)
+{
+  D_imp_xxh(h);
+  drizzle_con_st *side;
+  drizzle_result_st result;
+  drizzle_return_t ret;
+  char query[48];
+
+  if (!(side= drizzle_con_clone(imp_dbh->drizzle, NULL, con)))
+    return FALSE;
+
+  sprintf(query, "KILL QUERY %u", (unsigned int) drizzle_con_thread_id(con));
+  if ((ret= drizzle_con_connect(side)) == DRIZZLE_RETURN_OK)
+  {
+    (void) drizzle_query_str(side, &result, query, &ret);
+    drizzle_result_free(&result);
+  }
+  if (ret != DRIZZLE_RETURN_OK)
+    do_warn(h, drizzle_con_errno(side), (char *) drizzle_con_error(side));
+  else
+    imp_dbh->stats.queries_killed++;
+
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBILOGFP, "\t\t%s: %s\n", query,
+                  ret == DRIZZLE_RETURN_OK ? "ok" : drizzle_con_error(side));
+
+  drizzle_con_close(side);
+  drizzle_con_free(side);
+  return ret == DRIZZLE_RETURN_OK;
+}
+
+/***************************************************************************
+ *
+ *  Query timeouts
+ *
+ *  With drizzle_query_timeout, calls that may block on the server are
+ *  made with DRIZZLE_NON_BLOCKING set. Whenever one of them returns
+ *  DRIZZLE_RETURN_IO_WAIT, drizzle_wait_until() waits for the connection
+ *  no longer than what is left until the deadline, and the call is
+ *  repeated; libdrizzle picks up where it left off. Once the deadline has
+ *  passed, the query is killed and the caller finishes the call blocking,
+ *  which brings the connection back in sync. The timeout of the
+ *  drizzle_st is only changed for the wait itself, so blocking calls made
+ *  afterwards, like finishing the call, are not cut short.
+ *
+ **************************************************************************/
+static double drizzle_deadline(unsigned long timeout)
+{
+#ifdef HAS_GETTIMEOFDAY
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1000000.0 + timeout / 1000.0;
+#else
+  return time(NULL) + (timeout + 999) / 1000;
+#endif
+}
+
+static drizzle_return_t drizzle_wait_until(imp_dbh_t *imp_dbh,
+                                           double deadline)
+{
+  double left= deadline - drizzle_deadline(0);
+  drizzle_return_t ret;
+  int saved;
+
+  if (left <= 0)
+    return DRIZZLE_RETURN_TIMEOUT;
+  saved= drizzle_timeout(imp_dbh->drizzle);
+  drizzle_set_timeout(imp_dbh->drizzle, (int) (left * 1000) + 1);
+  ret= drizzle_con_wait(imp_dbh->drizzle);
+  drizzle_set_timeout(imp_dbh->drizzle, saved);
+  return ret;
+}
+
+static void drizzle_timed_out(SV *h, imp_dbh_t *imp_dbh, drizzle_con_st *con,
+                              unsigned long timeout)
+{
+  char msg[80];
+
+  drizzle_remove_options(imp_dbh->drizzle, DRIZZLE_NON_BLOCKING);
+  (void) drizzle_db_kill_query(h, imp_dbh, con);
+  sprintf(msg, "Query exceeded drizzle_query_timeout of %lu ms", timeout);
+  do_error(h, JW_ERR_QUERY_TIMEOUT, msg, "HYT00");
+}
+
+/*
+  After a timeout, checks ret of finishing the call that timed out. An
+  error from the server, as the killed query sends, leaves con in sync;
+  anything else means con is not, and it is closed.
+*/
+static void drizzle_timed_out_finish(SV *h, drizzle_con_st *con,
+                                     drizzle_return_t ret)
+{
+  if (ret == DRIZZLE_RETURN_OK || ret == DRIZZLE_RETURN_ERROR_CODE)
+    return;
+  do_warn(h, drizzle_con_errno(con), (char *) drizzle_con_error(con));
+  drizzle_con_close(con);
+}
+
+
+/***************************************************************************
+ *
+ *  Name:    drizzle_db_flush_combined
+ *
+ *  Purpose: Sends the rows a statement with drizzle_write_combine has
+ *           collected as one multi-row INSERT. There is at most one such
+ *           statement per dbh, as anything else run on the dbh flushes
+ *           it first. An error is reported on h together with the range
+ *           of execute calls whose rows were lost.
+ *
+ *  Input:   h - handle, for error messages
+ *           imp_dbh - drivers private database handle data
+ *
+ *  Returns: TRUE for success, FALSE otherwise; do_error has already
+ *           been called in the latter case
+ *
+ **************************************************************************/
+int drizzle_db_flush_combined(SV *h, imp_dbh_t *imp_dbh)
+{
+  D_imp_xxh(h);
+  imp_sth_t *imp_sth= imp_dbh->combine_owner;
+  drizzle_result_st *result= NULL;
+  unsigned long first, last;
+  uint64_t rows;
+  SV *msg;
+
+  if (!imp_sth)
+    return TRUE;
+  imp_dbh->combine_owner= NULL;
+  first= imp_sth->combine_first;
+  last= first + imp_sth->combine_rows - 1;
+  imp_sth->combine_rows= 0;
+
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBILOGFP, "\t\tflushing execute calls %lu..%lu\n",
+                  first, last);
+
+  rows= drizzle_st_internal_execute(h, imp_sth->combine_buf, NULL, 0, NULL,
+                                    &result, imp_dbh->con, FALSE);
+  if (result)
+  {
+    if (rows != (uint64_t) -2)
+      imp_dbh->insert_id= drizzle_result_insert_id(result);
+    drizzle_result_free(result);
+  }
+  if (rows != (uint64_t) -2)
+    return TRUE;
+
+  msg= sv_2mortal(newSVpvf("Combined INSERT of execute calls %lu to %lu "
+                           "failed: %s", first, last,
+                           SvPV_nolen(DBIc_ERRSTR(imp_xxh))));
+  do_error(h, SvIV(DBIc_ERR(imp_xxh)), SvPVX(msg), NULL);
+  return FALSE;
+}
+
+/*
+  Forgets combined rows, for rollback and disconnect
+*/
+static void drizzle_db_discard_combined(imp_dbh_t *imp_dbh)
+{
+  if (imp_dbh->combine_owner)
+    imp_dbh->combine_owner->combine_rows= 0;
+  imp_dbh->combine_owner= NULL;
+}
+
+
+/*
+  Runs one statement built by a bulk method, returning the number of
+  affected rows or -2
+*/
+static IV drizzle_db_run_bulk(SV *dbh, imp_dbh_t *imp_dbh, SV *sql)
+{
+  drizzle_result_st *result= NULL;
+  uint64_t rows;
+
+  rows= drizzle_st_internal_execute(dbh, sql, NULL, 0, NULL, &result,
+                                    drizzle_db_pick_con(dbh, imp_dbh, NULL),
+                                    FALSE);
+  if (result)
+    drizzle_result_free(result);
+  return rows == (uint64_t) -2 ? -2 : (IV) rows;
+}
+
+/*
+  Upper bound of the bytes sv_cat_literal() appends for value
+*/
+static STRLEN literal_size(SV *value)
+{
+  STRLEN len;
+
+  if (!value || !SvOK(value))
+    return 4;
+  (void) SvPV(value, len);
+  return 2*len + 3;
+}
+
+/*
+  Builds the UPDATE of drizzle_db_bulk_update() for the n hash entries
+  in chunk
+*/
+static void bulk_update_sql(SV *sql, imp_dbh_t *imp_dbh, char *table,
+                            char *key_col, AV *columns, HE **chunk, I32 n)
+{
+  bool guess= imp_dbh->bind_type_guessing;
+  bool first= TRUE, any;
+  SV **svp;
+  STRLEN len;
+  char *col;
+  I32 c, i;
+
+  sv_setpvf(sql, "UPDATE %s SET ", table);
+  for (c= 0; c <= av_len(columns); c++)
+  {
+    col= SvPV(*av_fetch(columns, c, FALSE), len);
+    any= FALSE;
+    for (i= 0; i < n; i++)
+    {
+      if (!(svp= hv_fetch((HV*) SvRV(HeVAL(chunk[i])), col, len, FALSE)))
+        continue;
+      if (!any)
+      {
+        sv_catpvf(sql, "%s%s = CASE %s", first ? "" : ", ", col, key_col);
+        first= FALSE;
+        any= TRUE;
+      }
+      sv_catpvn(sql, " WHEN ", 6);
+      sv_cat_literal(sql, hv_iterkeysv(chunk[i]), guess);
+      sv_catpvn(sql, " THEN ", 6);
+      sv_cat_literal(sql, *svp, guess);
+    }
+    if (any)
+      sv_catpvf(sql, " ELSE %s END", col);
+  }
+
+  sv_catpvf(sql, " WHERE %s IN (", key_col);
+  for (i= 0; i < n; i++)
+  {
+    if (i)
+      sv_catpvn(sql, ",", 1);
+    sv_cat_literal(sql, hv_iterkeysv(chunk[i]), guess);
+  }
+  sv_catpvn(sql, ")", 1);
+}
+
+/***************************************************************************
+ *
+ *  Name:    drizzle_db_bulk_update
+ *
+ *  Purpose: Updates many rows by key in a few statements of the form
+ *
+ *             UPDATE table SET c = CASE key WHEN k1 THEN v1 ... ELSE c END,
+ *               ... WHERE key IN (k1, ...)
+ *
+ *           each kept below drizzle_max_packet_size. A column is only
+ *           changed for the keys whose hash has it.
+ *
+ *  Input:   dbh - database handle
+ *           imp_dbh - drivers private database handle data
+ *           table, key_col - used as given, quote them if needed
+ *           rows - hash ref of key => { column => value }
+ *
+ *  Returns: The number of rows affected, or -2 after do_error
+ *
+ **************************************************************************/
+IV drizzle_db_bulk_update(SV *dbh, imp_dbh_t *imp_dbh, char *table,
+                          char *key_col, SV *rows)
+{
+  HV *hv, *row, *seen;
+  AV *columns;
+  HE *he, *entry, **chunk;
+  SV *sql;
+  I32 keys, n= 0;
+  STRLEN size= 0, need= 0, fixed, len;
+  IV total= 0, affected;
+  char *col;
+
+  if (!SvROK(rows) || SvTYPE(SvRV(rows)) != SVt_PVHV)
+  {
+    do_error(dbh, JW_ERR_ARGUMENT,
+             "drizzle_bulk_update expects a hash reference of rows", NULL);
+    return -2;
+  }
+  hv= (HV*) SvRV(rows);
+
+  /* Every column that appears in any row, in the order first seen */
+  seen= (HV*) sv_2mortal((SV*) newHV());
+  columns= (AV*) sv_2mortal((SV*) newAV());
+  fixed= strlen(table) + strlen(key_col) + 32;
+  keys= hv_iterinit(hv);
+  while ((he= hv_iternext(hv)))
+  {
+    SV *value= hv_iterval(hv, he);
+
+    if (!SvROK(value) || SvTYPE(SvRV(value)) != SVt_PVHV)
+    {
+      do_error(dbh, JW_ERR_ARGUMENT,
+               "drizzle_bulk_update expects a hash reference per key", NULL);
+      return -2;
+    }
+    row= (HV*) SvRV(value);
+    hv_iterinit(row);
+    while ((entry= hv_iternext(row)))
+    {
+      col= HePV(entry, len);
+      if (hv_exists(seen, col, len))
+        continue;
+      (void) hv_store(seen, col, len, &sv_yes, 0);
+      av_push(columns, newSVpvn(col, len));
+      fixed+= 2*len + strlen(key_col) + 24;
+    }
+  }
+  if (!keys || av_len(columns) < 0)
+    return 0;
+
+  if (!drizzle_db_flush_combined(dbh, imp_dbh))
+    return -2;
+
+  New(0, chunk, keys, HE*);
+  sql= sv_2mortal(newSV(imp_dbh->max_packet_size));
+  hv_iterinit(hv);
+  for (;;)
+  {
+    /* Room for the key in IN () and a WHEN for each of its columns */
+    if ((he= hv_iternext(hv)))
+    {
+      STRLEN key_size= literal_size(hv_iterkeysv(he));
+
+      need= key_size + 1;
+      row= (HV*) SvRV(hv_iterval(hv, he));
+      hv_iterinit(row);
+      while ((entry= hv_iternext(row)))
+        need+= key_size + literal_size(HeVAL(entry)) + 12;
+      if (!n || fixed + size + need <= imp_dbh->max_packet_size)
+      {
+        chunk[n++]= he;
+        size+= need;
+        continue;
+      }
+    }
+    if (!n)
+      break;
+
+    bulk_update_sql(sql, imp_dbh, table, key_col, columns, chunk, n);
+    if ((affected= drizzle_db_run_bulk(dbh, imp_dbh, sql)) < 0)
+    {
+      Safefree(chunk);
+      return -2;
+    }
+    total+= affected;
+
+    /* The key that did not fit starts the next statement */
+    n= 0;
+    size= 0;
+    if (!he)
+      break;
+    chunk[n++]= he;
+    size= need;
+  }
+
+  Safefree(chunk);
+  return total;
+}
+
+/***************************************************************************
+ *
+ *  Name:    drizzle_db_bulk_delete
+ *
+ *  Purpose: Deletes many rows by key with DELETE ... WHERE key IN (...),
+ *           split into statements below drizzle_max_packet_size
+ *
+ *  Input:   dbh - database handle
+ *           imp_dbh - drivers private database handle data
+ *           table, key_col - used as given, quote them if needed
+ *           keys - array ref of keys
+ *
+ *  Returns: The number of rows deleted, or -2 after do_error
+ *
+ **************************************************************************/
+IV drizzle_db_bulk_delete(SV *dbh, imp_dbh_t *imp_dbh, char *table,
+                          char *key_col, SV *keys)
+{
+  AV *av;
+  SV *sql, **svp;
+  STRLEN head, mark;
+  IV total= 0, affected;
+  I32 i, last;
+
+  if (!SvROK(keys) || SvTYPE(SvRV(keys)) != SVt_PVAV)
+  {
+    do_error(dbh, JW_ERR_ARGUMENT,
+             "drizzle_bulk_delete expects an array reference of keys", NULL);
+    return -2;
+  }
+  av= (AV*) SvRV(keys);
+  if ((last= av_len(av)) < 0)
+    return 0;
+
+  if (!drizzle_db_flush_combined(dbh, imp_dbh))
+    return -2;
+
+  sql= sv_2mortal(newSV(imp_dbh->max_packet_size));
+  sv_setpvf(sql, "DELETE FROM %s WHERE %s IN (", table, key_col);
+  head= SvCUR(sql);
+  for (i= 0; i <= last; i++)
+  {
+    svp= av_fetch(av, i, FALSE);
+    mark= SvCUR(sql);
+    if (mark > head)
+      sv_catpvn(sql, ",", 1);
+    sv_cat_literal(sql, svp ? *svp : &sv_undef, imp_dbh->bind_type_guessing);
+
+    /* Send what fits, this key goes into the next statement */
+    if (SvCUR(sql) + 1 > imp_dbh->max_packet_size && mark > head)
+    {
+      SvCUR_set(sql, mark);
+      sv_catpvn(sql, ")", 1);
+      if ((affected= drizzle_db_run_bulk(dbh, imp_dbh, sql)) < 0)
+        return -2;
+      total+= affected;
+      SvCUR_set(sql, head);
+      i--;
+    }
+  }
+  sv_catpvn(sql, ")", 1);
+  if ((affected= drizzle_db_run_bulk(dbh, imp_dbh, sql)) < 0)
+    return -2;
+  return total + affected;
+}
+
+
+/*
+  One connection working on a chunk of drizzle_multi_get keys
+*/
+typedef struct multi_get_slot_st {
+  drizzle_con_st *con;
+  drizzle_result_st *result;
+  char *sql;
+  STRLEN sql_len;
+  int state;
+} multi_get_slot_t;
+
+enum multi_get_states { MULTI_GET_IDLE= 0, MULTI_GET_QUERY, MULTI_GET_BUFFER };
+
+/*
+  Adds the rows of a buffered drizzle_multi_get result to rows, each as a
+  hash of column name => value under the value of key_col, or of the
+  first column. FALSE, adding nothing, if key_col is not in the result.
+*/
+static bool multi_get_rows(imp_dbh_t *imp_dbh, drizzle_result_st *result,
+                           HV *rows, char *key_col)
+{
+  uint16_t num_fields= drizzle_result_column_count(result), i, key= 0;
+  bool found= !key_col;
+  bool chop_blanks= DBIc_has(imp_dbh, DBIcf_ChopBlanks);
+  drizzle_column_st **columns;
+  drizzle_row_t row;
+  size_t *lengths;
+  HV *hv;
+  SV *sv, *key_sv;
+
+  New(0, columns, num_fields, drizzle_column_st *);
+  drizzle_column_seek(result, 0);
+  for (i= 0; i < num_fields; i++)
+  {
+    columns[i]= drizzle_column_next(result);
+    if (key_col && !found && strEQ(drizzle_column_name(columns[i]), key_col))
+    {
+      key= i;
+      found= TRUE;
+    }
+  }
+  if (!found)
+  {
+    Safefree(columns);
+    return FALSE;
+  }
+
+  while ((row= drizzle_row_next(result)))
+  {
+    lengths= drizzle_row_field_sizes(result);
+    hv= newHV();
+    key_sv= NULL;
+    for (i= 0; i < num_fields; i++)
+    {
+      const char *name= drizzle_column_name(columns[i]);
+
+      sv= newSV(0);
+      drizzle_field_sv(sv, row[i], lengths[i], columns[i], chop_blanks,
+                       imp_dbh->enable_utf8, FALSE);
+      (void) hv_store(hv, name, strlen(name), sv, 0);
+      if (i == key)
+        key_sv= sv;
+    }
+    if (key_sv && SvOK(key_sv))
+      (void) hv_store_ent(rows, key_sv, newRV_noinc((SV*) hv), 0);
+    else
+      SvREFCNT_dec((SV*) hv);
+  }
+  Safefree(columns);
+  return TRUE;
+}
+
+/*
+  Advances a drizzle_multi_get slot as far as its connection allows.
+  Returns DRIZZLE_RETURN_IO_WAIT while it is waiting for the server,
+  otherwise the slot is idle again and the return code tells whether its
+  chunk went through.
+*/
+static drizzle_return_t multi_get_step(SV *dbh, imp_dbh_t *imp_dbh,
+                                       multi_get_slot_t *slot, HV *rows,
+                                       char *key_col, bool report)
+{
+  drizzle_return_t ret;
+
+  if (slot->state == MULTI_GET_QUERY)
+  {
+    slot->result= drizzle_query(slot->con, NULL, slot->sql, slot->sql_len,
+                                &ret);
+    if (ret == DRIZZLE_RETURN_IO_WAIT)
+      return ret;
+    if (ret != DRIZZLE_RETURN_OK)
+    {
+      if (report)
+        do_error(dbh, drizzle_con_error_code(slot->con),
+                 drizzle_con_error(slot->con),
+                 drizzle_con_sqlstate(slot->con));
+      if (slot->result)
+        drizzle_result_free(slot->result);
+      slot->result= NULL;
+      slot->state= MULTI_GET_IDLE;
+      return ret;
+    }
+    slot->state= MULTI_GET_BUFFER;
+  }
+
+  if ((ret= drizzle_result_buffer(slot->result)) == DRIZZLE_RETURN_IO_WAIT)
+    return ret;
+  if (ret == DRIZZLE_RETURN_OK)
+  {
+    if (!multi_get_rows(imp_dbh, slot->result, rows, key_col))
+    {
+      if (report)
+        do_error(dbh, JW_ERR_ARGUMENT,
+                 SvPVX(sv_2mortal(newSVpvf("drizzle_multi_get key_col '%s' "
+                                           "not in result", key_col))),
+                 NULL);
+      ret= DRIZZLE_RETURN_ERROR_CODE;
+    }
+  }
+  else if (report)
+    do_error(dbh, drizzle_result_error_code(slot->result),
+             drizzle_result_error(slot->result),
+             drizzle_result_sqlstate(slot->result));
+  drizzle_result_free(slot->result);
+  slot->result= NULL;
+  slot->state= MULTI_GET_IDLE;
+  return ret;
+}
+
+/***************************************************************************
+ *
+ *  Name:    drizzle_db_multi_get
+ *
+ *  Purpose: Looks up many keys at once with a statement that has a
+ *           single placeholder, as in "SELECT * FROM t WHERE id IN (?)".
+ *           The keys are bound as a list, chunk keys per query. With
+ *           parallel > 1 the chunks run at the same time on the main and
+ *           auxiliary connections, driven with non-blocking I/O; libdrizzle
+ *           cannot pipeline queries on one connection.
+ *
+ *  Input:   dbh - database handle
+ *           imp_dbh - drivers private database handle data
+ *           statement - the query
+ *           keys - array ref of keys
+ *           attribs - hash ref with chunk, key_col and parallel, or undef
+ *
+ *  Returns: A new hash of key => row hash, NULL after do_error
+ *
+ **************************************************************************/
+HV *drizzle_db_multi_get(SV *dbh, imp_dbh_t *imp_dbh, SV *statement,
+                         SV *keys, SV *attribs)
+{
+  multi_get_slot_t slots[MAX_AUX_CONNECTIONS + 1];
+  unsigned long chunk= MULTI_GET_CHUNK, timeout= imp_dbh->query_timeout;
+  int parallel= 1, nslots= 0, active, i;
+  bool non_blocking, failed= FALSE;
+  char *key_col= NULL, *sbuf;
+  imp_sth_ph_t ph;
+  I32 next= 0, nkeys;
+  double deadline= 0;
+  drizzle_return_t ret;
+  STRLEN slen;
+  SV **svp;
+  HV *rows;
+
+  if (attribs && SvROK(attribs) && SvTYPE(SvRV(attribs)) == SVt_PVHV)
+  {
+    HV *hv= (HV*) SvRV(attribs);
+
+    if ((svp= hv_fetch(hv, "chunk", 5, FALSE)) && SvTRUE(*svp))
+      chunk= SvUV(*svp);
+    if ((svp= hv_fetch(hv, "key_col", 7, FALSE)) && SvOK(*svp))
+      key_col= SvPV_nolen(*svp);
+    if ((svp= hv_fetch(hv, "parallel", 8, FALSE)) && SvTRUE(*svp))
+      parallel= SvIV(*svp);
+  }
+  if (parallel > MAX_AUX_CONNECTIONS + 1)
+    parallel= MAX_AUX_CONNECTIONS + 1;
+
+  sbuf= SvPV(statement, slen);
+  if (!param_list(keys) || count_params(sbuf) != 1)
+  {
+    do_error(dbh, JW_ERR_ARGUMENT, "drizzle_multi_get expects a statement "
+             "with one placeholder and an array reference of keys", NULL);
+    return NULL;
+  }
+  if (!drizzle_db_flush_combined(dbh, imp_dbh))
+    return NULL;
+
+  rows= newHV();
+  if ((nkeys= av_len(param_list(keys)) + 1) == 0)
+    return rows;
+
+  /*
+    Idle connections: the main one, and within AutoCommit the auxiliary
+    ones, opening more as drizzle_aux_connections allows
+  */
+  if (!imp_dbh->con_owner)
+    slots[nslots++].con= imp_dbh->con;
+  if (DBIc_has(imp_dbh, DBIcf_AutoCommit) && !imp_dbh->session_log_full)
+  {
+    drizzle_con_st *con;
+
+    for (i= 0; i < imp_dbh->aux_count && nslots < parallel; i++)
+      if (!imp_dbh->aux_owner[i])
+        slots[nslots++].con= imp_dbh->aux_con[i];
+    while (nslots < parallel && (con= drizzle_db_open_aux(dbh, imp_dbh)))
+      slots[nslots++].con= con;
+  }
+  if (!nslots)
+    slots[nslots++].con= imp_dbh->con;
+
+  /* Each of them needs the schema and session variables of the dbh */
+  for (i= 0; i < nslots; i++)
+    if (!drizzle_db_sync_con(imp_dbh, slots[i].con))
+    {
+      do_error(dbh, drizzle_con_error_code(slots[i].con),
+               drizzle_con_error(slots[i].con),
+               drizzle_con_sqlstate(slots[i].con));
+      SvREFCNT_dec((SV*) rows);
+      return NULL;
+    }
+
+  /* A query timeout needs non-blocking I/O too */
+  non_blocking= nslots > 1 || timeout;
+  if (non_blocking)
+    drizzle_add_options(imp_dbh->drizzle, DRIZZLE_NON_BLOCKING);
+  if (timeout)
+    deadline= drizzle_deadline(timeout);
+
+  Zero(&ph, 1, imp_sth_ph_t);
+  ph.value= keys;
+  ph.list_count= (I32) chunk;
+  for (i= 0; i < nslots; i++)
+  {
+    slots[i].result= NULL;
+    slots[i].sql= NULL;
+    slots[i].state= MULTI_GET_IDLE;
+  }
+
+  do
+  {
+    active= 0;
+    for (i= 0; i < nslots; i++)
+    {
+      multi_get_slot_t *slot= slots + i;
+
+      /* Give an idle connection the next chunk */
+      if (slot->state == MULTI_GET_IDLE)
+      {
+        if (failed || next >= nkeys)
+          continue;
+        ph.list_offset= next;
+        next+= (I32) chunk;
+        Safefree(slot->sql);
+        slot->sql_len= slen;
+        slot->sql= parse_params(slot->con, sbuf, &slot->sql_len, &ph, 1,
+                                imp_dbh->bind_type_guessing);
+        slot->state= MULTI_GET_QUERY;
+      }
+
+      ret= multi_get_step(dbh, imp_dbh, slot, rows, key_col, !failed);
+      if (ret == DRIZZLE_RETURN_IO_WAIT)
+        active++;
+      else if (ret != DRIZZLE_RETURN_OK)
+        failed= TRUE;
+      else if (next < nkeys && !failed)
+        i--;   /* start the next chunk on it right away */
+    }
+
+    if (active)
+    {
+      if (timeout)
+        ret= drizzle_wait_until(imp_dbh, deadline);
+      else
+        ret= drizzle_con_wait(imp_dbh->drizzle);
+
+      if (ret == DRIZZLE_RETURN_TIMEOUT)
+      {
+        /* Stop all queries, then finish them blocking */
+        bool first= TRUE;
+
+        for (i= 0; i < nslots; i++)
+        {
+          if (slots[i].state == MULTI_GET_IDLE)
+            continue;
+          if (first)
+            drizzle_timed_out(dbh, imp_dbh, slots[i].con, timeout);
+          else
+            (void) drizzle_db_kill_query(dbh, imp_dbh, slots[i].con);
+          first= FALSE;
+        }
+        for (i= 0; i < nslots; i++)
+          while (slots[i].state != MULTI_GET_IDLE)
+            (void) multi_get_step(dbh, imp_dbh, slots + i, rows, key_col,
+                                  FALSE);
+        failed= TRUE;
+        active= 0;
+      }
+      else if (ret != DRIZZLE_RETURN_OK)
+      {
+        do_error(dbh, JW_ERR_QUERY, drizzle_error(imp_dbh->drizzle), NULL);
+        drizzle_remove_options(imp_dbh->drizzle, DRIZZLE_NON_BLOCKING);
+        non_blocking= FALSE;
+        for (i= 0; i < nslots; i++)
+          while (slots[i].state != MULTI_GET_IDLE)
+            (void) multi_get_step(dbh, imp_dbh, slots + i, rows, key_col,
+                                  FALSE);
+        failed= TRUE;
+        active= 0;
+      }
+    }
+  } while (active);
+
+  if (non_blocking)
+    drizzle_remove_options(imp_dbh->drizzle, DRIZZLE_NON_BLOCKING);
+  for (i= 0; i < nslots; i++)
+    Safefree(slots[i].sql);
+
+  if (failed)
+  {
+    SvREFCNT_dec((SV*) rows);
+    return NULL;
+  }
+  return rows;
+}
+
+/***************************************************************************
+ *
+ *  Name:    copy_in_record
+ *
+ *  Purpose: Parses one record of drizzle_copy_in input into a row of
+ *           literals, "(v1,v2,...)", appended to sql.
+ *
+ *           tsv: fields end at a tab, records at a newline. \t, \n, \r,
+ *           \0 and \\ are unescaped, and a field of just \N is NULL.
+ *
+ *           csv: fields end at a comma, records at a newline. Fields may
+ *           be quoted with ", doubling quotes inside, and then contain
+ *           commas and newlines. An unquoted empty field is NULL.
+ *
+ *           A \r before the newline is dropped.
+ *
+ *  Returns: The number of bytes used, 0 if the record does not end
+ *           before len and more input is to come, or -1 for a malformed
+ *           record, with the reason in *err
+ *
+ **************************************************************************/
+static SSize_t copy_in_record(const char *in, STRLEN len, bool eof,
+                              bool csv, int ncols, SV *sql, SV *scratch,
+                              bool guess, const char **err)
+{
+  const char *p= in, *end= in + len, *run, *start, *stop;
+  char sep= csv ? ',' : '\t';
+  int field= 0;
+  bool null, quoted;
+
+  sv_catpvn(sql, "(", 1);
+  for (;;)
+  {
+    SvCUR_set(scratch, 0);
+    quoted= FALSE;
+
+    if (csv && p < end && *p == '"')
+    {
+      quoted= TRUE;
+      for (run= ++p; ; p++)
+      {
+        if (p == end)
+        {
+          *err= "unterminated quoted field";
+          return eof ? -1 : 0;
+        }
+        if (*p != '"')
+          continue;
+        if (p + 1 == end && !eof)
+          return 0;
+        sv_catpvn(scratch, run, p - run);
+        if (p + 1 < end && p[1] == '"')
+        {
+          run= ++p;
+          continue;
+        }
+        p++;
+        break;
+      }
+      if (p < end && *p != sep && *p != '\n' && *p != '\r')
+      {
+        *err= "text after a quoted field";
+        return -1;
+      }
+    }
+
+    /* Up to the end of the field */
+    for (start= run= p; p < end && *p != sep && *p != '\n'; p++)
+    {
+      if (csv || *p != '\\')
+        continue;
+      sv_catpvn(scratch, run, p - run);
+      if (++p == end)
+        break;
+      switch (*p)
+      {
+        case 't': sv_catpvn(scratch, "\t", 1); break;
+        case 'n': sv_catpvn(scratch, "\n", 1); break;
+        case 'r': sv_catpvn(scratch, "\r", 1); break;
+        case '0': sv_catpvn(scratch, "", 1); break;
+        default:  sv_catpvn(scratch, p, 1); break;
+      }
+      run= p + 1;
+    }
+    if (p == end && !eof)
+      return 0;
+    stop= p;
+    if ((p == end || *p == '\n') && stop > run && stop[-1] == '\r')
+      stop--;
+    sv_catpvn(scratch, run, stop - run);
+
+    if (csv)
+      null= !quoted && !SvCUR(scratch);
+    else
+      null= SvCUR(scratch) == 1 && start[0] == '\\' && start[1] == 'N';
+
+    if (++field > ncols)
+    {
+      *err= "more fields than columns";
+      return -1;
+    }
+    if (field > 1)
+      sv_catpvn(sql, ",", 1);
+    sv_cat_literal(sql, null ? &sv_undef : scratch, guess);
+
+    if (p == end || *p++ == '\n')
+      break;
+  }
+
+  if (field < ncols)
+  {
+    *err= "fewer fields than columns";
+    return -1;
+  }
+  sv_catpvn(sql, ")", 1);
+  return p - in;
+}
+
+/***************************************************************************
+ *
+ *  Name:    drizzle_db_copy_in
+ *
+ *  Purpose: Loads tab or comma separated lines read from a file handle
+ *           into a table, as multi-row INSERTs of up to batch_bytes
+ *           each. libdrizzle cannot pipeline, so each INSERT is answered
+ *           before the next one is sent.
+ *
+ *  Input:   dbh - database handle
+ *           imp_dbh - drivers private database handle data
+ *           table - used as given
+ *           columns - array ref of column names, used as given
+ *           fh - file handle to read from
+ *           attribs - hash ref with format, batch_bytes and header
+ *
+ *  Returns: The number of rows inserted, or -2 after do_error
+ *
+ **************************************************************************/
+IV drizzle_db_copy_in(SV *dbh, imp_dbh_t *imp_dbh, char *table, SV *columns,
+                      SV *fh, SV *attribs)
+{
+  D_imp_xxh(dbh);
+  unsigned long batch_bytes= imp_dbh->max_packet_size;
+  unsigned long line= 1, first_line= 0, last_line= 0;
+  bool csv= FALSE, header= FALSE, eof= FALSE;
+  bool guess= imp_dbh->bind_type_guessing;
+  STRLEN head, mark, pos, in_len= 0;
+  const char *err= NULL;
+  IV total= 0, affected;
+  SV *sql, *scratch, *in, **svp;
+  SSize_t used, got;
+  int ncols, i, rows= 0;
+  PerlIO *fp;
+  AV *av;
+
+  if (attribs && SvROK(attribs) && SvTYPE(SvRV(attribs)) == SVt_PVHV)
+  {
+    HV *hv= (HV*) SvRV(attribs);
+
+    if ((svp= hv_fetch(hv, "format", 6, FALSE)) && SvOK(*svp))
+    {
+      if (strEQ(SvPV_nolen(*svp), "csv"))
+        csv= TRUE;
+      else if (!strEQ(SvPV_nolen(*svp), "tsv"))
+      {
+        do_error(dbh, JW_ERR_ARGUMENT,
+                 "drizzle_copy_in format must be 'tsv' or 'csv'", NULL);
+        return -2;
+      }
+    }
+    if ((svp= hv_fetch(hv, "batch_bytes", 11, FALSE)) && SvTRUE(*svp))
+      batch_bytes= SvUV(*svp);
+    if ((svp= hv_fetch(hv, "header", 6, FALSE)))
+      header= SvTRUE(*svp);
+  }
+
+  if (!SvROK(columns) || SvTYPE(SvRV(columns)) != SVt_PVAV ||
+      (ncols= av_len((AV*) SvRV(columns)) + 1) == 0 ||
+      !(fp= IoIFP(sv_2io(fh))))
+  {
+    do_error(dbh, JW_ERR_ARGUMENT, "drizzle_copy_in expects an array "
+             "reference of columns and a file handle open for reading", NULL);
+    return -2;
+  }
+  if (!drizzle_db_flush_combined(dbh, imp_dbh))
+    return -2;
+
+  av= (AV*) SvRV(columns);
+  sql= sv_2mortal(newSV(batch_bytes + 1));
+  sv_setpvf(sql, "INSERT INTO %s (", table);
+  for (i= 0; i < ncols; i++)
+  {
+    svp= av_fetch(av, i, FALSE);
+    sv_catpvf(sql, "%s%s", i ? "," : "", svp ? SvPV_nolen(*svp) : "");
+  }
+  sv_catpvn(sql, ") VALUES ", 9);
+  head= SvCUR(sql);
+  scratch= sv_2mortal(newSV(256));
+  SvPOK_on(scratch);
+  in= sv_2mortal(newSV(COPY_IN_READ_SIZE));
+
+  while (!eof)
+  {
+    /* Read more, after what is left of a record from last time */
+    SvGROW(in, in_len + COPY_IN_READ_SIZE);
+    if ((got= PerlIO_read(fp, SvPVX(in) + in_len, COPY_IN_READ_SIZE)) <= 0)
+    {
+      if (got < 0 || PerlIO_error(fp))
+      {
+        do_error(dbh, JW_ERR_IO, "drizzle_copy_in could not read input",
+                 NULL);
+        return -2;
+      }
+      eof= TRUE;
+    }
+    else
+      in_len+= got;
+
+    for (pos= 0; pos < in_len; pos+= used)
+    {
+      char *rec= SvPVX(in) + pos;
+
+      if (header)
+      {
+        char *nl= memchr(rec, '\n', in_len - pos);
+
+        if (!nl && !eof)
+          break;
+        header= FALSE;
+        used= nl ? nl + 1 - rec : (SSize_t) (in_len - pos);
+        line++;
+        continue;
+      }
+      /* Empty lines are skipped */
+      if (*rec == '\n' || (*rec == '\r' && pos + 1 < in_len && rec[1] == '\n'))
+      {
+        used= *rec == '\n' ? 1 : 2;
+        line++;
+        continue;
+      }
+
+      mark= SvCUR(sql);
+      if (rows)
+        sv_catpvn(sql, ",", 1);
+      if ((used= copy_in_record(rec, in_len - pos, eof, csv, ncols, sql,
+                                scratch, guess, &err)) < 0)
+      {
+        SV *msg= sv_2mortal(newSVpvf("drizzle_copy_in line %lu: %s",
+                                     line, err));
+
+        do_error(dbh, JW_ERR_ARGUMENT, SvPVX(msg), NULL);
+        return -2;
+      }
+      if (!used)
+      {
+        SvCUR_set(sql, mark);
+        break;
+      }
+
+      /* Send what we have if the record makes the INSERT too long */
+      if (rows && SvCUR(sql) > batch_bytes)
+      {
+        SvCUR_set(sql, mark);
+        if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+          PerlIO_printf(DBILOGFP, "\t\tdrizzle_copy_in lines %lu..%lu\n",
+                        first_line, last_line);
+        if ((affected= drizzle_db_run_bulk(dbh, imp_dbh, sql)) < 0)
+          goto failed;
+        total+= affected;
+        SvCUR_set(sql, head);
+        rows= 0;
+        used= 0;
+        continue;
+      }
+
+      if (!rows++)
+        first_line= line;
+      last_line= line;
+      for (i= 0; i < used; i++)
+        if (rec[i] == '\n')
+          line++;
+    }
+
+    /* Keep the incomplete record for the next read */
+    if (pos < in_len)
+      Move(SvPVX(in) + pos, SvPVX(in), in_len - pos, char);
+    in_len-= pos;
+  }
+
+  if (rows)
+  {
+    if ((affected= drizzle_db_run_bulk(dbh, imp_dbh, sql)) < 0)
+      goto failed;
+    total+= affected;
+  }
+  return total;
+
+failed:
+  {
+    SV *msg= sv_2mortal(newSVpvf("drizzle_copy_in lines %lu to %lu: %s",
+                                 first_line, last_line,
+                                 SvPV_nolen(DBIc_ERRSTR(imp_xxh))));
+
+    do_error(dbh, SvIV(DBIc_ERR(imp_xxh)), SvPVX(msg), NULL);
+  }
+  return -2;
+}
+
+/*
+  The hash_key_cases for the keyattr argument of fetchrow_hashref, or
+  for FetchHashKeyName of h without one; -1 after do_error
+*/
+static int hash_key_case(SV *h, SV *keyattr)
+{
+  const char *keyname= "NAME";
+  SV *sv;
+
+  /* DBI keeps FetchHashKeyName on the parent handle */
+  if (keyattr && SvOK(keyattr))
+    keyname= SvPV_nolen(keyattr);
+  else if ((sv= DBIS->get_attr_k(h,
+              sv_2mortal(newSVpvn("FetchHashKeyName", 16)), 0)) && SvOK(sv))
+    keyname= SvPV_nolen(sv);
+
+  if (strEQ(keyname, "NAME"))
+    return HASH_KEY_NAME;
+  if (strEQ(keyname, "NAME_lc"))
+    return HASH_KEY_NAME_LC;
+  if (strEQ(keyname, "NAME_uc"))
+    return HASH_KEY_NAME_UC;
+  do_error(h, JW_ERR_ARGUMENT,
+           "hash key name must be NAME, NAME_lc or NAME_uc", NULL);
+  return -1;
+}
+
+/*
+  A new shared, pre-hashed key SV for a column name in one of the
+  hash_key_cases
+*/
+static SV *hash_key_sv(const char *name, int key_case)
+{
+  STRLEN len= strlen(name), i;
+  char *buf;
+  SV *key;
+
+  New(0, buf, len + 1, char);
+  for (i= 0; i < len; i++)
+    buf[i]= key_case == HASH_KEY_NAME_LC ? toLOWER(name[i]) :
+            key_case == HASH_KEY_NAME_UC ? toUPPER(name[i]) : name[i];
+  key= newSVpvn_share(buf, (I32) len, 0);
+  Safefree(buf);
+  return key;
+}
+
+/***************************************************************************
+ *
+ *  Name:    drizzle_db_select
+ *
+ *  Purpose: selectrow_array, selectrow_hashref, selectcol_arrayref and
+ *           selectall_arrayref without a statement handle: the query
+ *           runs with drizzle_st_internal_execute, like do(), and the
+ *           buffered rows are turned into Perl data as fetch would return
+ *           them (ChopBlanks and drizzle_enable_utf8 of the dbh apply).
+ *
+ *  Input:   dbh - database handle
+ *           imp_dbh - drivers private database handle data
+ *           statement - the query
+ *           what - "row", "row_hash", "col" or "all"
+ *           num_params - number of placeholder values
+ *           params - placeholder values
+ *
+ *  Returns: A new SV: a reference to the first row as an array or a hash
+ *           (undef without rows), to an array of the first column of each
+ *           row, or to an array of rows. NULL after do_error.
+ *
+ **************************************************************************/
+SV *drizzle_db_select(SV *dbh, imp_dbh_t *imp_dbh, SV *statement,
+                      const char *what, int num_params, imp_sth_ph_t *params)
+{
+  bool chop_blanks= DBIc_has(imp_dbh, DBIcf_ChopBlanks);
+  drizzle_result_st *result= NULL;
+  drizzle_column_st **columns;
+  int key_case= HASH_KEY_NAME, num_fields, i;
+  size_t *lengths;
+  drizzle_row_t row;
+  SV *sv, *retsv= NULL;
+  AV *all, *av;
+  HV *hv;
+
+  if (strEQ(what, "row_hash") && (key_case= hash_key_case(dbh, NULL)) < 0)
+    return NULL;
+  if (!drizzle_db_flush_combined(dbh, imp_dbh))
+    return NULL;
+
+  if (drizzle_st_internal_execute(dbh, statement, NULL, num_params, params,
+                                  &result,
+                                  drizzle_db_pick_con(dbh, imp_dbh, NULL),
+                                  FALSE) == (uint64_t) -2)
+  {
+    if (result)
+      drizzle_result_free(result);
+    return NULL;
+  }
+
+  num_fields= result ? drizzle_result_column_count(result) : 0;
+  New(0, columns, num_fields ? num_fields : 1, drizzle_column_st *);
+  drizzle_column_seek(result, 0);
+  for (i= 0; i < num_fields; i++)
+    columns[i]= drizzle_column_next(result);
+
+  if (strEQ(what, "row") || strEQ(what, "row_hash"))
+  {
+    if (num_fields && (row= drizzle_row_next(result)))
+    {
+      lengths= drizzle_row_field_sizes(result);
+      if (strEQ(what, "row"))
+      {
+        av= newAV();
+        av_extend(av, num_fields - 1);
+        for (i= 0; i < num_fields; i++)
+        {
+          sv= newSV(0);
+          drizzle_field_sv(sv, row[i], lengths[i], columns[i], chop_blanks,
+                           imp_dbh->enable_utf8, FALSE);
+          av_store(av, i, sv);
+        }
+        retsv= newRV_noinc((SV*) av);
+      }
+      else
+      {
+        hv= newHV();
+        hv_ksplit(hv, num_fields);
+        for (i= 0; i < num_fields; i++)
+        {
+          SV *key= hash_key_sv(drizzle_column_name(columns[i]), key_case);
+
+          sv= newSV(0);
+          drizzle_field_sv(sv, row[i], lengths[i], columns[i], chop_blanks,
+                           imp_dbh->enable_utf8, FALSE);
+          (void) hv_store_ent(hv, key, sv, SvSHARED_HASH(key));
+          SvREFCNT_dec(key);
+        }
+        retsv= newRV_noinc((SV*) hv);
+      }
+    }
+  }
+  else
+  {
+    bool col= strEQ(what, "col");
+
+    all= newAV();
+    if (num_fields)
+    {
+      av_extend(all, drizzle_result_row_count(result));
+      while ((row= drizzle_row_next(result)))
+      {
+        lengths= drizzle_row_field_sizes(result);
+        if (col)
+        {
+          sv= newSV(0);
+          drizzle_field_sv(sv, row[0], lengths[0], columns[0], chop_blanks,
+                           imp_dbh->enable_utf8, FALSE);
+          av_push(all, sv);
+          continue;
+        }
+        av= newAV();
+        av_extend(av, num_fields - 1);
+        for (i= 0; i < num_fields; i++)
+        {
+          sv= newSV(0);
+          drizzle_field_sv(sv, row[i], lengths[i], columns[i], chop_blanks,
+                           imp_dbh->enable_utf8, FALSE);
+          av_store(av, i, sv);
+        }
+        av_push(all, newRV_noinc((SV*) av));
+      }
+    }
+    retsv= newRV_noinc((SV*) all);
+  }
+
+  Safefree(columns);
+  if (result)
+    drizzle_result_free(result);
+  return retsv ? retsv : newSV(0);
+}
+
+
+/***************************************************************************
+ *
+ *  Name:    dbd_db_commit
+ *           dbd_db_rollback
+ *
+ *  Purpose: You guess what they should do. 
+ *
+ *  Input:   dbh - database handle being commited or rolled back
+ *           imp_dbh - drivers private database handle data
+ *
+ *  Returns: TRUE for success, FALSE otherwise; do_error has already
+ *           been called in the latter case
+ *
+ **************************************************************************/
+
+int
+dbd_db_commit(SV* dbh, imp_dbh_t* imp_dbh)
+{
+  drizzle_result_st res;
+  drizzle_return_t ret;
+
+  if (DBIc_has(imp_dbh, DBIcf_AutoCommit))
+    return FALSE;
+
+  if (!drizzle_db_flush_combined(dbh, imp_dbh))
+    return FALSE;
+
+  drizzle_query_str(imp_dbh->con, &res, "COMMIT", &ret);
+  if (ret != DRIZZLE_RETURN_OK) {
+    do_error(dbh, drizzle_result_error_code(&res), drizzle_result_error(&res)
+             ,drizzle_result_sqlstate(&res));
+    return FALSE;
+  }
+  drizzle_result_free(&res);
+  return TRUE;
+}
+
+/*
+ dbd_db_rollback
+*/
+int dbd_db_rollback(SV* dbh, imp_dbh_t* imp_dbh) {
+  drizzle_result_st res;
+  drizzle_return_t ret;
+
+  /* croak, if not in AutoCommit mode */
+  if (DBIc_has(imp_dbh, DBIcf_AutoCommit))
+    return FALSE;
+
+  drizzle_db_discard_combined(imp_dbh);
+
+  drizzle_query_str(imp_dbh->con, &res, "ROLLBACK", &ret);
+  if (ret != DRIZZLE_RETURN_OK) {
+    do_error(dbh, drizzle_result_error_code(&res), drizzle_result_error(&res)
+             ,drizzle_result_sqlstate(&res));
+    return FALSE;
+  }
+  drizzle_result_free(&res);
+  return TRUE;
+}
+
+/*
+ ***************************************************************************
+ *
+ *  Name:    dbd_db_disconnect
+ *
+ *  Purpose: Disconnect a database handle from its database
+ *
+ *  Input:   dbh - database handle being disconnected
+ *           imp_dbh - drivers private database handle data
+ *
+ *  Returns: TRUE for success, FALSE otherwise; do_error has already
+ *           been called in the latter case
+ *
+ **************************************************************************/
+
+int dbd_db_disconnect(SV* dbh, imp_dbh_t* imp_dbh)
+{
+#ifdef dTHR
+    dTHR;
+#endif
+    D_imp_xxh(dbh);
+
+    /* We assume that disconnect will always work       */
+    /* since most errors imply already disconnected.    */
+    DBIc_ACTIVE_off(imp_dbh);
+    if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+        PerlIO_printf(DBILOGFP, "imp_dbh->con: %lx\n",
+		      (long) imp_dbh->con);
+    drizzle_db_discard_combined(imp_dbh);
+    drizzle_db_free_aux(imp_dbh);
+    drizzle_con_close(imp_dbh->con );
+
+    /* We don't free imp_dbh since a reference still exists    */
+    /* The DESTROY method is the only one to 'free' memory.    */
+    return TRUE;
+}
+
+
+/***************************************************************************
+ *
+ *  Name:    dbd_discon_all
+ *
+ *  Purpose: Disconnect all database handles at shutdown time
+ *
+ *  Input:   dbh - database handle being disconnected
+ *           imp_dbh - drivers private database handle data
+ *
+ *  Returns: TRUE for success, FALSE otherwise; do_error has already
+ *           been called in the latter case
+ *
+ **************************************************************************/
+
+int dbd_discon_all (SV *drh, imp_drh_t *imp_drh) {
+#if defined(dTHR)
+    dTHR;
+#endif
+  D_imp_xxh(drh);
+
+  /* The disconnect_all concept is flawed and needs more work */
+  if (!dirty && !SvTRUE(perl_get_sv("DBI::PERL_ENDING",0))) {
+    sv_setiv(DBIc_ERR(imp_drh), (IV)1);
+    sv_setpv(DBIc_ERRSTR(imp_drh),
+             (char*)"disconnect_all not implemented");
+    /* NO EFFECT DBIh_EVENT2(drh, ERROR_event,
+      DBIc_ERR(imp_drh), DBIc_ERRSTR(imp_drh)); */
+    return FALSE;
+  }
+  perl_destruct_level = 0;
+  return FALSE;
+}
+
+
+/****************************************************************************
+ *
+ *  Name:    dbd_db_destroy
+ *
+ *  Purpose: Our part of the dbh destructor
+ *
+ *  Input:   dbh - database handle being destroyed
+ *           imp_dbh - drivers private database handle data
+ *
+ *  Returns: Nothing
+ *
+ **************************************************************************/
+
+void dbd_db_destroy(SV* dbh, imp_dbh_t* imp_dbh) {
+
+    /*
+     *  Being on the safe side never hurts ...
+     */
+  if (DBIc_ACTIVE(imp_dbh))
+  {
+    if (!DBIc_has(imp_dbh, DBIcf_AutoCommit))
+      dbd_db_rollback(dbh, imp_dbh);
+    dbd_db_disconnect(dbh, imp_dbh);
+  }
+  drizzle_db_free_aux(imp_dbh);
+  if (imp_dbh->session_log)
+    SvREFCNT_dec(imp_dbh->session_log);
+  imp_dbh->session_log= NULL;
+  drizzle_con_free(imp_dbh->con);
+  drizzle_free(imp_dbh->drizzle);
+
+  /* Tell DBI, that dbh->destroy must no longer be called */
+  DBIc_off(imp_dbh, DBIcf_IMPSET);
+}
+
+/* 
+ ***************************************************************************
+ *
+ *  Name:    dbd_db_STORE_attrib
+ *
+ *  Purpose: Function for storing dbh attributes; we currently support
+ *           just nothing. :-)
+ *
+ *  Input:   dbh - database handle being modified
+ *           imp_dbh - drivers private database handle data
+ *           keysv - the attribute name
+ *           valuesv - the attribute value
+ *
+ *  Returns: TRUE for success, FALSE otherwise
+ *
+ **************************************************************************/
+int
+dbd_db_STORE_attrib(
+                    SV* dbh,
+                    imp_dbh_t* imp_dbh,
+                    SV* keysv,
+                    SV* valuesv
+                   )
+{
+  STRLEN kl;
+  char *key = SvPV(keysv, kl);
+  SV *cachesv = Nullsv;
+  int cacheit = FALSE;
+  drizzle_result_st res;
+  drizzle_return_t ret;
+  char *query; /* SET AUTOCOMMIT=x plus null */
+  bool bool_value = SvTRUE(valuesv);
+
+  if (kl==10 && strEQ(key, "AutoCommit"))
+  {
+    int oldval = DBIc_has(imp_dbh,DBIcf_AutoCommit);
+
+    if (bool_value == oldval)
+      return TRUE;
+    /* Turning AutoCommit on commits, so the combined rows go first */
+    if (!drizzle_db_flush_combined(dbh, imp_dbh))
+      return FALSE;
+    if (!(query = (char *)malloc(strlen("SET AUTOCOMMIT=x")+1))) {
+      do_error(dbh, JW_ERR_MEM, "Out of memory", NULL);
+      return FALSE;
+    }
+    sprintf(query, "SET AUTOCOMMIT=%d", bool_value);
+    (void) drizzle_query_str(imp_dbh->con, &res, query, &ret);
+    // static results must be freed before they leave the stack
+    drizzle_result_free(&res);
+    free(query);
+               /*bool_value ?
+                "Turning on AutoCommit failed" :
+                "Turning off AutoCommit failed"*/
+    if (ret != DRIZZLE_RETURN_OK) {
+      do_error(dbh, drizzle_con_errno(imp_dbh->con), 
+               drizzle_con_error(imp_dbh->con),
+               drizzle_con_sqlstate(imp_dbh->con));
+      return FALSE;
+    }
+    DBIc_set(imp_dbh, DBIcf_AutoCommit, bool_value);
+  }
+  else  if (kl == 25 && strEQ(key,"drizzle_unbuffered_result"))
+    imp_dbh->unbuffered_result = bool_value;
+  else if (kl == 22 && strEQ(key,"drizzle_auto_reconnect"))
+    imp_dbh->auto_reconnect = bool_value;
+
+  else if (kl == 26 && strEQ(key,"drizzle_bind_type_guessing"))
+    imp_dbh->bind_type_guessing = SvTRUE(valuesv);
+  else if (kl == 24 && strEQ(key, "drizzle_max_result_bytes"))
+    imp_dbh->max_result_bytes= SvOK(valuesv) ? SvUV(valuesv) : 0;
+  else if (kl == 25 && strEQ(key, "drizzle_max_result_action"))
+    imp_dbh->max_result_action= result_cap_action(valuesv);
+  else if (kl == 20 && strEQ(key, "drizzle_compact_rows"))
+    imp_dbh->compact_rows= bool_value;
+  else if (kl == 23 && strEQ(key, "drizzle_release_fetched"))
+    imp_dbh->release_fetched= bool_value;
+  else if (kl == 20 && strEQ(key, "drizzle_lazy_columns"))
+    imp_dbh->lazy_columns= bool_value;
+  else if (kl == 24 && strEQ(key, "drizzle_cancel_threshold"))
+    imp_dbh->cancel_threshold= SvOK(valuesv) ? SvUV(valuesv) : 0;
+  else if (kl == 23 && strEQ(key, "drizzle_max_packet_size"))
+    imp_dbh->max_packet_size= SvTRUE(valuesv) ?
+      SvUV(valuesv) : DEFAULT_MAX_PACKET_SIZE;
+  else if (kl == 21 && strEQ(key, "drizzle_query_timeout"))
+    imp_dbh->query_timeout= SvOK(valuesv) ? SvUV(valuesv) : 0;
+  else if (kl == 16 && strEQ(key, "drizzle_in_chunk"))
+    imp_dbh->in_chunk= SvOK(valuesv) ? SvUV(valuesv) : 0;
+  else if (kl == 23 && strEQ(key, "drizzle_aux_connections"))
+  {
+    imp_dbh->aux_connections= SvIV(valuesv);
+    if (imp_dbh->aux_connections < 0)
+      imp_dbh->aux_connections= 0;
+    else if (imp_dbh->aux_connections > MAX_AUX_CONNECTIONS)
+      imp_dbh->aux_connections= MAX_AUX_CONNECTIONS;
+    /* With no auxiliary connections left, nothing needs the log */
+    if (!imp_dbh->aux_connections && !imp_dbh->aux_count &&
+        imp_dbh->session_log)
+    {
+      SvREFCNT_dec(imp_dbh->session_log);
+      imp_dbh->session_log= NULL;
+      imp_dbh->session_log_full= FALSE;
+      imp_dbh->con_synced= 0;
+    }
+  }
+  /*HELMUT */
+#if defined(sv_utf8_decode)
+  else if (kl == 19 && strEQ(key, "drizzle_enable_utf8"))
+  {
+    imp_dbh->enable_utf8 = bool_value;
+    /* statements reading a result make a new fetch plan */
+    imp_dbh->utf8_generation++;
+  }
+#endif
+  else
+    return FALSE;				/* Unknown key */
+
+  if (cacheit) /* cache value for later DBI 'quick' fetch? */
+    hv_store((HV*)SvRV(dbh), key, kl, cachesv, 0);
+  return TRUE;
+}
+
+/***************************************************************************
+ *
+ *  Name:    dbd_db_FETCH_attrib
+ *
+ *  Purpose: Function for fetching dbh attributes
+ *
+ *  Input:   dbh - database handle being queried
+ *           imp_dbh - drivers private database handle data
+ *           keysv - the attribute name
+ *
+ *  Returns: An SV*, if sucessfull; NULL otherwise
+ *
+ *  Notes:   Do not forget to call sv_2mortal in the former case!
+ *
+ **************************************************************************/
+SV* my_ulonglong2str(uint64_t val)
+{
+  char buf[64];
+  char *ptr = buf + sizeof(buf) - 1;
+
+  if (val == 0)
+    return newSVpv("0", 1);
+
+  *ptr = '\0';
+  while (val > 0)
+  {
+    *(--ptr) = ('0' + (val % 10));
+    val = val / 10;
+  }
+  return newSVpv(ptr, (buf+ sizeof(buf) - 1) - ptr);
+}
+
+SV* dbd_db_FETCH_attrib(SV *dbh, imp_dbh_t *imp_dbh, SV *keysv)
+{
+  STRLEN kl;
+  char *key = SvPV(keysv, kl);
+  char* fine_key = NULL;
+  SV* result = NULL;
+  dbh = dbh;
+
+  switch (*key) {
+    case 'A':
+      if (strEQ(key, "AutoCommit"))
+      {
+        return sv_2mortal(boolSV(DBIc_has(imp_dbh,DBIcf_AutoCommit)));
+      }
+      break;
+  }
+  if (strncmp(key, "drizzle_", DRIZZLE_KEY_PREFIX) == 0) {
+    fine_key = key;
+    key = key + DRIZZLE_KEY_PREFIX;
+    kl = kl - DRIZZLE_KEY_PREFIX;
+  }
+
+  /* MONTY:  Check if kl should not be used or used everywhere */
+  /*
+    why the heck bother checking kl? If it's equal to the string, then
+    is that not all we care about ? 
+  */
+  switch(*key) {
+  case 'a':
+    if (kl == strlen("auto_reconnect") && strEQ(key, "auto_reconnect"))
+      result= sv_2mortal(newSViv(imp_dbh->auto_reconnect));
+    else if (strEQ(key, "aux_connections"))
+      result= sv_2mortal(newSViv(imp_dbh->aux_connections));
+    break;
+  case 'b':
+    if (kl == strlen("bind_type_guessing") &&
+        strEQ(key, "bind_type_guessing"))
+      result = sv_2mortal(newSViv(imp_dbh->bind_type_guessing));
+    break;
+  case 'e':
+    if (strEQ(key, "errno"))
+      result= sv_2mortal(newSViv((IV)drizzle_con_errno(imp_dbh->con)));
+    else if ( strEQ(key, "error") || strEQ(key, "errmsg"))
+    {
+    /* Note that errmsg is obsolete, as of 2.09! */
+      const char* msg = drizzle_con_error(imp_dbh->con);
+      result= sv_2mortal(newSVpv(msg, strlen(msg)));
+    }
+    /* HELMUT */
+#if defined(sv_utf8_decode)
+    else if (kl == strlen("enable_utf8") && strEQ(key, "enable_utf8"))
+        result = sv_2mortal(newSViv(imp_dbh->enable_utf8));
+#endif
+    break;
+
+  case 'c':
+    if (strEQ(key, "compact_rows"))
+      result= sv_2mortal(boolSV(imp_dbh->compact_rows));
+    else if (strEQ(key, "cancel_threshold"))
+      result= sv_2mortal(my_ulonglong2str(imp_dbh->cancel_threshold));
+    break;
+  case 'd':
+    if (strEQ(key, "dbd_stats"))
+    {
+      HV* hv = newHV();
+      hv_store(
+               hv,
+               "auto_reconnects_ok",
+               strlen("auto_reconnects_ok"),
+               newSViv(imp_dbh->stats.auto_reconnects_ok),
+               0
+              );
+      hv_store(
+               hv,
+               "auto_reconnects_failed",
+               strlen("auto_reconnects_failed"),
+               newSViv(imp_dbh->stats.auto_reconnects_failed),
+               0
+              );
+      hv_store(
+               hv,
+               "aux_connects",
+               strlen("aux_connects"),
+               newSViv(imp_dbh->stats.aux_connects),
+               0
+              );
+      hv_store(
+               hv,
+               "queries_killed",
+               strlen("queries_killed"),
+               newSViv(imp_dbh->stats.queries_killed),
+               0
+              );
+      hv_store(
+               hv,
+               "result_bytes",
+               strlen("result_bytes"),
+               my_ulonglong2str(imp_dbh->stats.result_bytes),
+               0
+              );
+      hv_store(
+               hv,
+               "result_streams",
+               strlen("result_streams"),
+               newSViv(imp_dbh->stats.result_streams),
+               0
+              );
+      hv_store(
+               hv,
+               "result_spills",
+               strlen("result_spills"),
+               newSViv(imp_dbh->stats.result_spills),
+               0
+              );
+
+      result= (newRV_noinc((SV*)hv));
+    }
+    break;
+  case 'i':
+    if (strEQ(key, "insertid"))
+      result= sv_2mortal(my_ulonglong2str(imp_dbh->insert_id));
+    else if (strEQ(key, "in_chunk"))
+      result= sv_2mortal(newSVuv(imp_dbh->in_chunk));
+    break;
+  case 'l':
+    if (strEQ(key, "lazy_columns"))
+      result= sv_2mortal(boolSV(imp_dbh->lazy_columns));
+    break;
+  case 'm':
+    if (strEQ(key, "max_result_bytes"))
+      result= sv_2mortal(my_ulonglong2str(imp_dbh->max_result_bytes));
+    else if (strEQ(key, "max_result_action"))
+      result= sv_2mortal(newSVpv(
+        result_cap_action_names[imp_dbh->max_result_action], 0));
+    else if (strEQ(key, "max_packet_size"))
+      result= sv_2mortal(newSVuv(imp_dbh->max_packet_size));
+    break;
+  case 'p':
+    if (strEQ(key, "protocol_version"))
+      result= sv_2mortal(newSViv(drizzle_con_protocol_version(imp_dbh->con)));
+    break;
+  case 'q':
+    if (strEQ(key, "query_timeout"))
+      result= sv_2mortal(newSVuv(imp_dbh->query_timeout));
+    break;
+  case 'r':
+    if (strEQ(key, "release_fetched"))
+      result= sv_2mortal(boolSV(imp_dbh->release_fetched));
+    break;
+  case 's':
+    if (strEQ(key, "server_version"))
+    {
+      const char* version = drizzle_con_server_version(imp_dbh->con);
+      result= version ?
+        sv_2mortal(newSVpv(version, strlen(version))) : &sv_undef;
+    }
+    else if (strEQ(key, "sock"))
+      result= sv_2mortal(newSViv((IV) imp_dbh->con));
+    else if (strEQ(key, "sockfd"))
+      result= sv_2mortal(newSViv((IV) drizzle_con_fd(imp_dbh->con)));
+    break;
+  case 't':
+    if (kl == 9  &&  strEQ(key, "thread_id")) 
+      result= sv_2mortal(newSViv(drizzle_con_thread_id(imp_dbh->con)));
+    break;
+  }
+
+  if (result== NULL)
+    return Nullsv;
+
+  return result;
+}
+
+
+/* 
+ **************************************************************************
+ *
+ *  Name:    dbd_st_prepare
+ *
+ *  Purpose: Called for preparing an SQL statement; our part of the
+ *           statement handle constructor
+ *
+ *  Input:   sth - statement handle being initialized
+ *           imp_sth - drivers private statement handle data
+ *           statement - pointer to string with SQL statement
+ *           attribs - statement attributes, currently not in use
+ *
+ *  Returns: TRUE for success, FALSE otherwise; do_error will
+ *           be called in the latter case
+ *
+ **************************************************************************/
+int
+dbd_st_prepare(
+  SV *sth,
+  imp_sth_t *imp_sth,
+  char *statement,
+  SV *attribs)
+{
+  int i;
+  SV **svp;
+  D_imp_xxh(sth);
+  D_imp_dbh_from_sth;
+
+
+  imp_sth->done_desc= 0;
+  imp_sth->result= NULL;
+  imp_sth->row= NULL;
+
+  /* Checked before anything is allocated for the statement */
+  svp= DBD_ATTRIB_GET_SVP(attribs,
+                          "drizzle_datetime_as",
+                          strlen("drizzle_datetime_as"));
+  imp_sth->datetime_as= svp ? datetime_as_mode(*svp) : DATETIME_AS_STRING;
+  if (imp_sth->datetime_as < 0)
+  {
+    do_error(sth, JW_ERR_ARGUMENT,
+             "drizzle_datetime_as must be 'string', 'epoch' or 'epoch_ms'",
+             NULL);
+    return FALSE;
+  }
+
+  svp= DBD_ATTRIB_GET_SVP(attribs,
+                          "drizzle_datetime_offset",
+                          strlen("drizzle_datetime_offset"));
+  if (!datetime_offset(svp ? *svp : &PL_sv_undef, &imp_sth->datetime_offset))
+  {
+    do_error(sth, JW_ERR_ARGUMENT,
+             "drizzle_datetime_offset must be seconds or [+-]HH[:MM]", NULL);
+    return FALSE;
+  }
+
+  //(void)drizzle_result_create(imp_dbh->con, imp_dbh->result);
+
+  /* Set default value of 'drizzle_unbuffered_result' attribute for sth from dbh */
+  svp= DBD_ATTRIB_GET_SVP(attribs,
+                          "drizzle_unbuffered_result",
+                          strlen("drizzle_unbuffered_result"));
+
+  imp_sth->unbuffered_result= svp ?
+    SvTRUE(*svp) : imp_dbh->unbuffered_result;
+
+  svp= DBD_ATTRIB_GET_SVP(attribs,
+                          "drizzle_max_result_bytes",
+                          strlen("drizzle_max_result_bytes"));
+  imp_sth->max_result_bytes= svp && SvOK(*svp) ?
+    SvUV(*svp) : imp_dbh->max_result_bytes;
+
+  svp= DBD_ATTRIB_GET_SVP(attribs,
+                          "drizzle_max_result_action",
+                          strlen("drizzle_max_result_action"));
+  imp_sth->max_result_action= svp ?
+    result_cap_action(*svp) : imp_dbh->max_result_action;
+
+  svp= DBD_ATTRIB_GET_SVP(attribs,
+                          "drizzle_compact_rows",
+                          strlen("drizzle_compact_rows"));
+  imp_sth->compact_rows= svp ? SvTRUE(*svp) : imp_dbh->compact_rows;
+
+  svp= DBD_ATTRIB_GET_SVP(attribs,
+                          "drizzle_release_fetched",
+                          strlen("drizzle_release_fetched"));
+  imp_sth->release_fetched= svp ?
+    SvTRUE(*svp) : imp_dbh->release_fetched;
+
+  svp= DBD_ATTRIB_GET_SVP(attribs,
+                          "drizzle_lazy_columns",
+                          strlen("drizzle_lazy_columns"));
+  imp_sth->lazy_columns= svp ? SvTRUE(*svp) : imp_dbh->lazy_columns;
+
+  svp= DBD_ATTRIB_GET_SVP(attribs,
+                          "drizzle_intern_columns",
+                          strlen("drizzle_intern_columns"));
+  imp_sth->intern_columns= svp && SvOK(*svp) ? newSVsv(*svp) : NULL;
+  imp_sth->intern= NULL;
+  imp_sth->intern_seen= NULL;
+  imp_sth->intern_count= 0;
+  imp_sth->intern_sampling= FALSE;
+  imp_sth->fill_row= NULL;
+  imp_sth->fetch_text= NULL;
+  imp_sth->hash_keys= NULL;
+  imp_sth->reuse_hv= NULL;
+
+  svp= DBD_ATTRIB_GET_SVP(attribs,
+                          "drizzle_reuse_hashref",
+                          strlen("drizzle_reuse_hashref"));
+  imp_sth->reuse_hashref= svp ? SvTRUE(*svp) : FALSE;
+
+  svp= DBD_ATTRIB_GET_SVP(attribs,
+                          "drizzle_bind_by_ref",
+                          strlen("drizzle_bind_by_ref"));
+  imp_sth->bind_by_ref= svp ? SvTRUE(*svp) : FALSE;
+
+  svp= DBD_ATTRIB_GET_SVP(attribs,
+                          "drizzle_fetch_size",
+                          strlen("drizzle_fetch_size"));
+  imp_sth->fetch_size= svp && SvOK(*svp) ? SvUV(*svp) : 0;
+
+  svp= DBD_ATTRIB_GET_SVP(attribs,
+                          "drizzle_in_chunk",
+                          strlen("drizzle_in_chunk"));
+  imp_sth->in_chunk= svp && SvOK(*svp) ?
+    SvUV(*svp) : imp_dbh->in_chunk;
+  imp_sth->in_param= -1;
+
+  svp= DBD_ATTRIB_GET_SVP(attribs,
+                          "drizzle_cancel_threshold",
+                          strlen("drizzle_cancel_threshold"));
+  imp_sth->cancel_threshold= svp && SvOK(*svp) ?
+    SvUV(*svp) : imp_dbh->cancel_threshold;
+
+  svp= DBD_ATTRIB_GET_SVP(attribs,
+                          "drizzle_query_timeout",
+                          strlen("drizzle_query_timeout"));
+  imp_sth->query_timeout= svp && SvOK(*svp) ?
+    SvUV(*svp) : imp_dbh->query_timeout;
+  imp_sth->deadline= 0;
+
+  svp= DBD_ATTRIB_GET_SVP(attribs,
+                          "drizzle_write_combine",
+                          strlen("drizzle_write_combine"));
+  write_combine_limits(imp_sth, svp ? *svp : NULL);
+  imp_sth->combine_values= insert_values_row(statement, strlen(statement),
+                                             &imp_sth->combine_values_len);
+  imp_sth->combine_buf= NULL;
+  imp_sth->combine_rows= 0;
+  imp_sth->combine_calls= 0;
+
+  imp_sth->streaming= FALSE;
+  imp_sth->owned_row= NULL;
+  imp_sth->row_lengths= NULL;
+  imp_sth->con= NULL;
+  imp_sth->paged= FALSE;
+  Zero(&imp_sth->rowbuf, 1, rowbuf_t);
+  imp_sth->lazy_svs= NULL;
+  imp_sth->lazy_pending= NULL;
+  imp_sth->lazy_count= 0;
+  imp_sth->lazy_row= NULL;
+
+  for (i= 0; i < AV_ATTRIB_LAST; i++)
+  {
+    imp_sth->av_attr[i]= Nullav;
+    imp_sth->av_attr_generation[i]= 0;
+  }
+  imp_sth->meta_sig= NULL;
+  imp_sth->meta_generation= 0;
+  imp_sth->meta_checked= FALSE;
+
+  /*
+     Clean-up previous result set(s) for sth to prevent
+     'Commands out of sync' error 
+  */
+  // TODO drizzle_con_ready() for conn pooling would be awesome
+  drizzle_st_free_result_sets(sth, imp_sth);
+  //  (void)drizzle_result_create(imp_dbh->con, imp_sth->result);
+
+  DBIc_NUM_PARAMS(imp_sth) = count_params(statement);
+
+  /* Allocate memory for parameters */
+  imp_sth->params= alloc_param(DBIc_NUM_PARAMS(imp_sth));
+  DBIc_IMPSET_on(imp_sth);
+
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBILOGFP, "\t<- dbd_st_prepare\n");
+  return 1;
+}
+
+/***************************************************************************
+ *
+ *  Row buffer helpers
+ *
+ *  Rows read by the driver itself are copied into a chain of chunks, one
+ *  record per row: a NULL bitmap of one bit per column, followed by a 32
+ *  bit length and the data of each column that is not NULL. A record never
+ *  crosses a chunk. The index holds the address of every record, so that
+ *  rows can be revisited in any order. When spilled, the same records go
+ *  to a temporary file, which is mapped back in once the result has been
+ *  read completely; until then the index holds file offsets.
+ *
+ **************************************************************************/
+static void rowbuf_init(rowbuf_t *rb, uint16_t columns)
+{
+  Zero(rb, 1, rowbuf_t);
+  rb->active= TRUE;
+  rb->columns= columns;
+  Newz(908, rb->fields, columns ? columns : 1, char *);
+  Newz(908, rb->lengths, columns ? columns : 1, size_t);
+}
+
+static void rowbuf_free_chunks(rowbuf_t *rb, imp_dbh_t *imp_dbh)
+{
+  rowbuf_chunk_t *chunk, *next;
+
+  for (chunk= rb->head; chunk; chunk= next)
+  {
+    next= chunk->next;
+    Safefree(chunk);
+  }
+  imp_dbh->stats.result_bytes-= rb->bytes;
+  rb->bytes= 0;
+  rb->head= rb->tail= NULL;
+}
+
+static void rowbuf_free(rowbuf_t *rb, imp_dbh_t *imp_dbh)
+{
+  if (!rb->active)
+    return;
+
+  rowbuf_free_chunks(rb, imp_dbh);
+#ifdef DBD_DRIZZLE_HAS_MMAP
+  if (rb->map)
+    munmap(rb->map, rb->map_len);
+#endif
+  if (rb->spill)
+    PerlIO_close(rb->spill);
+  Safefree(rb->index);
+  Safefree(rb->fields);
+  Safefree(rb->lengths);
+  Zero(rb, 1, rowbuf_t);
+}
+
+static size_t rowbuf_record_size(uint16_t columns, drizzle_row_t row,
+                                 size_t *lengths)
+{
+  size_t size= ROWBUF_BITMAP_SIZE(columns);
+  uint16_t i;
+
+  for (i= 0; i < columns; i++)
+    if (row[i])
+      size+= sizeof(uint32_t) + lengths[i];
+  return size;
+}
+
+static void rowbuf_encode(char *ptr, uint16_t columns, drizzle_row_t row,
+                          size_t *lengths)
+{
+  unsigned char *nulls= (unsigned char *) ptr;
+  uint32_t len;
+  uint16_t i;
+
+  Zero(nulls, ROWBUF_BITMAP_SIZE(columns), unsigned char);
+  ptr+= ROWBUF_BITMAP_SIZE(columns);
+
+  for (i= 0; i < columns; i++)
+  {
+    if (!row[i])
+    {
+      nulls[i >> 3]|= 1 << (i & 7);
+      continue;
+    }
+    len= (uint32_t) lengths[i];
+    Copy(&len, ptr, sizeof(len), char);
+    ptr+= sizeof(len);
+    Copy(row[i], ptr, lengths[i], char);
+    ptr+= lengths[i];
+  }
+}
+
+static void rowbuf_index_add(rowbuf_t *rb, char *record)
+{
+  if (rb->rows == rb->index_size)
+  {
+    rb->index_size= rb->index_size ? rb->index_size * 2 : 1024;
+    Renew(rb->index, rb->index_size, char *);
+  }
+  rb->index[rb->rows++]= record;
+}
+
+static void rowbuf_store(rowbuf_t *rb, imp_dbh_t *imp_dbh, drizzle_row_t row,
+                         size_t *lengths, size_t size)
+{
+  rowbuf_chunk_t *chunk= rb->tail;
+  char *record;
+
+  if (!chunk || chunk->size - chunk->used < size)
+  {
+    size_t alloc= size > ROWBUF_CHUNK_SIZE ? size : ROWBUF_CHUNK_SIZE;
+
+    chunk= (rowbuf_chunk_t *) safemalloc(sizeof(rowbuf_chunk_t) + alloc);
+    chunk->next= NULL;
+    chunk->size= alloc;
+    chunk->used= 0;
+    if (rb->tail)
+      rb->tail->next= chunk;
+    else
+      rb->head= chunk;
+    rb->tail= chunk;
+    rb->bytes+= alloc;
+    imp_dbh->stats.result_bytes+= alloc;
+  }
+  record= chunk->data + chunk->used;
+  rowbuf_encode(record, rb->columns, row, lengths);
+  chunk->used+= size;
+  rowbuf_index_add(rb, record);
+}
+
+/*
+  Moves the rows buffered so far into a temporary file, turning their
+  index entries into file offsets; every further row is appended there
+  by rowbuf_write()
+*/
+static int rowbuf_spill(rowbuf_t *rb, imp_dbh_t *imp_dbh)
+{
+  rowbuf_chunk_t *chunk;
+  uint64_t row= 0;
+
+  if (!(rb->spill= PerlIO_tmpfile()))
+    return FALSE;
+  for (chunk= rb->head; chunk; chunk= chunk->next)
+  {
+    if (PerlIO_write(rb->spill, chunk->data, chunk->used) !=
+        (SSize_t) chunk->used)
+      return FALSE;
+    for (; row < rb->rows &&
+           rb->index[row] >= chunk->data &&
+           rb->index[row] < chunk->data + chunk->used; row++)
+      rb->index[row]= (char *) (rb->spill_len + (rb->index[row] - chunk->data));
+    rb->spill_len+= chunk->used;
+  }
+  rowbuf_free_chunks(rb, imp_dbh);
+  return TRUE;
+}
+
+static int rowbuf_write(rowbuf_t *rb, drizzle_row_t row, size_t *lengths,
+                        size_t size)
+{
+  char buf[1024];
+  char *ptr= size > sizeof(buf) ? (char *) safemalloc(size) : buf;
+  int ok;
+
+  rowbuf_encode(ptr, rb->columns, row, lengths);
+  ok= PerlIO_write(rb->spill, ptr, size) == (SSize_t) size;
+  if (ptr != buf)
+    Safefree(ptr);
+  if (ok)
+  {
+    rowbuf_index_add(rb, (char *) rb->spill_len);
+    rb->spill_len+= size;
+  }
+  return ok;
+}
+
+#ifdef DBD_DRIZZLE_HAS_MMAP
+static int rowbuf_map(rowbuf_t *rb)
+{
+  uint64_t row;
+
+  if (PerlIO_flush(rb->spill))
+    return FALSE;
+  if (!rb->spill_len)
+    return TRUE;
+  rb->map= (char *) mmap(NULL, rb->spill_len, PROT_READ, MAP_PRIVATE,
+                         PerlIO_fileno(rb->spill), 0);
+  if (rb->map == (char *) MAP_FAILED)
+  {
+    rb->map= NULL;
+    return FALSE;
+  }
+  rb->map_len= rb->spill_len;
+  for (row= 0; row < rb->rows; row++)
+    rb->index[row]= rb->map + (size_t) rb->index[row];
+  return TRUE;
+}
+#endif
+
+/*
+  Decodes the record of row into rb->fields and rb->lengths
+*/
+static drizzle_row_t rowbuf_row(rowbuf_t *rb, uint64_t row, size_t **lengths)
+{
+  unsigned char *nulls= (unsigned char *) rb->index[row];
+  char *ptr= rb->index[row] + ROWBUF_BITMAP_SIZE(rb->columns);
+  uint32_t len;
+  uint16_t i;
+
+  for (i= 0; i < rb->columns; i++)
+  {
+    if (nulls[i >> 3] & (1 << (i & 7)))
+    {
+      rb->fields[i]= NULL;
+      rb->lengths[i]= 0;
+      continue;
+    }
+    Copy(ptr, &len, sizeof(len), char);
+    ptr+= sizeof(len);
+    rb->fields[i]= ptr;
+    rb->lengths[i]= len;
+    ptr+= len;
+  }
+
+  *lengths= rb->lengths;
+  return rb->fields;
+}
+
+static drizzle_row_t rowbuf_next(rowbuf_t *rb, size_t **lengths)
+{
+  if (rb->rows_read >= rb->rows)
+    return NULL;
+  return rowbuf_row(rb, rb->rows_read++, lengths);
+}
+
+/*
+  Frees the chunks holding only rows that have been handed out already,
+  for drizzle_release_fetched. From then on the rows before the read
+  position cannot be revisited. A mapped spill file is left alone, its
+  pages are clean and the kernel can drop them by itself.
+*/
+static void rowbuf_release_read(rowbuf_t *rb, imp_dbh_t *imp_dbh)
+{
+  rowbuf_chunk_t *chunk;
+  char *next= rb->rows_read < rb->rows ? rb->index[rb->rows_read] : NULL;
+
+  rb->first_row= rb->rows_read;
+  if (rb->map)
+    return;
+
+  while ((chunk= rb->head) &&
+         !(next && next >= chunk->data && next < chunk->data + chunk->used))
+  {
+    rb->head= chunk->next;
+    if (!rb->head)
+      rb->tail= NULL;
+    rb->bytes-= chunk->size;
+    imp_dbh->stats.result_bytes-= chunk->size;
+    Safefree(chunk);
+  }
+}
+
+/*
+  Reads and discards whatever is left of an unbuffered result, so that the
+  connection can be used for the next command
+*/
+static void drizzle_st_drain_result(drizzle_result_st *result)
+{
+  drizzle_return_t ret;
+  drizzle_row_t row;
+
+  while ((row= drizzle_row_buffer(result, &ret)))
+    drizzle_row_free(result, row);
+}
+
+/*
+  drizzle_row_buffer() for the result of imp_sth, within the deadline its
+  drizzle_query_timeout set when the query was sent. On timeout the rest of the result is read and
+  thrown away, ret is DRIZZLE_RETURN_TIMEOUT and do_error has been called.
+*/
+static drizzle_row_t drizzle_st_row_buffer(SV *sth, imp_sth_t *imp_sth,
+                                           drizzle_return_t *ret)
+{
+  D_imp_dbh_from_sth;
+  drizzle_result_st *result= imp_sth->result;
+  drizzle_row_t row;
+
+  if (!imp_sth->query_timeout)
+    return drizzle_row_buffer(result, ret);
+
+  /* Set after the query was sent without a timeout */
+  if (!imp_sth->deadline)
+    imp_sth->deadline= drizzle_deadline(imp_sth->query_timeout);
+  drizzle_add_options(imp_dbh->drizzle, DRIZZLE_NON_BLOCKING);
+  while (!(row= drizzle_row_buffer(result, ret)) &&
+         *ret == DRIZZLE_RETURN_IO_WAIT &&
+         (*ret= drizzle_wait_until(imp_dbh, imp_sth->deadline)) ==
+           DRIZZLE_RETURN_OK)
+    ;
+  drizzle_remove_options(imp_dbh->drizzle, DRIZZLE_NON_BLOCKING);
+
+  if (*ret == DRIZZLE_RETURN_TIMEOUT)
+  {
+    drizzle_timed_out(sth, imp_dbh,
+                      imp_sth->con ? imp_sth->con : imp_dbh->con,
+                      imp_sth->query_timeout);
+    drizzle_st_drain_result(result);
+    imp_sth->streaming= FALSE;
+  }
+  return row;
+}
+
+/***************************************************************************
+ *
+ *  Name:    drizzle_st_buffer_rows
+ *
+ *  Purpose: Reads the rows of a result whose columns have been buffered
+ *           into the driver's row buffer, honouring
+ *           drizzle_max_result_bytes and drizzle_max_result_action.
+ *           Each row from drizzle_row_buffer() is copied and freed at
+ *           once, so libdrizzle's per row allocations never pile up
+ *
+ *  Returns: TRUE for success, FALSE otherwise; do_error will
+ *           be called in the latter case
+ *
+ **************************************************************************/
+static int drizzle_st_buffer_rows(SV *sth, imp_sth_t *imp_sth)
+{
+  D_imp_dbh_from_sth;
+  D_imp_xxh(sth);
+  drizzle_result_st *result= imp_sth->result;
+  rowbuf_t *rb= &imp_sth->rowbuf;
+  drizzle_return_t ret;
+  drizzle_row_t row;
+  size_t *lengths;
+  size_t size;
+  int ok;
+
+  rowbuf_init(rb, drizzle_result_column_count(result));
+
+  while ((row= drizzle_st_row_buffer(sth, imp_sth, &ret)))
+  {
+    lengths= drizzle_row_field_sizes(result);
+    size= rowbuf_record_size(rb->columns, row, lengths);
+
+    if (!rb->spill && imp_sth->max_result_bytes && !imp_sth->paged &&
+        rb->bytes + size > imp_sth->max_result_bytes)
+    {
+      switch (imp_sth->max_result_action) {
+      case RESULT_CAP_STREAM:
+        /* Keep this row too, the rest is read by dbd_st_fetch */
+        rowbuf_store(rb, imp_dbh, row, lengths, size);
+        drizzle_row_free(result, row);
+        imp_sth->streaming= TRUE;
+        imp_dbh->stats.result_streams++;
+        if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+          PerlIO_printf(DBILOGFP,
+                        "\t\tresult cap reached after %llu rows, streaming\n",
+                        (unsigned long long) rb->rows);
+        return TRUE;
+
+      case RESULT_CAP_SPILL:
+        if (!rowbuf_spill(rb, imp_dbh))
+        {
+          drizzle_row_free(result, row);
+          drizzle_st_drain_result(result);
+          rowbuf_free(rb, imp_dbh);
+          do_error(sth, JW_ERR_MEM,
+                   "Could not spill result to a temporary file", NULL);
+          return FALSE;
+        }
+        imp_dbh->stats.result_spills++;
+        if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+          PerlIO_printf(DBILOGFP,
+                        "\t\tresult cap reached after %llu rows, spilling\n",
+                        (unsigned long long) rb->rows);
+        break;
+
+      default:
+        drizzle_row_free(result, row);
+        drizzle_st_drain_result(result);
+        rowbuf_free(rb, imp_dbh);
+        do_error(sth, JW_ERR_RESULT_TOO_LARGE,
+                 "Result exceeds drizzle_max_result_bytes", "HY001");
+        return FALSE;
+      }
+    }
+
+    if (rb->spill)
+      ok= rowbuf_write(rb, row, lengths, size);
+    else
+    {
+      rowbuf_store(rb, imp_dbh, row, lengths, size);
+      ok= TRUE;
+    }
+    drizzle_row_free(result, row);
+
+    if (!ok)
+    {
+      drizzle_st_drain_result(result);
+      rowbuf_free(rb, imp_dbh);
+      do_error(sth, JW_ERR_MEM,
+               "Could not spill result to a temporary file", NULL);
+      return FALSE;
+    }
+  }
+
+  if (ret != DRIZZLE_RETURN_OK)
+  {
+    rowbuf_free(rb, imp_dbh);
+    if (ret != DRIZZLE_RETURN_TIMEOUT)
+      do_error(sth, drizzle_result_error_code(result),
+               drizzle_result_error(result), drizzle_result_sqlstate(result));
+    return FALSE;
+  }
+
+#ifdef DBD_DRIZZLE_HAS_MMAP
+  if (rb->spill && !rowbuf_map(rb))
+  {
+    rowbuf_free(rb, imp_dbh);
+    do_error(sth, JW_ERR_MEM,
+             "Could not map spilled result", NULL);
+    return FALSE;
+  }
+#endif
+  return TRUE;
+}
+
+/***************************************************************************
+ *
+ *  Name:    drizzle_st_next_row
+ *
+ *  Purpose: Returns the next row of the current result, wherever it
+ *           lives: a row read ahead by dbd_st_more_results, the driver's
+ *           row buffer, the connection (when streaming) or libdrizzle's
+ *           buffered result
+ *
+ *  Inputs:  sth - statement handle
+ *           imp_sth - driver's private statement handle
+ *           lengths - where to store the field lengths of the row
+ *           ret - set to the libdrizzle status when reading the connection
+ *
+ *  Returns: The row, or NULL at the end of the result or on error
+ *
+ **************************************************************************/
+static drizzle_row_t drizzle_st_next_row(SV *sth, imp_sth_t *imp_sth,
+                                         size_t **lengths,
+                                         drizzle_return_t *ret)
+{
+  drizzle_row_t row;
+
+  *ret= DRIZZLE_RETURN_OK;
+
+  if ((row= imp_sth->row))
+  {
+    imp_sth->row= NULL;
+    *lengths= imp_sth->row_lengths;
+    return row;
+  }
+
+  if (imp_sth->rowbuf.active &&
+      (row= rowbuf_next(&imp_sth->rowbuf, lengths)))
+    return row;
+
+  if (!imp_sth->streaming)
+  {
+    if ((row= drizzle_row_next(imp_sth->result)))
+      *lengths= drizzle_row_field_sizes(imp_sth->result);
+    return row;
+  }
+
+  if (imp_sth->owned_row)
+  {
+    drizzle_row_free(imp_sth->result, imp_sth->owned_row);
+    imp_sth->owned_row= NULL;
+  }
+  if ((row= drizzle_st_row_buffer(sth, imp_sth, ret)))
+  {
+    imp_sth->owned_row= row;
+    *lengths= drizzle_row_field_sizes(imp_sth->result);
+  }
+  return row;
+}
+
+/*
+  Finishes a streamed result that has not been read to the end. The rows
+  left have to be read off the connection before it can be used again;
+  after drizzle_cancel_threshold of them the server is told to stop
+  sending, and what is left to read is the error packet of the killed
+  query.
+*/
+static void drizzle_st_cancel_result(SV *sth, imp_sth_t *imp_sth)
+{
+  D_imp_dbh_from_sth;
+  drizzle_result_st *result= imp_sth->result;
+  drizzle_con_st *con= imp_sth->con ? imp_sth->con : imp_dbh->con;
+  drizzle_return_t ret;
+  drizzle_row_t row;
+  uint64_t skipped= 0;
+  bool killed= FALSE;
 
-          if ((svp = hv_fetch(hv, "drizzle_ssl_client_cert", 21, FALSE)) &&
-              *svp)
-            client_cert = SvPV(*svp, lna);
+  while ((row= drizzle_row_buffer(result, &ret)))
+  {
+    drizzle_row_free(result, row);
+    if (!killed && imp_sth->cancel_threshold &&
+        ++skipped >= imp_sth->cancel_threshold)
+    {
+      /* Only try once, if it fails we simply read on */
+      (void) drizzle_db_kill_query(sth, imp_dbh, con);
+      killed= TRUE;
+    }
+  }
+}
 
-          if ((svp = hv_fetch(hv, "drizzle_ssl_ca_file", 17, FALSE)) &&
-              *svp)
-            ca_file = SvPV(*svp, lna);
+/***************************************************************************
+ * Name: dbd_st_free_result_sets
+ *
+ * Purpose: Clean-up single or multiple result sets (if any)
+ *
+ * Inputs: sth - Statement handle
+ *         imp_sth - driver's private statement handle
+ *
+ * Returns: 1 ok
+ *          0 error
+ *************************************************************************/
+int drizzle_st_free_result_sets (SV * sth, imp_sth_t * imp_sth)
+{
+  D_imp_dbh_from_sth;
+  D_imp_xxh(sth);
+  int next_result_rc= -1;
+  drizzle_row_t row;
+  drizzle_return_t ret;
 
-          if ((svp = hv_fetch(hv, "drizzle_ssl_ca_path", 17, FALSE)) &&
-              *svp)
-            ca_path = SvPV(*svp, lna);
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBILOGFP, "\t>- dbd_st_free_result_sets\n");
 
-          if ((svp = hv_fetch(hv, "drizzle_ssl_cipher", 16, FALSE)) &&
-              *svp)
-            cipher = SvPV(*svp, lna);
+  /* Nice and simple , thanks Eric */
+  if (imp_sth->result)
+  {
+    drizzle_st_lazy_done(imp_sth, TRUE);
+    if (imp_sth->owned_row)
+      drizzle_row_free(imp_sth->result, imp_sth->owned_row);
+    if (imp_sth->streaming)
+      drizzle_st_cancel_result(sth, imp_sth);
+    drizzle_result_free(imp_sth->result);
+    imp_sth->result= NULL;
+  }
+  imp_sth->owned_row= NULL;
+  imp_sth->row= NULL;
+  imp_sth->streaming= FALSE;
+  imp_sth->fill_row= NULL;
+  rowbuf_free(&imp_sth->rowbuf, imp_dbh);
+  if (imp_sth->con)
+    drizzle_db_own_con(imp_dbh, imp_sth->con, imp_sth, NULL);
 
-          drizzleclient_ssl_set(con, client_key, client_cert, ca_file,
-                          ca_path, cipher);
+  return 1;
+}
 
-          drizzleclient_options(con,
-                          DRIZZLE_OPT_SSL_VERIFY_SERVER_CERT,
-                          &ssl_verify_true);
 
-          client_flag |= CLIENT_SSL;
-        }
-      }
-#endif
-    }
+/***************************************************************************
+ *
+ *  Name:    drizzle_st_meta_check
+ *
+ *  Purpose: Makes meta_sig the column metadata of res: name, table, type,
+ *           flags, size and decimals of each column. When it differs from
+ *           that of the last result, meta_generation goes up, so the
+ *           array attributes cached for other columns are built again;
+ *           otherwise a re-execute keeps using them.
+ *
+ *  Input:   imp_sth - drivers private statement handle data
+ *           res - the current result
+ *
+ **************************************************************************/
+static void drizzle_st_meta_check(imp_sth_t *imp_sth, drizzle_result_st *res)
+{
+  drizzle_column_st *col;
+  SV *sig= newSVpvn("", 0);
+  const char *str;
+  long info[4];
+
+  drizzle_column_seek(res, 0);
+  while ((col= drizzle_column_next(res)))
+  {
+    str= drizzle_column_name(col);
+    sv_catpvn(sig, str, strlen(str) + 1);
+    str= drizzle_column_table(col);
+    sv_catpvn(sig, str, strlen(str) + 1);
+    info[0]= (long) drizzle_column_type(col);
+    info[1]= (long) drizzle_column_flags(col);
+    info[2]= (long) drizzle_column_size(col);
+    info[3]= (long) drizzle_column_decimals(col);
+    sv_catpvn(sig, (char*) info, sizeof(info));
   }
 
-  //client_flag|= CLIENT_MULTI_RESULTS;
-  // XXX not sure about this logic...
-  if (imp_dbh->con != NULL)
+  if (imp_sth->meta_sig && sv_eq(sig, imp_sth->meta_sig))
+    SvREFCNT_dec(sig);
+  else
   {
-    imp_dbh->con= drizzle_con_add_tcp(drizzle, NULL, host, portNr,
-                                      user, password, dbname,
-                                      mysql_protocol ?
-                                        DRIZZLE_CON_MYSQL : DRIZZLE_CON_NONE);
+    if (imp_sth->meta_sig)
+      SvREFCNT_dec(imp_sth->meta_sig);
+    imp_sth->meta_sig= sig;
+    imp_sth->meta_generation++;
   }
-  ret = drizzle_con_connect(imp_dbh->con);
+  imp_sth->meta_checked= TRUE;
+}
 
-  /* XXX Until we understand this better.. commented out
-  if (result)
+/*
+  Marks the cached array attributes as not checked against a new result.
+  Those that depend on the rows, not just the columns, are freed.
+*/
+static void drizzle_st_meta_stale(imp_sth_t *imp_sth)
+{
+  static const int row_attribs[]= { AV_ATTRIB_MAX_LENGTH, AV_ATTRIB_PRECISION };
+  int i, what;
+
+  imp_sth->meta_checked= FALSE;
+  for (i= 0; i < (int) (sizeof(row_attribs) / sizeof(row_attribs[0])); i++)
   {
-    /
-      we turn off Mysql's auto reconnect and handle re-connecting ourselves
-      so that we can keep track of when this happens.
-    * 
-    result->reconnect=0;
+    what= row_attribs[i];
+    if (imp_sth->av_attr[what])
+      SvREFCNT_dec(imp_sth->av_attr[what]);
+    imp_sth->av_attr[what]= Nullav;
   }
-  */
-  return ret == DRIZZLE_RETURN_OK ? TRUE : FALSE;
 }
 
 /*
-  safe_hv_fetch
+  Handle attributes that hold on to a result set, deleted by
+  dbd_st_more_results when the next one starts
 */
-char *safe_hv_fetch(HV *hv, const char *name, int name_length)
+static const char *const rowset_attribs[]= {
+  "NAME", "NULLABLE", "NUM_OF_FIELDS", "PRECISION", "SCALE", "TYPE",
+  "drizzle_insertid", "drizzle_is_auto_increment", "drizzle_is_blob",
+  "drizzle_is_key", "drizzle_is_num", "drizzle_is_pri_key",
+  "drizzle_length", "drizzle_max_length", "drizzle_table", "drizzle_type",
+  "drizzle_type_name", "drizzle_warning_count", NULL
+};
+
+/***************************************************************************
+ * Name: dbd_st_more_results
+ *
+ * Purpose: Move onto the next result set (if any)
+ *
+ * Inputs: sth - Statement handle
+ *         imp_sth - driver's private statement handle
+ *
+ * Returns: 1 if there are more results sets
+ *          0 if there are not
+ *         -1 for errors.
+ *************************************************************************/
+int dbd_st_more_results(SV* sth, imp_sth_t* imp_sth)
 {
-  SV** svp;
-  STRLEN len;
-  char *res= NULL;
+  D_imp_dbh_from_sth;
+  D_imp_xxh(sth);
+
+  drizzle_return_t ret;
+  drizzle_con_st* con = imp_dbh->con;
+  int more_rows;
+  int i;
+
+  if (!SvROK(sth) || SvTYPE(SvRV(sth)) != SVt_PVHV)
+    croak("Expected hash array");
+
+
+  /*
+   *  Cached array attributes are checked against the next result
+   */
+  drizzle_st_meta_stale(imp_sth);
+
+  /* Drop a row read ahead earlier, then read ahead the next one */
+  drizzle_st_lazy_done(imp_sth, FALSE);
+  imp_sth->fill_row= NULL;
+  imp_sth->row= NULL;
+  imp_sth->row= drizzle_st_next_row(sth, imp_sth, &imp_sth->row_lengths, &ret);
+
+  if (ret != DRIZZLE_RETURN_OK)
+  {
+    more_rows = -1;
+    if (ret != DRIZZLE_RETURN_TIMEOUT)
+      do_error(sth, drizzle_result_error_code(imp_sth->result), drizzle_result_error(imp_sth->result),
+              drizzle_result_sqlstate(imp_sth->result));
+  }
+  else
+  {
+    more_rows = imp_sth->row != NULL ? 1 : 0;
+  }
+
+  if (more_rows <= 0)
+  {
+    /* No more pending result set(s)*/
+    if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+      PerlIO_printf(DBILOGFP,
+		    "\n      <- dbs_st_more_rows no more results\n");
+    return 0;
+  }
+
+
+  if (DBIc_ACTIVE(imp_sth))
+    DBIc_ACTIVE_off(imp_sth);
+
+  if (imp_sth->row) {
+    /* We have a new rowset */
+    /* delete cached handle attributes */
+    for (i= 0; rowset_attribs[i]; i++)
+      hv_delete((HV*)SvRV(sth), rowset_attribs[i],
+                strlen(rowset_attribs[i]), G_DISCARD);
+
+    /* Adjust NUM_OF_FIELDS - which also adjusts the row buffer size */
+    DBIc_NUM_FIELDS(imp_sth)= 0; /* for DBI <= 1.53 */
+    DBIS->set_attr_k(sth, sv_2mortal(newSVpvn("NUM_OF_FIELDS",13)), 0,
+        sv_2mortal(newSViv(drizzle_result_column_count(imp_sth->result)))
+    );
+
+    DBIc_ACTIVE_on(imp_sth);
+
+    imp_sth->done_desc = 0;
+    return 1;
+  } else {
+    return 0;
+  } 
+}
+/**************************************************************************
+ *
+ *  Name:    drizzle_st_internal_execute
+ *
+ *  Purpose: Internal version for executing a statement, called both from
+ *           within the "do" and the "execute" method.
+ *
+ *  Inputs:  h - object handle, for storing error messages
+ *           statement - query being executed
+ *           attribs - statement attributes, currently ignored
+ *           num_params - number of parameters being bound
+ *           params - parameter array
+ *           result - where to store results, if any
+ *           con - connection to the database
+ *
+ **************************************************************************/
+
+
+uint64_t drizzle_st_internal_execute(
+                                       SV *h, /* could be sth or dbh */
+                                       SV *statement,
+                                       SV *attribs,
+                                       int num_params,
+                                       imp_sth_ph_t *params,
+                                       drizzle_result_st **result,
+                                       drizzle_con_st *con,
+                                       int unbuffered_result
+                                      )
+{
+  bool bind_type_guessing= false;
+  STRLEN slen;
+  char *sbuf = SvPV(statement, slen);
+  char *table;
+  char *query;
+  char *salloc;
+  int htype;
+  int errno;
+  uint64_t rows= 0;
+  drizzle_return_t ret;
+  imp_dbh_t *timeout_dbh= NULL;
+  unsigned long timeout= 0;
+  double deadline= 0;
+  /* thank you DBI.c for this info! */
+  D_imp_xxh(h);
+  attribs= attribs;
+
+  htype= DBIc_TYPE(imp_xxh);
+  /*
+    It is important to import imp_dbh properly according to the htype
+    that it is! Also, one might ask why bind_type_guessing is assigned
+    in each block. Well, it's because D_imp_ macros called in these
+    blocks make it so imp_dbh is not "visible" or defined outside of the
+    if/else (when compiled, it fails for imp_dbh not being defined).
+  */
+  /* h is a dbh */
+  if (htype==DBIt_DB)
+  {
+    D_imp_dbh(h);
+    /* if imp_dbh is not available, it causes segfault (proper) on OpenBSD */
+    if (imp_dbh && imp_dbh->bind_type_guessing)
+      bind_type_guessing= imp_dbh->bind_type_guessing;
+    else
+      bind_type_guessing= 0;
+    timeout_dbh= imp_dbh;
+    timeout= imp_dbh ? imp_dbh->query_timeout : 0;
+  }
+  /* h is a sth */
+  else
+  {
+    D_imp_sth(h);
+    D_imp_dbh_from_sth;
+    /* if imp_dbh is not available, it causes segfault (proper) on OpenBSD */
+    if (imp_dbh)
+      bind_type_guessing= imp_dbh->bind_type_guessing;
+    else
+      bind_type_guessing=0;
+    timeout_dbh= imp_dbh;
+    timeout= imp_dbh ? imp_sth->query_timeout : 0;
+  }
+
+  if (timeout_dbh && !drizzle_db_sync_con(timeout_dbh, con))
+  {
+    do_error(h, drizzle_con_error_code(con), drizzle_con_error(con),
+             drizzle_con_sqlstate(con));
+    return -2;
+  }
+
+  salloc= parse_params(con,
+                       sbuf,
+                       &slen,
+                       params,
+                       num_params,
+                       bind_type_guessing);
 
-  if ((svp= hv_fetch(hv, name, name_length, FALSE)))
+  if (salloc)
   {
-    res= SvPV(*svp, len);
-    if (!len)
-      res= NULL;
+    sbuf= salloc;
+    if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+      PerlIO_printf(DBILOGFP, "Binding parameters: %s\n", sbuf);
   }
-  return res;
-}
 
-/*
- Frontend for drizzle_dr_connect
-*/
-int my_login(SV* dbh, imp_dbh_t *imp_dbh)
-{
-  SV* sv;
-  HV* hv;
-  char* dbname;
-  char* host;
-  char* port;
-  char* user;
-  char* password;
-  char* drizzle_socket;
-  D_imp_xxh(dbh);
+  if (slen >= 11 && (!strncmp(sbuf, "listfields ", 11) ||
+                     !strncmp(sbuf, "LISTFIELDS ", 11)))
+  {
+    /* remove pre-space */
+    slen-= 10;
+    sbuf+= 10;
+    while (slen && isspace(*sbuf)) { --slen;  ++sbuf; }
 
-#define TAKE_IMP_DATA_VERSION 1
-#if TAKE_IMP_DATA_VERSION
-  if (DBIc_has(imp_dbh, DBIcf_IMPSET))
-  { /* eg from take_imp_data() */
-    if (DBIc_has(imp_dbh, DBIcf_ACTIVE))
+    if (!slen)
     {
-      if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-        PerlIO_printf(DBILOGFP, "my_login skip connect\n");
-      /* tell our parent we've adopted an active child */
-      ++DBIc_ACTIVE_KIDS(DBIc_PARENT_COM(imp_dbh));
-      return TRUE;
+      do_error(h, JW_ERR_QUERY, "Missing table name" ,NULL);
+      return -2;
+    }
+    if (!(table= malloc(slen+1)))
+    {
+      do_error(h, JW_ERR_MEM, "Out of memory" ,NULL);
+      return -2;
     }
-    if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-      PerlIO_printf(DBILOGFP,
-                    "my_login IMPSET but not ACTIVE so connect not skipped\n");
-  }
-#endif
 
-  sv = DBIc_IMP_DATA(imp_dbh);
+    strncpy(table, sbuf, slen);
+    sbuf= table;
 
-  if (!sv  ||  !SvROK(sv))
-    return FALSE;
+    while (slen && !isspace(*sbuf))
+    {
+      --slen;
+      ++sbuf;
+    }
+    *sbuf++= '\0';
 
-  hv = (HV*) SvRV(sv);
-  if (SvTYPE(hv) != SVt_PVHV)
-    return FALSE;
+    if (!(query= malloc(strlen("SHOW COLUMNS FROM ``") + 1 + strlen(table)))) {
+      do_error(h, JW_ERR_MEM, "Out of memory", NULL);
+      return -2;
+    }
+    sprintf(query,"SHOW COLUMNS FROM `%s`", table);
+    *result= drizzle_query_str(con, NULL, query, &ret);
 
-  host=		safe_hv_fetch(hv, "host", 4);
-  port=		safe_hv_fetch(hv, "port", 4);
-  user=		safe_hv_fetch(hv, "user", 4);
-  password=	safe_hv_fetch(hv, "password", 8);
-  dbname=	safe_hv_fetch(hv, "database", 8);
-  drizzle_socket=	safe_hv_fetch(hv, "drizzle_socket", 14);
+    free(query);
 
-  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-    PerlIO_printf(DBILOGFP,
-		  "imp_dbh->my_login : dbname = %s, uid = %s, pwd = %s," \
-		  "host = %s, port = %s\n",
-		  dbname ? dbname : "NULL",
-		  user ? user : "NULL",
-		  password ? password : "NULL",
-		  host ? host : "NULL",
-		  port ? port : "NULL");
+    free(table);
 
-  if (!imp_dbh->con) {
-     Newz(908, imp_dbh->con, 1, drizzle_con_st);
+    if (!(*result) || ret != DRIZZLE_RETURN_OK)
+    {
+      do_error(h, drizzle_con_errno(con), drizzle_con_error(con)
+               ,drizzle_con_sqlstate(con));
+      return -2;
+    }
+
+    return 0;
   }
-  return drizzle_dr_connect(
-                                         dbh,
-                                         imp_dbh->con,
-                                         drizzle_socket,
-                                         host,
-                                         port,
-                                         user,
-                                         password,
-                                         dbname,
-                                         imp_dbh);
-}
 
+  if (timeout)
+  {
+    deadline= drizzle_deadline(timeout);
+    drizzle_add_options(timeout_dbh->drizzle, DRIZZLE_NON_BLOCKING);
+  }
+  /* The rows of the result are read within the same deadline */
+  if (htype == DBIt_ST)
+  {
+    D_imp_sth(h);
+    imp_sth->deadline= deadline;
+  }
 
-/**************************************************************************
- *
- *  Name:    dbd_db_login6
- *
- *  Purpose: Called for connecting to a database and logging in.
- *
- *  Input:   dbh - database handle being initialized
- *           imp_dbh - drivers private database handle data
- *           dbname - the database we want to log into; may be like
- *               "dbname:host" or "dbname:host:port"
- *           user - user name to connect as
- *           password - passwort to connect with
- *           attr - the attributes like AutoCommit and RaiseError
- *
- *  Returns: TRUE for success, FALSE otherwise; do_error has already
- *           been called in the latter case
- *
- **************************************************************************/
+  *result = (drizzle_result_st *)drizzle_query(con, NULL, sbuf, slen, &ret);
+  while (ret == DRIZZLE_RETURN_IO_WAIT &&
+         (ret= drizzle_wait_until(timeout_dbh, deadline)) == DRIZZLE_RETURN_OK)
+    *result = (drizzle_result_st *)drizzle_query(con, NULL, sbuf, slen, &ret);
 
-int dbd_db_login6(SV* dbh, imp_dbh_t* imp_dbh, char* dbname, char* user,
-                 char* password, SV* attr) {
-#ifdef dTHR
-  dTHR;
-#endif
-  D_imp_xxh(dbh);
+  if (ret == DRIZZLE_RETURN_TIMEOUT)
+  {
+    drizzle_timed_out(h, timeout_dbh, con, timeout);
+    /* Finish the command, the killed query answers with an error */
+    *result = (drizzle_result_st *)drizzle_query(con, NULL, sbuf, slen, &ret);
+    if (ret == DRIZZLE_RETURN_OK)
+      ret= drizzle_result_buffer(*result);
+    drizzle_timed_out_finish(h, con, ret);
+    if (*result)
+      drizzle_result_free(*result);
+    *result= NULL;
+    Safefree(salloc);
+    return -2;
+  }
+  if (ret != DRIZZLE_RETURN_OK) {
+    if (timeout)
+      drizzle_remove_options(timeout_dbh->drizzle, DRIZZLE_NON_BLOCKING);
+    Safefree(salloc);
 
-  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-    PerlIO_printf(DBILOGFP,
-                  "imp_dbh->connect: dsn = %s, uid = %s, pwd = %s\n",
-                  dbname ? dbname : "NULL",
-                  user ? user : "NULL",
-                  password ? password : "NULL");
+    /*do_error(h, drizzle_con_errno(con), drizzle_con_error(con),
+		    drizzle_con_sqlstate(con));
+*/
 
-  // TODO: use drizzle_con_ready()
-  imp_dbh->drizzle= &imp_dbh->_drizzle;
-  (void) drizzle_create(imp_dbh->drizzle);
-  /* let's check return value ? */
+    do_error(h, drizzle_con_error_code(con), drizzle_con_error(con),
+		    drizzle_con_sqlstate(con));
 
-    imp_dbh->con= NULL;
-  /*imp_dbh->con= drizzle_con_create(imp_dbh->drizzle, NULL);
-  if (imp_dbh->con == NULL) {
-    do_error(dbh, drizzle_errno(imp_dbh->drizzle), drizzle_error(imp_dbh->drizzle),
-             drizzle_sqlstate(imp_dbh->drizzle));
-    return FALSE;
-    }*/
 
-  imp_dbh->stats.auto_reconnects_ok= 0;
-  imp_dbh->stats.auto_reconnects_failed= 0;
-  imp_dbh->bind_type_guessing= FALSE;
-  /* Safer we flip this to TRUE perl side if we detect a mod_perl env. */
-  imp_dbh->auto_reconnect = FALSE;
-  imp_dbh->insert_id=0;
+    if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+      PerlIO_printf(DBILOGFP, "IGNORING ERROR errno %d\n", errno);
+    return -2;
+  }
+  if (timeout_dbh && is_session_statement(sbuf, slen))
+    drizzle_db_log_session(timeout_dbh, con, sbuf, slen);
+  Safefree(salloc);
 
-  /* HELMUT */
-#if defined(sv_utf8_decode)
-  imp_dbh->enable_utf8 = FALSE;  /* initialize drizzle_enable_utf8 */
-#endif
+  /** Store the result from the Query */
+  do
+  {
+    if (!unbuffered_result) {
+      ret = drizzle_result_buffer(*result);
+    } else {
+      /* Just buffer columns */
+      ret = drizzle_column_buffer(*result);
+    }
+  } while (ret == DRIZZLE_RETURN_IO_WAIT &&
+           (ret= drizzle_wait_until(timeout_dbh, deadline)) == DRIZZLE_RETURN_OK);
 
-  if (!my_login(dbh, imp_dbh))
+  if (timeout)
+    drizzle_remove_options(timeout_dbh->drizzle, DRIZZLE_NON_BLOCKING);
+
+  if (ret == DRIZZLE_RETURN_TIMEOUT)
   {
-    do_error(dbh, drizzle_con_errno(imp_dbh->con),
-             drizzle_con_error(imp_dbh->con) ,drizzle_con_sqlstate(imp_dbh->con));
-    return FALSE;
+    drizzle_timed_out(h, timeout_dbh, con, timeout);
+    if (!unbuffered_result)
+      ret= drizzle_result_buffer(*result);
+    else if ((ret= drizzle_column_buffer(*result)) == DRIZZLE_RETURN_OK)
+      drizzle_st_drain_result(*result);
+    drizzle_timed_out_finish(h, con, ret);
+    drizzle_result_free(*result);
+    *result= NULL;
+    return -2;
   }
 
-  /*
-   *  Tell DBI, that dbh->disconnect should be called for this handle
- */
-  DBIc_ACTIVE_on(imp_dbh);
+  if (ret != DRIZZLE_RETURN_OK) 
+    do_error(h, drizzle_result_error_code(*result), drizzle_result_error(*result)
+             ,drizzle_result_sqlstate(*result));
+      
 
-  /* Tell DBI, that dbh->destroy should be called for this handle */
-  DBIc_on(imp_dbh, DBIcf_IMPSET);
+  /* Best way to be sure we return the right number if possible */
+  rows = drizzle_result_row_count(*result);
+  if (!rows)
+    rows = drizzle_result_affected_rows(*result);
 
-  return TRUE;
+  return(rows);
 }
 
 
-/***************************************************************************
- *
- *  Name:    dbd_db_commit
- *           dbd_db_rollback
- *
- *  Purpose: You guess what they should do. 
- *
- *  Input:   dbh - database handle being commited or rolled back
- *           imp_dbh - drivers private database handle data
- *
- *  Returns: TRUE for success, FALSE otherwise; do_error has already
- *           been called in the latter case
- *
- **************************************************************************/
-
-int
-dbd_db_commit(SV* dbh, imp_dbh_t* imp_dbh)
+/*
+  Runs the statement with the current parameters
+*/
+static uint64_t drizzle_st_run(SV *sth, imp_sth_t *imp_sth, SV *statement)
 {
-  drizzle_result_st res;
-  drizzle_return_t ret;
+  return drizzle_st_internal_execute(sth, statement, NULL,
+                                     DBIc_NUM_PARAMS(imp_sth),
+                                     imp_sth->params,
+                                     &imp_sth->result,
+                                     imp_sth->con,
+                                     imp_sth->unbuffered_result ||
+                                       imp_sth->compact_rows ||
+                                       imp_sth->release_fetched ||
+                                       imp_sth->max_result_bytes);
+}
 
-  if (DBIc_has(imp_dbh, DBIcf_AutoCommit))
-    return FALSE;
+/*
+  With drizzle_in_chunk, the longest list bound that has more than
+  chunk values is sent chunk values at a time, by running the statement
+  once per chunk. Sets up the first one.
+*/
+static void drizzle_st_plan_in_chunks(imp_sth_t *imp_sth, unsigned long chunk)
+{
+  I32 i, longest= (I32) chunk;
+  imp_sth_ph_t *ph;
+  AV *list;
 
-  drizzle_query_str(imp_dbh->con, &res, "COMMIT", &ret);
-  if (ret != DRIZZLE_RETURN_OK) {
-    do_error(dbh, drizzle_result_error_code(&res), drizzle_result_error(&res)
-             ,drizzle_result_sqlstate(&res));
-    return FALSE;
-  }
-  drizzle_result_free(&res);
-  return TRUE;
+  imp_sth->in_param= -1;
+  for (i= 0, ph= imp_sth->params; i < DBIc_NUM_PARAMS(imp_sth); i++, ph++)
+  {
+    ph->list_offset= 0;
+    ph->list_count= 0;
+    if (chunk && (list= param_list(ph->value)) && av_len(list) + 1 > longest)
+    {
+      longest= av_len(list) + 1;
+      imp_sth->in_param= i;
+    }
+  }
+  if (imp_sth->in_param >= 0)
+    imp_sth->params[imp_sth->in_param].list_count= (I32) chunk;
 }
 
 /*
- dbd_db_rollback
+  Moves on to the next drizzle_in_chunk part, FALSE after the last one
 */
-int dbd_db_rollback(SV* dbh, imp_dbh_t* imp_dbh) {
-  drizzle_result_st res;
-  drizzle_return_t ret;
+static bool drizzle_st_next_in_chunk(imp_sth_t *imp_sth)
+{
+  imp_sth_ph_t *ph;
 
-  /* croak, if not in AutoCommit mode */
-  if (DBIc_has(imp_dbh, DBIcf_AutoCommit))
+  if (imp_sth->in_param < 0)
     return FALSE;
-
-  drizzle_query_str(imp_dbh->con, &res, "ROLLBACK", &ret);
-  if (ret != DRIZZLE_RETURN_OK) {
-    do_error(dbh, drizzle_result_error_code(&res), drizzle_result_error(&res)
-             ,drizzle_result_sqlstate(&res));
+  ph= imp_sth->params + imp_sth->in_param;
+  ph->list_offset+= ph->list_count;
+  if (ph->list_offset > av_len(param_list(ph->value)))
+  {
+    imp_sth->in_param= -1;
     return FALSE;
   }
-  drizzle_result_free(&res);
   return TRUE;
 }
 
 /*
- ***************************************************************************
- *
- *  Name:    dbd_db_disconnect
- *
- *  Purpose: Disconnect a database handle from its database
- *
- *  Input:   dbh - database handle being disconnected
- *           imp_dbh - drivers private database handle data
- *
- *  Returns: TRUE for success, FALSE otherwise; do_error has already
- *           been called in the latter case
- *
- **************************************************************************/
-
-int dbd_db_disconnect(SV* dbh, imp_dbh_t* imp_dbh)
+  Tells whether statement is a SELECT that can be read a page at a time by
+  appending a LIMIT clause: it must have an ORDER BY outside of
+  parentheses, so pages follow each other, and must not have a LIMIT of
+  its own, nor be a SELECT ... INTO, FOR UPDATE or LOCK IN SHARE MODE, nor
+  end in a line comment. Words in quotes and C style comments are skipped.
+*/
+static bool is_pageable_select(const char *sql, STRLEN len)
 {
-#ifdef dTHR
-    dTHR;
-#endif
-    D_imp_xxh(dbh);
+  static const char *stop_words[]= { "limit", "into", "for", "lock",
+                                     "procedure", NULL };
+  const char *end= sql + len, *word;
+  bool first= TRUE, order= FALSE, order_by= FALSE;
+  int depth= 0, i;
 
-    /* We assume that disconnect will always work       */
-    /* since most errors imply already disconnected.    */
-    DBIc_ACTIVE_off(imp_dbh);
-    if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-        PerlIO_printf(DBILOGFP, "imp_dbh->con: %lx\n",
-		      (long) imp_dbh->con);
-    drizzle_con_close(imp_dbh->con );
+  while (sql < end)
+  {
+    if (*sql == '\'' || *sql == '"' || *sql == '`')
+    {
+      char quote= *sql++;
+
+      if (first)
+        return FALSE;
+      while (sql < end && *sql != quote)
+        sql+= (*sql == '\\' && sql + 1 < end) ? 2 : 1;
+      sql++;
+      continue;
+    }
+    if (*sql == '/' && sql + 1 < end && sql[1] == '*')
+    {
+      for (sql+= 2; sql + 1 < end && !(sql[0] == '*' && sql[1] == '/'); sql++)
+        ;
+      sql+= 2;
+      continue;
+    }
+    /* A trailing comment would swallow the LIMIT */
+    if (*sql == ';' || *sql == '#' ||
+        (*sql == '-' && sql + 1 < end && sql[1] == '-'))
+      return FALSE;
+    if (!isalpha((unsigned char) *sql))
+    {
+      if (*sql == '(')
+        depth++;
+      else if (*sql == ')')
+        depth--;
+      sql++;
+      continue;
+    }
 
-    /* We don't free imp_dbh since a reference still exists    */
-    /* The DESTROY method is the only one to 'free' memory.    */
-    return TRUE;
+    for (word= sql; sql < end && (isalnum((unsigned char) *sql) || *sql == '_');
+         sql++)
+      ;
+    if (first)
+    {
+      if (sql - word != 6 || strncasecmp(word, "select", 6))
+        return FALSE;
+      first= FALSE;
+      continue;
+    }
+    for (i= 0; stop_words[i]; i++)
+      if ((size_t) (sql - word) == strlen(stop_words[i]) &&
+          !strncasecmp(word, stop_words[i], sql - word))
+        return FALSE;
+    if (order && sql - word == 2 && !strncasecmp(word, "by", 2))
+      order_by= TRUE;
+    order= !depth && sql - word == 5 && !strncasecmp(word, "order", 5);
+  }
+  return order_by;
 }
 
+/*
+  Runs the statement for the page starting at imp_sth->page_offset
+*/
+static uint64_t drizzle_st_execute_page(SV *sth, imp_sth_t *imp_sth,
+                                        SV *statement)
+{
+  SV *sql= sv_2mortal(newSVsv(statement));
+
+  sv_catpvf(sql, " LIMIT %" UVuf ", %lu",
+            (UV) imp_sth->page_offset, imp_sth->fetch_size);
+  return drizzle_st_internal_execute(sth, sql, NULL,
+                                     DBIc_NUM_PARAMS(imp_sth),
+                                     imp_sth->params,
+                                     &imp_sth->result,
+                                     imp_sth->con,
+                                     imp_sth->compact_rows ||
+                                       imp_sth->release_fetched);
+}
 
 /***************************************************************************
  *
- *  Name:    dbd_discon_all
+ *  Name:    drizzle_st_next_page
  *
- *  Purpose: Disconnect all database handles at shutdown time
+ *  Purpose: Replaces the current page of a drizzle_fetch_size result
+ *           with the next one, once all its rows have been fetched
  *
- *  Input:   dbh - database handle being disconnected
- *           imp_dbh - drivers private database handle data
+ *  Input:   sth - statement handle
+ *           imp_sth - drivers private statement handle data
  *
- *  Returns: TRUE for success, FALSE otherwise; do_error has already
- *           been called in the latter case
+ *  Returns: TRUE if there is a new page with rows, FALSE at the end of
+ *           the result or in case of errors; do_error will be called in
+ *           the latter case
  *
  **************************************************************************/
+static int drizzle_st_next_page(SV *sth, imp_sth_t *imp_sth)
+{
+  D_imp_xxh(sth);
+  SV **statement;
+  uint64_t rows;
 
-int dbd_discon_all (SV *drh, imp_drh_t *imp_drh) {
-#if defined(dTHR)
-    dTHR;
-#endif
-  D_imp_xxh(drh);
+  /* A short page was the last one */
+  if (!imp_sth->paged || imp_sth->page_rows < imp_sth->fetch_size)
+    return FALSE;
 
-  /* The disconnect_all concept is flawed and needs more work */
-  if (!dirty && !SvTRUE(perl_get_sv("DBI::PERL_ENDING",0))) {
-    sv_setiv(DBIc_ERR(imp_drh), (IV)1);
-    sv_setpv(DBIc_ERRSTR(imp_drh),
-             (char*)"disconnect_all not implemented");
-    /* NO EFFECT DBIh_EVENT2(drh, ERROR_event,
-      DBIc_ERR(imp_drh), DBIc_ERRSTR(imp_drh)); */
+  statement= hv_fetch((HV*) SvRV(sth), "Statement", 9, FALSE);
+  drizzle_st_free_result_sets(sth, imp_sth);
+  imp_sth->page_offset+= imp_sth->page_rows;
+
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBILOGFP, "\t\treading page at row %llu\n",
+                  (unsigned long long) imp_sth->page_offset);
+
+  rows= drizzle_st_execute_page(sth, imp_sth, *statement);
+  if (rows+1 == (uint64_t) -1 || !imp_sth->result)
+  {
+    imp_sth->paged= FALSE;
     return FALSE;
   }
-  perl_destruct_level = 0;
-  return FALSE;
-}
+  if (imp_sth->compact_rows || imp_sth->release_fetched)
+  {
+    if (!drizzle_st_buffer_rows(sth, imp_sth))
+    {
+      imp_sth->paged= FALSE;
+      return FALSE;
+    }
+    rows= imp_sth->rowbuf.rows;
+  }
 
+  imp_sth->page_rows= rows;
+  imp_sth->row_num+= rows;
+  return rows > 0;
+}
 
-/****************************************************************************
+/***************************************************************************
  *
- *  Name:    dbd_db_destroy
+ *  Name:    drizzle_st_next_chunk
  *
- *  Purpose: Our part of the dbh destructor
+ *  Purpose: Runs a SELECT for the next drizzle_in_chunk part of a list
+ *           once the rows of the previous one have all been fetched
  *
- *  Input:   dbh - database handle being destroyed
- *           imp_dbh - drivers private database handle data
+ *  Input:   sth - statement handle
+ *           imp_sth - drivers private statement handle data
  *
- *  Returns: Nothing
+ *  Returns: TRUE if there is a new result, which may be empty, FALSE
+ *           after the last part or in case of errors; do_error will be
+ *           called in the latter case
  *
  **************************************************************************/
+static int drizzle_st_next_chunk(SV *sth, imp_sth_t *imp_sth)
+{
+  D_imp_xxh(sth);
+  D_imp_dbh_from_sth;
+  SV **statement;
+  uint64_t rows;
 
-void dbd_db_destroy(SV* dbh, imp_dbh_t* imp_dbh) {
+  if (!drizzle_st_next_in_chunk(imp_sth))
+    return FALSE;
 
-    /*
-     *  Being on the safe side never hurts ...
-     */
-  if (DBIc_ACTIVE(imp_dbh))
+  statement= hv_fetch((HV*) SvRV(sth), "Statement", 9, FALSE);
+  drizzle_st_free_result_sets(sth, imp_sth);
+
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBILOGFP, "\t\tsending list values from %ld\n",
+                  (long) imp_sth->params[imp_sth->in_param].list_offset);
+
+  imp_sth->streaming= imp_sth->unbuffered_result;
+  rows= drizzle_st_run(sth, imp_sth, *statement);
+  if (rows+1 == (uint64_t) -1 || !imp_sth->result)
   {
-    if (!DBIc_has(imp_dbh, DBIcf_AutoCommit))
-      dbd_db_rollback(dbh, imp_dbh);
-    dbd_db_disconnect(dbh, imp_dbh);
+    imp_sth->in_param= -1;
+    return FALSE;
+  }
+  if (!imp_sth->unbuffered_result &&
+      (imp_sth->compact_rows || imp_sth->release_fetched ||
+       imp_sth->max_result_bytes))
+  {
+    if (!drizzle_st_buffer_rows(sth, imp_sth))
+    {
+      imp_sth->in_param= -1;
+      return FALSE;
+    }
+    rows= imp_sth->rowbuf.rows;
   }
-  drizzle_con_free(imp_dbh->con);
-  drizzle_free(imp_dbh->drizzle);
 
-  /* Tell DBI, that dbh->destroy must no longer be called */
-  DBIc_off(imp_dbh, DBIcf_IMPSET);
+  imp_sth->row_num+= rows;
+  if (imp_sth->streaming)
+    drizzle_db_own_con(imp_dbh, imp_sth->con, NULL, imp_sth);
+  return TRUE;
 }
 
-/* 
- ***************************************************************************
+/***************************************************************************
  *
- *  Name:    dbd_db_STORE_attrib
+ *  Name:    dbd_st_execute
  *
- *  Purpose: Function for storing dbh attributes; we currently support
- *           just nothing. :-)
+ *  Purpose: Called for preparing an SQL statement; our part of the
+ *           statement handle constructor
  *
- *  Input:   dbh - database handle being modified
- *           imp_dbh - drivers private database handle data
- *           keysv - the attribute name
- *           valuesv - the attribute value
+ *  Input:   sth - statement handle being initialized
+ *           imp_sth - drivers private statement handle data
  *
- *  Returns: TRUE for success, FALSE otherwise
+ *  Returns: TRUE for success, FALSE otherwise; do_error will
+ *           be called in the latter case
  *
  **************************************************************************/
-int
-dbd_db_STORE_attrib(
-                    SV* dbh,
-                    imp_dbh_t* imp_dbh,
-                    SV* keysv,
-                    SV* valuesv
-                   )
+
+/*
+  Adds the row of this execute to the multi-row INSERT collected for
+  drizzle_write_combine, sending it once a limit is reached. Returns 1,
+  as the row counts as inserted, or -2 if sending failed.
+*/
+static int drizzle_st_combine(SV *sth, imp_sth_t *imp_sth, SV *statement)
 {
-  STRLEN kl;
-  char *key = SvPV(keysv, kl);
-  SV *cachesv = Nullsv;
-  int cacheit = FALSE;
-  drizzle_result_st res;
-  drizzle_return_t ret;
-  char *query; /* SET AUTOCOMMIT=x plus null */
-  bool bool_value = SvTRUE(valuesv);
+  D_imp_dbh_from_sth;
+  STRLEN slen, vlen= imp_sth->combine_values_len;
+  char *sql= SvPV(statement, slen);
+  char *row= sql + imp_sth->combine_values;
+  char *salloc;
 
-  if (kl==10 && strEQ(key, "AutoCommit"))
-  {
-    int oldval = DBIc_has(imp_dbh,DBIcf_AutoCommit);
+  if (imp_dbh->combine_owner != imp_sth &&
+      !drizzle_db_flush_combined(sth, imp_dbh))
+    return -2;
 
-    if (bool_value == oldval)
-      return TRUE;
-    if (!(query = (char *)malloc(strlen("SET AUTOCOMMIT=x")+1))) {
-      do_error(dbh, JW_ERR_MEM, "Out of memory", NULL);
-      return FALSE;
-    }
-    sprintf(query, "SET AUTOCOMMIT=%d", bool_value);
-    (void) drizzle_query_str(imp_dbh->con, &res, query, &ret);
-    // static results must be freed before they leave the stack
-    drizzle_result_free(&res);
-    free(query);
-               /*bool_value ?
-                "Turning on AutoCommit failed" :
-                "Turning off AutoCommit failed"*/
-    if (ret != DRIZZLE_RETURN_OK) {
-      do_error(dbh, drizzle_con_errno(imp_dbh->con), 
-               drizzle_con_error(imp_dbh->con),
-               drizzle_con_sqlstate(imp_dbh->con));
-      return FALSE;
-    }
-    DBIc_set(imp_dbh, DBIcf_AutoCommit, bool_value);
+  salloc= parse_params(imp_dbh->con, row, &vlen, imp_sth->params,
+                       DBIc_NUM_PARAMS(imp_sth),
+                       imp_dbh->bind_type_guessing);
+  if (salloc)
+    row= salloc;
+
+  if (imp_sth->combine_rows &&
+      SvCUR(imp_sth->combine_buf) + vlen + 1 > imp_sth->combine_max_bytes &&
+      !drizzle_db_flush_combined(sth, imp_dbh))
+  {
+    Safefree(salloc);
+    return -2;
   }
-  else  if (kl == 25 && strEQ(key,"drizzle_unbuffered_result"))
-    imp_dbh->unbuffered_result = bool_value;
-  else if (kl == 22 && strEQ(key,"drizzle_auto_reconnect"))
-    imp_dbh->auto_reconnect = bool_value;
 
-  else if (kl == 26 && strEQ(key,"drizzle_bind_type_guessing"))
-    imp_dbh->bind_type_guessing = SvTRUE(valuesv);
-  /*HELMUT */
-#if defined(sv_utf8_decode)
-  else if (kl == 19 && strEQ(key, "drizzle_enable_utf8"))
-    imp_dbh->enable_utf8 = bool_value;
-#endif
+  imp_sth->combine_calls++;
+  if (!imp_sth->combine_rows)
+  {
+    if (!imp_sth->combine_buf)
+      imp_sth->combine_buf= newSV(imp_sth->combine_max_bytes + 1);
+    sv_setpvn(imp_sth->combine_buf, sql, imp_sth->combine_values);
+    imp_sth->combine_first= imp_sth->combine_calls;
+  }
   else
-    return FALSE;				/* Unknown key */
+    sv_catpvn(imp_sth->combine_buf, ",", 1);
+  sv_catpvn(imp_sth->combine_buf, row, vlen);
+  Safefree(salloc);
+  imp_sth->combine_rows++;
+  imp_dbh->combine_owner= imp_sth;
 
-  if (cacheit) /* cache value for later DBI 'quick' fetch? */
-    hv_store((HV*)SvRV(dbh), key, kl, cachesv, 0);
-  return TRUE;
+  if ((imp_sth->combine_rows >= imp_sth->combine_max_rows ||
+       SvCUR(imp_sth->combine_buf) >= imp_sth->combine_max_bytes) &&
+      !drizzle_db_flush_combined(sth, imp_dbh))
+    return -2;
+  return 1;
 }
 
-/***************************************************************************
- *
- *  Name:    dbd_db_FETCH_attrib
- *
- *  Purpose: Function for fetching dbh attributes
- *
- *  Input:   dbh - database handle being queried
- *           imp_dbh - drivers private database handle data
- *           keysv - the attribute name
- *
- *  Returns: An SV*, if sucessfull; NULL otherwise
- *
- *  Notes:   Do not forget to call sv_2mortal in the former case!
- *
- **************************************************************************/
-SV* my_ulonglong2str(uint64_t val)
+int dbd_st_execute(SV* sth, imp_sth_t* imp_sth)
 {
-  char buf[64];
-  char *ptr = buf + sizeof(buf) - 1;
+  char actual_row_num[64];
+  bool combine;
+  int i;
+  uint16_t colcount;
+  SV **statement;
+  D_imp_dbh_from_sth;
+  D_imp_xxh(sth);
+#if defined (dTHR)
+  dTHR;
+#endif
+
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBILOGFP,
+      " -> dbd_st_execute for %08lx\n", (u_long) sth);
 
-  if (val == 0)
-    return newSVpv("0", 1);
+  if (!SvROK(sth)  ||  SvTYPE(SvRV(sth)) != SVt_PVHV)
+    croak("Expected hash array");
 
-  *ptr = '\0';
-  while (val > 0)
+  /* Cached array attributes are checked against the new result */
+  drizzle_st_meta_stale(imp_sth);
+
+  statement= hv_fetch((HV*) SvRV(sth), "Statement", 9, FALSE);
+
+  /*
+     Clean-up previous result set(s) for sth to prevent
+     'Commands out of sync' error
+  */
+  drizzle_st_free_result_sets(sth, imp_sth);
+
+  /* Within a transaction, INSERT rows may be sent later on, together */
+  combine= imp_sth->combine_max_rows && imp_sth->combine_values &&
+    !DBIc_has(imp_dbh, DBIcf_AutoCommit);
+  drizzle_st_plan_in_chunks(imp_sth, combine ? 0 : imp_sth->in_chunk);
+  if (combine)
   {
-    *(--ptr) = ('0' + (val % 10));
-    val = val / 10;
+    imp_sth->row_num= drizzle_st_combine(sth, imp_sth, *statement);
+    return (int) imp_sth->row_num;
+  }
+  if (!drizzle_db_flush_combined(sth, imp_dbh))
+  {
+    imp_sth->row_num= (uint64_t) -2;
+    return -2;
   }
-  return newSVpv(ptr, (buf+ sizeof(buf) - 1) - ptr);
-}
 
-SV* dbd_db_FETCH_attrib(SV *dbh, imp_dbh_t *imp_dbh, SV *keysv)
-{
-  STRLEN kl;
-  char *key = SvPV(keysv, kl);
-  char* fine_key = NULL;
-  SV* result = NULL;
-  dbh = dbh;
+  imp_sth->con= drizzle_db_pick_con(sth, imp_dbh, imp_sth);
+  imp_sth->page_offset= 0;
+  if (imp_sth->fetch_size && !imp_sth->unbuffered_result &&
+      imp_sth->in_param < 0)
+  {
+    STRLEN len;
+    char *sql= SvPV(*statement, len);
 
-  switch (*key) {
-    case 'A':
-      if (strEQ(key, "AutoCommit"))
-      {
-        return sv_2mortal(boolSV(DBIc_has(imp_dbh,DBIcf_AutoCommit)));
-      }
-      break;
+    imp_sth->paged= is_pageable_select(sql, len);
   }
-  if (strncmp(key, "drizzle_", DRIZZLE_KEY_PREFIX) == 0) {
-    fine_key = key;
-    key = key + DRIZZLE_KEY_PREFIX;
-    kl = kl - DRIZZLE_KEY_PREFIX;
+  else
+    imp_sth->paged= FALSE;
+
+  if (imp_sth->paged)
+    imp_sth->row_num= drizzle_st_execute_page(sth, imp_sth, *statement);
+  else
+    imp_sth->row_num= drizzle_st_run(sth, imp_sth, *statement);
+
+  /* Without a result set, the other drizzle_in_chunk parts run right away */
+  while (imp_sth->result && imp_sth->row_num != (uint64_t) -2 &&
+         !drizzle_result_column_count(imp_sth->result) &&
+         drizzle_st_next_in_chunk(imp_sth))
+  {
+    uint64_t rows;
+
+    drizzle_result_free(imp_sth->result);
+    imp_sth->result= NULL;
+    rows= drizzle_st_run(sth, imp_sth, *statement);
+    imp_sth->row_num= rows == (uint64_t) -2 ? rows : imp_sth->row_num + rows;
   }
+  imp_sth->streaming= imp_sth->unbuffered_result;
 
-  /* MONTY:  Check if kl should not be used or used everywhere */
-  /*
-    why the heck bother checking kl? If it's equal to the string, then
-    is that not all we care about ? 
-  */
-  switch(*key) {
-  case 'a':
-    if (kl == strlen("auto_reconnect") && strEQ(key, "auto_reconnect"))
-      result= sv_2mortal(newSViv(imp_dbh->auto_reconnect));
-    break;
-  case 'b':
-    if (kl == strlen("bind_type_guessing") &&
-        strEQ(key, "bind_type_guessing"))
-      result = sv_2mortal(newSViv(imp_dbh->bind_type_guessing));
-    break;
-  case 'e':
-    if (strEQ(key, "errno"))
-      result= sv_2mortal(newSViv((IV)drizzle_con_errno(imp_dbh->con)));
-    else if ( strEQ(key, "error") || strEQ(key, "errmsg"))
-    {
-    /* Note that errmsg is obsolete, as of 2.09! */
-      const char* msg = drizzle_con_error(imp_dbh->con);
-      result= sv_2mortal(newSVpv(msg, strlen(msg)));
-    }
-    /* HELMUT */
-#if defined(sv_utf8_decode)
-    else if (kl == strlen("enable_utf8") && strEQ(key, "enable_utf8"))
-        result = sv_2mortal(newSViv(imp_dbh->enable_utf8));
-#endif
-    break;
+  colcount = 0;
+  if (imp_sth->result != NULL)
+  {
+    colcount = drizzle_result_column_count(imp_sth->result);
 
-  case 'd':
-    if (strEQ(key, "dbd_stats"))
+    if (imp_sth->row_num+1 != (uint64_t )-1)
     {
-      HV* hv = newHV();
-      hv_store(
-               hv,
-               "auto_reconnects_ok",
-               strlen("auto_reconnects_ok"),
-               newSViv(imp_dbh->stats.auto_reconnects_ok),
-               0
-              );
-      hv_store(
-               hv,
-               "auto_reconnects_failed",
-               strlen("auto_reconnects_failed"),
-               newSViv(imp_dbh->stats.auto_reconnects_failed),
-               0
-              );
+      if (!colcount) {
+        // XXX serious sync issues arise when multiple cons are used w/ threading
+        imp_dbh->insert_id= drizzle_result_insert_id(imp_sth->result);
+      }
+      else
+      {
+        /* Read the rows ourselves, within drizzle_max_result_bytes */
+        if (!imp_sth->unbuffered_result &&
+            (imp_sth->compact_rows || imp_sth->release_fetched ||
+             (imp_sth->max_result_bytes && !imp_sth->paged)))
+        {
+          if (!drizzle_st_buffer_rows(sth, imp_sth))
+          {
+            drizzle_result_free(imp_sth->result);
+            imp_sth->result= NULL;
+            imp_sth->row_num= (uint64_t) -2;
+            return -2;
+          }
+          imp_sth->row_num= imp_sth->rowbuf.rows;
+        }
+        imp_sth->page_rows= imp_sth->row_num;
 
-      result= (newRV_noinc((SV*)hv));
-    }
-    break;
-  case 'i':
-    if (strEQ(key, "insertid"))
-      result= sv_2mortal(my_ulonglong2str(imp_dbh->insert_id));
-    break;
-  case 'p':
-    if (strEQ(key, "protocol_version"))
-      result= sv_2mortal(newSViv(drizzle_con_protocol_version(imp_dbh->con)));
-    break;
-  case 's':
-    if (strEQ(key, "server_version"))
-    {
-      const char* version = drizzle_con_server_version(imp_dbh->con);
-      result= version ?
-        sv_2mortal(newSVpv(version, strlen(version))) : &sv_undef;
+        /** Store the result in the current statement handle */
+        DBIc_NUM_FIELDS(imp_sth)= colcount;
+        DBIc_ACTIVE_on(imp_sth);
+        imp_sth->done_desc= 0;
+      }
     }
-    else if (strEQ(key, "sock"))
-      result= sv_2mortal(newSViv((IV) imp_dbh->con));
-    else if (strEQ(key, "sockfd"))
-      result= sv_2mortal(newSViv((IV) drizzle_con_fd(imp_dbh->con)));
-    break;
-  case 't':
-    if (kl == 9  &&  strEQ(key, "thread_id")) 
-      result= sv_2mortal(newSViv(drizzle_con_thread_id(imp_dbh->con)));
-    break;
+
+    imp_sth->warning_count = drizzle_result_warning_count(imp_sth->result);
+
+    /* Unread rows keep the connection busy until we are finished */
+    if (imp_sth->streaming && colcount)
+      drizzle_db_own_con(imp_dbh, imp_sth->con, NULL, imp_sth);
   }
 
-  if (result== NULL)
-    return Nullsv;
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+  {
+    /* 
+      PerlIO_printf doesn't always handle imp_sth->row_num %llu 
+      consistantly!!
+    */
+    sprintf(actual_row_num, "%l", (long int) imp_sth->row_num);
+    PerlIO_printf(DBILOGFP,
+                  " <- dbd_st_execute returning imp_sth->row_num %s\n",
+                  actual_row_num);
+  }
 
-  return result;
+  return (int)imp_sth->row_num;
 }
 
-
-/* 
- **************************************************************************
+ /**************************************************************************
  *
- *  Name:    dbd_st_prepare
+ *  Name:    dbd_describe
  *
- *  Purpose: Called for preparing an SQL statement; our part of the
- *           statement handle constructor
+ *  Purpose: Called from within the fetch method to describe the result
  *
  *  Input:   sth - statement handle being initialized
- *           imp_sth - drivers private statement handle data
- *           statement - pointer to string with SQL statement
- *           attribs - statement attributes, currently not in use
+ *           imp_sth - our part of the statement handle, there's no
+ *               need for supplying both; Tim just doesn't remove it
  *
  *  Returns: TRUE for success, FALSE otherwise; do_error will
  *           be called in the latter case
  *
  **************************************************************************/
-int
-dbd_st_prepare(
-  SV *sth,
-  imp_sth_t *imp_sth,
-  char *statement,
-  SV *attribs)
+
+int dbd_describe(SV* sth, imp_sth_t* imp_sth)
 {
-  int i;
-  SV **svp;
   D_imp_xxh(sth);
-  D_imp_dbh_from_sth;
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBILOGFP, "\t--> dbd_describe\n");
+
+  imp_sth->done_desc= 1;
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBILOGFP, "\t<- dbd_describe\n");
+  return TRUE;
+}
 
+/***************************************************************************
+ *
+ *  Name:    drizzle_st_intern_setup
+ *
+ *  Purpose: Works out which columns of a new result drizzle_intern_columns
+ *           asks to intern: those named or numbered (from 0) in its array,
+ *           or with 'auto' every column that is not numeric, sampled over
+ *           the first INTERN_SAMPLE_ROWS rows
+ *
+ *  Input:   imp_sth - drivers private statement handle data
+ *           num_fields - columns of the result
+ *
+ **************************************************************************/
+static void drizzle_st_intern_setup(imp_sth_t *imp_sth, int num_fields)
+{
+  SV *spec= imp_sth->intern_columns, **svp;
+  drizzle_column_st *col;
+  const char *name;
+  int i;
+  I32 j;
 
-  imp_sth->done_desc= 0;
-  imp_sth->result= NULL;
-  imp_sth->row= NULL;
+  drizzle_st_intern_free(imp_sth);
+  if (!spec || !SvOK(spec) || !num_fields)
+    return;
 
-  //(void)drizzle_result_create(imp_dbh->con, imp_dbh->result);
+  Newz(0, imp_sth->intern, num_fields, char);
+  Newz(0, imp_sth->intern_seen, num_fields, HV*);
+  imp_sth->intern_count= num_fields;
+  imp_sth->intern_rows= 0;
 
-  /* Set default value of 'drizzle_unbuffered_result' attribute for sth from dbh */
-  svp= DBD_ATTRIB_GET_SVP(attribs,
-                          "drizzle_unbuffered_result",
-                          strlen("drizzle_unbuffered_result"));
+  if (SvROK(spec) && SvTYPE(SvRV(spec)) == SVt_PVAV)
+  {
+    AV *av= (AV*) SvRV(spec);
 
-  imp_sth->unbuffered_result= svp ?
-    SvTRUE(*svp) : imp_dbh->unbuffered_result;
+    for (j= 0; j <= av_len(av); j++)
+    {
+      if (!(svp= av_fetch(av, j, FALSE)) || !SvOK(*svp))
+        continue;
+      if (looks_like_number(*svp))
+      {
+        i= SvIV(*svp);
+        if (i >= 0 && i < num_fields)
+          imp_sth->intern[i]= INTERN_ON;
+        continue;
+      }
+      name= SvPV_nolen(*svp);
+      drizzle_column_seek(imp_sth->result, 0);
+      for (i= 0; i < num_fields; i++)
+        if (strEQ(drizzle_column_name(drizzle_column_next(imp_sth->result)),
+                  name))
+          imp_sth->intern[i]= INTERN_ON;
+    }
+  }
+  else if (strEQ(SvPV_nolen(spec), "auto"))
+  {
+    drizzle_column_seek(imp_sth->result, 0);
+    for (i= 0; i < num_fields; i++)
+    {
+      col= drizzle_column_next(imp_sth->result);
+      if (native2sql(drizzle_column_type(col))->is_num)
+        continue;
+      imp_sth->intern[i]= INTERN_SAMPLE;
+      imp_sth->intern_seen[i]= newHV();
+      imp_sth->intern_sampling= TRUE;
+    }
+  }
+}
 
-  for (i= 0; i < AV_ATTRIB_LAST; i++)
-    imp_sth->av_attr[i]= Nullav;
+/*
+  After INTERN_SAMPLE_ROWS rows, keeps interning the sampled columns with
+  few distinct values and stops for the others
+*/
+static void drizzle_st_intern_decide(imp_sth_t *imp_sth)
+{
+  int i;
 
-  /*
-     Clean-up previous result set(s) for sth to prevent
-     'Commands out of sync' error 
-  */
-  // TODO drizzle_con_ready() for conn pooling would be awesome
-  drizzle_st_free_result_sets(sth, imp_sth);
-  //  (void)drizzle_result_create(imp_dbh->con, imp_sth->result);
+  for (i= 0; i < imp_sth->intern_count; i++)
+  {
+    if (imp_sth->intern[i] != INTERN_SAMPLE)
+      continue;
+    imp_sth->intern[i]= HvKEYS(imp_sth->intern_seen[i]) <=
+      INTERN_MAX_DISTINCT ? INTERN_ON : INTERN_OFF;
+    SvREFCNT_dec((SV*) imp_sth->intern_seen[i]);
+    imp_sth->intern_seen[i]= NULL;
+  }
+  imp_sth->intern_sampling= FALSE;
+}
 
-  DBIc_NUM_PARAMS(imp_sth) = count_params(statement);
+/*
+  Fill the row array av from row for fetch. FILL_ROW_FUNC makes one for
+  each combination of ChopBlanks and UTF-8 decoding, so the loop over the
+  fields tests nothing the result does not need; fill_row_general takes
+  care of drizzle_intern_columns and drizzle_datetime_as as well.
+*/
+#define FILL_ROW_FUNC(name, chop, decode)                                  \
+static void name(imp_sth_t *imp_sth, AV *av, drizzle_row_t row,            \
+                 size_t *lengths, int num_fields)                          \
+{                                                                          \
+  SV **svs= AvARRAY(av);                                                   \
+  size_t len;                                                              \
+  int i;                                                                   \
+                                                                           \
+  PERL_UNUSED_VAR(imp_sth);                                                \
+  for (i= 0; i < num_fields; i++)                                          \
+  {                                                                        \
+    if (!row[i])                                                           \
+    {                                                                      \
+      (void) SvOK_off(svs[i]);                                             \
+      continue;                                                            \
+    }                                                                      \
+    len= chop ? chop_blanks_len(row[i], lengths[i]) : lengths[i];          \
+    sv_setpvn(svs[i], row[i], len);                                        \
+    if (decode && imp_sth->fetch_text[i] && !ascii_only(row[i], len) &&    \
+        is_utf8_string((U8*) row[i], len))                                 \
+      SvUTF8_on(svs[i]);                                                   \
+    else                                                                   \
+      SvUTF8_off(svs[i]);                                                  \
+  }                                                                        \
+}
 
-  /* Allocate memory for parameters */
-  imp_sth->params= alloc_param(DBIc_NUM_PARAMS(imp_sth));
-  DBIc_IMPSET_on(imp_sth);
+FILL_ROW_FUNC(fill_row_plain, 0, 0)
+FILL_ROW_FUNC(fill_row_chop, 1, 0)
+FILL_ROW_FUNC(fill_row_utf8, 0, 1)
+FILL_ROW_FUNC(fill_row_chop_utf8, 1, 1)
 
-  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-    PerlIO_printf(DBILOGFP, "\t<- dbd_st_prepare\n");
-  return 1;
+static void fill_row_general(imp_sth_t *imp_sth, AV *av, drizzle_row_t row,
+                             size_t *lengths, int num_fields)
+{
+  int i;
+
+  /* paranoid - just in case something else put it somewhere else */
+  drizzle_column_seek(imp_sth->result, 0);
+  for (i= 0; i < num_fields; i++)
+    drizzle_st_field_sv(imp_sth, AvARRAY(av)[i], i,
+                        drizzle_column_next(imp_sth->result),
+                        row[i], lengths[i]);
 }
 
 /***************************************************************************
- * Name: dbd_st_free_result_sets
  *
- * Purpose: Clean-up single or multiple result sets (if any)
+ *  Name:    drizzle_st_fetch_plan
  *
- * Inputs: sth - Statement handle
- *         imp_sth - driver's private statement handle
+ *  Purpose: Picks how fetch fills the row array for a new result, once
+ *           instead of for every field: which columns are text to decode
+ *           and which of the fill_row functions to use. Attributes that
+ *           change it drop the plan, so the next fetch makes a new one.
  *
- * Returns: 1 ok
- *          0 error
- *************************************************************************/
-int drizzle_st_free_result_sets (SV * sth, imp_sth_t * imp_sth)
+ *  Input:   imp_sth - drivers private statement handle data
+ *           num_fields - columns of the result
+ *
+ **************************************************************************/
+static void drizzle_st_fetch_plan(imp_sth_t *imp_sth, int num_fields)
 {
   D_imp_dbh_from_sth;
-  D_imp_xxh(sth);
-  int next_result_rc= -1;
-  drizzle_row_t row;
-  drizzle_return_t ret;
+  bool chop= DBIc_is(imp_sth, DBIcf_ChopBlanks) != 0, decode= FALSE;
+  drizzle_column_st *col;
+  int i;
 
-  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-    PerlIO_printf(DBILOGFP, "\t>- dbd_st_free_result_sets\n");
+  drizzle_st_intern_setup(imp_sth, num_fields);
+  imp_sth->plan_chop= chop;
+  imp_sth->plan_utf8= imp_dbh->utf8_generation;
 
-  /* Nice and simple , thanks Eric */
-  if (imp_sth->result)
+  Renew(imp_sth->fetch_text, num_fields ? num_fields : 1, char);
+  drizzle_column_seek(imp_sth->result, 0);
+  for (i= 0; i < num_fields; i++)
   {
-    drizzle_result_free(imp_sth->result);
-    imp_sth->result= NULL;
+    col= drizzle_column_next(imp_sth->result);
+    imp_sth->fetch_text[i]= FALSE;
+#if defined(sv_utf8_decode)
+    imp_sth->fetch_text[i]= imp_dbh->enable_utf8 &&
+      !(drizzle_column_flags(col) & DRIZZLE_COLUMN_FLAGS_BINARY);
+#endif
+    decode|= imp_sth->fetch_text[i];
   }
 
-  return 1;
+  if (imp_sth->lazy_columns)
+    imp_sth->fill_row= drizzle_st_lazy_row;
+  else if (imp_sth->intern_count ||
+           imp_sth->datetime_as != DATETIME_AS_STRING)
+    imp_sth->fill_row= fill_row_general;
+  else if (chop)
+    imp_sth->fill_row= decode ? fill_row_chop_utf8 : fill_row_chop;
+  else
+    imp_sth->fill_row= decode ? fill_row_utf8 : fill_row_plain;
 }
 
-
-/***************************************************************************
- * Name: dbd_st_more_results
+/**************************************************************************
  *
- * Purpose: Move onto the next result set (if any)
+ *  Name:    dbd_st_fetch
  *
- * Inputs: sth - Statement handle
- *         imp_sth - driver's private statement handle
+ *  Purpose: Called for fetching a result row
  *
- * Returns: 1 if there are more results sets
- *          0 if there are not
- *         -1 for errors.
- *************************************************************************/
-int dbd_st_more_results(SV* sth, imp_sth_t* imp_sth)
+ *  Input:   sth - statement handle being initialized
+ *           imp_sth - drivers private statement handle data
+ *
+ *  Returns: array of columns; the array is allocated by DBI via
+ *           DBIS->get_fbav(imp_sth), even the values of the array
+ *           are prepared, we just need to modify them appropriately
+ *
+ **************************************************************************/
+
+AV*
+dbd_st_fetch(SV *sth, imp_sth_t* imp_sth)
 {
+  int num_fields, ChopBlanks;
+  size_t *lengths;
+  AV *av;
+  int av_length, av_readonly;
+  drizzle_row_t row;
+
   D_imp_dbh_from_sth;
+  drizzle_con_st *con= imp_dbh->con;
+
   D_imp_xxh(sth);
 
   drizzle_return_t ret;
-  drizzle_con_st* con = imp_dbh->con;
-  int more_rows;
-  int i;
-
-  if (!SvROK(sth) || SvTYPE(SvRV(sth)) != SVt_PVHV)
-    croak("Expected hash array");
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBILOGFP, "\t-> dbd_st_fetch\n");
 
 
-  /*
-   *  Free cached array attributes
-   */
-  for (i= 0; i < AV_ATTRIB_LAST;  i++)
-  {
-    if (imp_sth->av_attr[i])
-      SvREFCNT_dec(imp_sth->av_attr[i]);
+  ChopBlanks = DBIc_is(imp_sth, DBIcf_ChopBlanks);
 
-    imp_sth->av_attr[i]= Nullav;
-  }
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBILOGFP,
+                  "\t\tdbd_st_fetch for %08lx, chopblanks %d\n",
+                  (u_long) sth, ChopBlanks);
 
-  if ( imp_sth->unbuffered_result && imp_sth->row )
+  if (!imp_sth->result)
   {
-    drizzle_row_free(imp_sth->result, imp_sth->row);
-    imp_sth->row= NULL;
+    do_error(sth, JW_ERR_SEQUENCE, "fetch() without execute()" ,NULL);
+    return Nullav;
   }
 
-
-  if ( imp_sth->unbuffered_result )
-  {
-    imp_sth->row = drizzle_row_buffer(imp_sth->result, &ret);
-  }
-  else
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
   {
-    imp_sth->row = drizzle_row_next(imp_sth->result);
+    PerlIO_printf(DBILOGFP, "\tdbd_st_fetch result set details\n");
+    PerlIO_printf(DBILOGFP, "\tdrizzle_result_column_count=%d\n",
+                  drizzle_result_column_count(imp_sth->result));
+    PerlIO_printf(DBILOGFP, "\tdrizzle_result_row_count=%lu\n",
+                  drizzle_result_row_count(imp_sth->result));
+    PerlIO_printf(DBILOGFP, "\tdrizzle_result_affected_rows=%lu\n",
+                  drizzle_result_affected_rows(imp_sth->result));
   }
 
-  if (imp_sth->unbuffered_result && ret != DRIZZLE_RETURN_OK)
+  /* Unread lazy columns of the last row are not kept */
+  if (imp_sth->lazy_row)
   {
-    more_rows = -1;
-    do_error(sth, drizzle_result_error_code(imp_sth->result), drizzle_result_error(imp_sth->result),
-            drizzle_result_sqlstate(imp_sth->result));
+    drizzle_st_lazy_done(imp_sth, FALSE);
+    if (imp_sth->release_fetched && imp_sth->rowbuf.active)
+      rowbuf_release_read(&imp_sth->rowbuf, imp_dbh);
   }
-  else
+
+  row= drizzle_st_next_row(sth, imp_sth, &lengths, &ret);
+
+  /*
+    With drizzle_fetch_size, go on with the next page, with
+    drizzle_in_chunk, with the next part of the list
+  */
+  while (!row && ret == DRIZZLE_RETURN_OK &&
+         (drizzle_st_next_page(sth, imp_sth) ||
+          drizzle_st_next_chunk(sth, imp_sth)))
+    row= drizzle_st_next_row(sth, imp_sth, &lengths, &ret);
+
+  if (!row)
   {
-    more_rows = imp_sth->row != NULL ? 1 : 0;
+    if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    {
+      PerlIO_printf(DBILOGFP, "\tdbd_st_fetch, no more rows to fetch");
+    }
+    if (ret != DRIZZLE_RETURN_OK && ret != DRIZZLE_RETURN_TIMEOUT)
+      do_error(sth, drizzle_result_error_code(imp_sth->result),
+               drizzle_result_error(imp_sth->result),
+               drizzle_result_sqlstate(imp_sth->result));
+
+    dbd_st_finish(sth, imp_sth);
+    return Nullav;
   }
 
-  if (more_rows <= 0)
+  num_fields= drizzle_result_column_count(imp_sth->result);
+
+  /* ChopBlanks and drizzle_enable_utf8 are not stored through the sth */
+  if (!imp_sth->fill_row || imp_sth->plan_chop != (ChopBlanks != 0) ||
+      imp_sth->plan_utf8 != imp_dbh->utf8_generation)
+    drizzle_st_fetch_plan(imp_sth, num_fields);
+
+  if ((av= DBIc_FIELDS_AV(imp_sth)) != Nullav)
   {
-    /* No more pending result set(s)*/
-    if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-      PerlIO_printf(DBILOGFP,
-		    "\n      <- dbs_st_more_rows no more results\n");
-    return 0;
+    av_length= av_len(av)+1;
+
+    if (av_length != num_fields)              /* Resize array if necessary */
+    {
+      if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+        PerlIO_printf(DBILOGFP, "\t<- dbd_st_fetch, size of results array(%d) != num_fields(%d)\n",
+                      av_length, num_fields);
+
+      if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+        PerlIO_printf(DBILOGFP, "\t<- dbd_st_fetch, result fields(%d)\n",
+                      DBIc_NUM_FIELDS(imp_sth));
+
+      av_readonly = SvREADONLY(av);
+
+      if (av_readonly)
+        SvREADONLY_off( av );              /* DBI sets this readonly */
+
+      while (av_length < num_fields)
+      {
+        av_store(av, av_length++, newSV(0));
+      }
+
+      while (av_length > num_fields)
+      {
+        SvREFCNT_dec(av_pop(av));
+        av_length--;
+      }
+      if (av_readonly)
+        SvREADONLY_on(av);
+    }
   }
 
+  av= DBIS->get_fbav(imp_sth);
 
-  if (DBIc_ACTIVE(imp_sth))
-    DBIc_ACTIVE_off(imp_sth);
+  /* Note: we (re)use the SVs in the AV */
+  imp_sth->fill_row(imp_sth, av, row, lengths, num_fields);
 
-  if (imp_sth->row) {
-    /* We have a new rowset */
-    /* delete cached handle attributes */
-    /* XXX should be driven by a list to ease maintenance */
-    hv_delete((HV*)SvRV(sth), "NAME", 4, G_DISCARD);
-    hv_delete((HV*)SvRV(sth), "NULLABLE", 8, G_DISCARD);
-    hv_delete((HV*)SvRV(sth), "NUM_OF_FIELDS", 13, G_DISCARD);
-    hv_delete((HV*)SvRV(sth), "PRECISION", 9, G_DISCARD);
-    hv_delete((HV*)SvRV(sth), "SCALE", 5, G_DISCARD);
-    hv_delete((HV*)SvRV(sth), "TYPE", 4, G_DISCARD);
-    hv_delete((HV*)SvRV(sth), "drizzle_insertid", 16, G_DISCARD);
-    hv_delete((HV*)SvRV(sth), "drizzle_is_auto_increment", 23, G_DISCARD);
-    hv_delete((HV*)SvRV(sth), "drizzle_is_blob", 13, G_DISCARD);
-    hv_delete((HV*)SvRV(sth), "drizzle_is_key", 12, G_DISCARD);
-    hv_delete((HV*)SvRV(sth), "drizzle_is_num", 12, G_DISCARD);
-    hv_delete((HV*)SvRV(sth), "drizzle_is_pri_key", 16, G_DISCARD);
-    hv_delete((HV*)SvRV(sth), "drizzle_length", 12, G_DISCARD);
-    hv_delete((HV*)SvRV(sth), "drizzle_max_length", 16, G_DISCARD);
-    hv_delete((HV*)SvRV(sth), "drizzle_table", 11, G_DISCARD);
-    hv_delete((HV*)SvRV(sth), "drizzle_type", 10, G_DISCARD);
-    hv_delete((HV*)SvRV(sth), "drizzle_type_name", 15, G_DISCARD);
-    hv_delete((HV*)SvRV(sth), "drizzle_warning_count", 20, G_DISCARD);
+  /* A lazy row stays until the next fetch, release_fetched waits for it */
+  if (!imp_sth->lazy_columns &&
+      imp_sth->release_fetched && imp_sth->rowbuf.active)
+    rowbuf_release_read(&imp_sth->rowbuf, imp_dbh);
 
-    /* Adjust NUM_OF_FIELDS - which also adjusts the row buffer size */
-    DBIc_NUM_FIELDS(imp_sth)= 0; /* for DBI <= 1.53 */
-    DBIS->set_attr_k(sth, sv_2mortal(newSVpvn("NUM_OF_FIELDS",13)), 0,
-        sv_2mortal(newSViv(drizzle_result_column_count(imp_sth->result)))
-    );
+  if (imp_sth->intern_sampling &&
+      ++imp_sth->intern_rows == INTERN_SAMPLE_ROWS)
+    drizzle_st_intern_decide(imp_sth);
 
-    DBIc_ACTIVE_on(imp_sth);
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBILOGFP, "\t<- dbd_st_fetch, %d cols\n", num_fields);
+
+  return av;
 
-    imp_sth->done_desc = 0;
-    return 1;
-  } else {
-    return 0;
-  } 
 }
-/**************************************************************************
+
+/***************************************************************************
  *
- *  Name:    drizzle_st_internal_execute
+ *  Name:    drizzle_st_tell
  *
- *  Purpose: Internal version for executing a statement, called both from
- *           within the "do" and the "execute" method.
+ *  Purpose: Returns the position of the row the next fetch will return,
+ *           counting from 0
  *
- *  Inputs:  h - object handle, for storing error messages
- *           statement - query being executed
- *           attribs - statement attributes, currently ignored
- *           num_params - number of parameters being bound
- *           params - parameter array
- *           result - where to store results, if any
- *           con - connection to the database
+ *  Input:   sth - statement handle
+ *           imp_sth - drivers private statement handle data
+ *
+ *  Returns: The position, or -1 if the result cannot be positioned;
+ *           do_error will be called in the latter case
  *
  **************************************************************************/
-
-
-uint64_t drizzle_st_internal_execute(
-                                       SV *h, /* could be sth or dbh */
-                                       SV *statement,
-                                       SV *attribs,
-                                       int num_params,
-                                       imp_sth_ph_t *params,
-                                       drizzle_result_st **result,
-                                       drizzle_con_st *con,
-                                       int unbuffered_result
-                                      )
+IV drizzle_st_tell(SV *sth, imp_sth_t *imp_sth)
 {
-  bool bind_type_guessing= false;
-  STRLEN slen;
-  char *sbuf = SvPV(statement, slen);
-  char *table;
-  char *query;
-  char *salloc;
-  int htype;
-  int errno;
-  uint64_t rows= 0;
-  drizzle_return_t ret;
-  /* thank you DBI.c for this info! */
-  D_imp_xxh(h);
-  attribs= attribs;
+  IV pos;
 
-  htype= DBIc_TYPE(imp_xxh);
-  /*
-    It is important to import imp_dbh properly according to the htype
-    that it is! Also, one might ask why bind_type_guessing is assigned
-    in each block. Well, it's because D_imp_ macros called in these
-    blocks make it so imp_dbh is not "visible" or defined outside of the
-    if/else (when compiled, it fails for imp_dbh not being defined).
-  */
-  /* h is a dbh */
-  if (htype==DBIt_DB)
+  if (!imp_sth->result)
   {
-    D_imp_dbh(h);
-    /* if imp_dbh is not available, it causes segfault (proper) on OpenBSD */
-    if (imp_dbh && imp_dbh->bind_type_guessing)
-      bind_type_guessing= imp_dbh->bind_type_guessing;
-    else
-      bind_type_guessing= 0;
+    do_error(sth, JW_ERR_NOT_ACTIVE, "Statement not active", NULL);
+    return -1;
   }
-  /* h is a sth */
-  else
+  if (imp_sth->paged)
   {
-    D_imp_sth(h);
-    D_imp_dbh_from_sth;
-    /* if imp_dbh is not available, it causes segfault (proper) on OpenBSD */
-    if (imp_dbh)
-      bind_type_guessing= imp_dbh->bind_type_guessing;
-    else
-      bind_type_guessing=0;
+    do_error(sth, JW_ERR_ROW_POSITION,
+             "Cannot position a result read by drizzle_fetch_size", NULL);
+    return -1;
   }
-
-  salloc= parse_params(con,
-                       sbuf,
-                       &slen,
-                       params,
-                       num_params,
-                       bind_type_guessing);
-
-  if (salloc)
+  if (imp_sth->in_param >= 0)
+  {
+    do_error(sth, JW_ERR_ROW_POSITION,
+             "Cannot position a result read by drizzle_in_chunk", NULL);
+    return -1;
+  }
+  if (imp_sth->rowbuf.active && !imp_sth->streaming)
+    pos= (IV) imp_sth->rowbuf.rows_read;
+  else if (!imp_sth->rowbuf.active && !imp_sth->unbuffered_result)
+    pos= (IV) drizzle_row_current(imp_sth->result);
+  else
   {
-    sbuf= salloc;
-    if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-      PerlIO_printf(DBILOGFP, "Binding parameters: %s\n", sbuf);
+    do_error(sth, JW_ERR_ROW_POSITION,
+             "Cannot position an unbuffered result", NULL);
+    return -1;
   }
 
-  if (slen >= 11 && (!strncmp(sbuf, "listfields ", 11) ||
-                     !strncmp(sbuf, "LISTFIELDS ", 11)))
+  /* A row read ahead by dbd_st_more_results has not been fetched yet */
+  return imp_sth->row ? pos - 1 : pos;
+}
+
+/***************************************************************************
+ *
+ *  Name:    drizzle_st_seek
+ *
+ *  Purpose: Moves the position of a buffered result, so that the next
+ *           fetch returns the row at offset from whence
+ *
+ *  Input:   sth - statement handle
+ *           imp_sth - drivers private statement handle data
+ *           offset - number of rows to move, may be negative
+ *           whence - one of seek_whence
+ *
+ *  Returns: TRUE for success, FALSE otherwise; do_error will
+ *           be called in the latter case
+ *
+ **************************************************************************/
+int drizzle_st_seek(SV *sth, imp_sth_t *imp_sth, IV offset, int whence)
+{
+  IV pos, first= 0, rows;
+
+  if ((pos= drizzle_st_tell(sth, imp_sth)) < 0)
+    return FALSE;
+
+  if (imp_sth->rowbuf.active)
   {
-    /* remove pre-space */
-    slen-= 10;
-    sbuf+= 10;
-    while (slen && isspace(*sbuf)) { --slen;  ++sbuf; }
+    rows= (IV) imp_sth->rowbuf.rows;
+    first= (IV) imp_sth->rowbuf.first_row;
+  }
+  else
+    rows= (IV) drizzle_result_row_count(imp_sth->result);
 
-    if (!slen)
-    {
-      do_error(h, JW_ERR_QUERY, "Missing table name" ,NULL);
-      return -2;
-    }
-    if (!(table= malloc(slen+1)))
-    {
-      do_error(h, JW_ERR_MEM, "Out of memory" ,NULL);
-      return -2;
-    }
+  switch (whence) {
+  case SEEK_ROW_ABS:
+    pos= offset;
+    break;
+  case SEEK_ROW_END:
+    pos= rows + offset;
+    break;
+  default:
+    pos+= offset;
+    break;
+  }
 
-    strncpy(table, sbuf, slen);
-    sbuf= table;
+  if (pos < first || pos > rows)
+  {
+    do_error(sth, JW_ERR_ROW_POSITION, "Row position out of range", NULL);
+    return FALSE;
+  }
 
-    while (slen && !isspace(*sbuf))
-    {
-      --slen;
-      ++sbuf;
-    }
-    *sbuf++= '\0';
+  imp_sth->row= NULL;
+  if (imp_sth->rowbuf.active)
+    imp_sth->rowbuf.rows_read= (uint64_t) pos;
+  else
+    drizzle_row_seek(imp_sth->result, (uint64_t) pos);
+  return TRUE;
+}
 
-    if (!(query= malloc(strlen("SHOW COLUMNS FROM ``") + 1 + strlen(table)))) {
-      do_error(h, JW_ERR_MEM, "Out of memory", NULL);
-      return -2;
-    }
-    sprintf(query,"SHOW COLUMNS FROM `%s`", table);
-    *result= drizzle_query_str(con, NULL, query, &ret);
+/***************************************************************************
+ *
+ *  Name:    drizzle_st_fetch_range
+ *
+ *  Purpose: Fetches count rows of a buffered result starting at row
+ *           start; with a negative count the rows are fetched backwards,
+ *           from start down. Going forward the position is left after
+ *           the last row fetched, going backwards on the last row fetched,
+ *           so that another call continues in the same direction.
+ *
+ *  Input:   sth - statement handle
+ *           imp_sth - drivers private statement handle data
+ *           start - position of the first row to fetch
+ *           count - number of rows to fetch
+ *
+ *  Returns: A new array of row array refs, Nullav in case of errors,
+ *           in which case do_error will have been called
+ *
+ **************************************************************************/
+AV *drizzle_st_fetch_range(SV *sth, imp_sth_t *imp_sth, IV start, IV count)
+{
+  AV *rows_av, *av;
+  IV rows, step= count < 0 ? -1 : 1;
 
-    free(query);
+  if (!drizzle_st_seek(sth, imp_sth, start, SEEK_ROW_ABS))
+    return Nullav;
 
-    free(table);
+  rows= imp_sth->rowbuf.active ? (IV) imp_sth->rowbuf.rows :
+    (IV) drizzle_result_row_count(imp_sth->result);
 
-    if (!(*result) || ret != DRIZZLE_RETURN_OK)
+  /*
+    Never read past the last row, dbd_st_fetch would finish the statement
+    and leave nothing to go back to
+  */
+  if (count > rows - start)
+    count= rows - start;
+  else if (count < 0 && start >= rows)
+    count= 0;
+  else if (count < -(start + 1))
+    count= -(start + 1);
+
+  rows_av= newAV();
+  for (; count; count-= step, start+= step)
+  {
+    if ((step < 0 && !drizzle_st_seek(sth, imp_sth, start, SEEK_ROW_ABS)) ||
+        !(av= dbd_st_fetch(sth, imp_sth)))
     {
-      do_error(h, drizzle_con_errno(con), drizzle_con_error(con)
-               ,drizzle_con_sqlstate(con));
-      return -2;
+      SvREFCNT_dec((SV *) rows_av);
+      return Nullav;
     }
-
-    return 0;
+    av_push(rows_av, newRV_noinc((SV *) av_make(AvFILL(av) + 1, AvARRAY(av))));
   }
 
-  *result = (drizzle_result_st *)drizzle_query(con, NULL, sbuf, slen, &ret);
-  if (ret != DRIZZLE_RETURN_OK) {
-    Safefree(salloc);
+  if (step < 0 && av_len(rows_av) >= 0)
+    (void) drizzle_st_seek(sth, imp_sth, start + 1, SEEK_ROW_ABS);
+  return rows_av;
+}
 
-    /*do_error(h, drizzle_con_errno(con), drizzle_con_error(con),
-		    drizzle_con_sqlstate(con));
+/*
+  Writes a field for drizzle_copy_out to out, escaped as copy_in_record()
+  reads it back. With upgrade, bytes above 127 are written as UTF-8, as
+  print does on a :utf8 handle for a byte string. out needs room for
+  2*len+2 bytes. Returns the end of what was written.
 */
+static char *copy_out_field(char *out, const char *field, size_t len,
+                            bool csv, bool upgrade)
+{
+  const char *p, *end= field + len;
+  bool quote= FALSE;
+  unsigned char c;
 
-    do_error(h, drizzle_con_error_code(con), drizzle_con_error(con),
-		    drizzle_con_sqlstate(con));
-
+  if (!field)
+  {
+    if (!csv)
+    {
+      *out++= '\\';
+      *out++= 'N';
+    }
+    return out;
+  }
 
-    if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-      PerlIO_printf(DBILOGFP, "IGNORING ERROR errno %d\n", errno);
-    return -2;
+  if (csv)
+  {
+    quote= !len;
+    for (p= field; p < end && !quote; p++)
+      quote= *p == ',' || *p == '"' || *p == '\n' || *p == '\r';
+    if (quote)
+      *out++= '"';
   }
-  Safefree(salloc);
 
-  /** Store the result from the Query */
-  if (!unbuffered_result) {
-    ret = drizzle_result_buffer(*result);
-  } else {
-    /* Just buffer columns */
-    ret = drizzle_column_buffer(*result);
+  for (p= field; p < end; p++)
+  {
+    c= (unsigned char) *p;
+    if (csv)
+    {
+      if (c == '"')
+        *out++= '"';
+    }
+    else if (c == '\\' || c == '\t' || c == '\n' || c == '\r' || !c)
+    {
+      *out++= '\\';
+      c= c == '\t' ? 't' : c == '\n' ? 'n' : c == '\r' ? 'r' : c ? c : '0';
+    }
+    if (upgrade && c > 127)
+    {
+      *out++= (char) (0xc0 | (c >> 6));
+      c= 0x80 | (c & 0x3f);
+    }
+    *out++= (char) c;
   }
 
-  if (ret != DRIZZLE_RETURN_OK) 
-    do_error(h, drizzle_result_error_code(*result), drizzle_result_error(*result)
-             ,drizzle_result_sqlstate(*result));
-      
+  if (quote)
+    *out++= '"';
+  return out;
+}
 
-  /* Best way to be sure we return the right number if possible */
-  rows = drizzle_result_row_count(*result);
-  if (!rows)
-    rows = drizzle_result_affected_rows(*result);
+/*
+  Writes what drizzle_st_copy_out has collected in buf to fp
+*/
+static int copy_out_flush(SV *sth, PerlIO *fp, SV *buf)
+{
+  STRLEN len= SvCUR(buf);
 
-  return(rows);
+  SvCUR_set(buf, 0);
+  if (len && PerlIO_write(fp, SvPVX(buf), len) != (SSize_t) len)
+  {
+    do_error(sth, JW_ERR_IO, "drizzle_copy_out could not write output",
+             NULL);
+    return FALSE;
+  }
+  return TRUE;
 }
 
-
 /***************************************************************************
  *
- *  Name:    dbd_st_execute
+ *  Name:    drizzle_st_copy_out
  *
- *  Purpose: Called for preparing an SQL statement; our part of the
- *           statement handle constructor
+ *  Purpose: Writes the rows left in the result of an executed statement
+ *           to a file handle as tab or comma separated lines, in the
+ *           format drizzle_copy_in reads. The fields are escaped straight
+ *           from the row into an output buffer of chunk_bytes, which is
+ *           written whenever it fills up, so no SVs are made per field.
+ *           ChopBlanks applies as for fetch. Text columns are written as
+ *           the server sent them, which is UTF-8 with drizzle_enable_utf8;
+ *           other fields are upgraded when the handle is :utf8, as print
+ *           would.
  *
- *  Input:   sth - statement handle being initialized
+ *  Input:   sth - statement handle
  *           imp_sth - drivers private statement handle data
+ *           fh - file handle to write to
+ *           attribs - hash ref with format, header and chunk_bytes
  *
- *  Returns: TRUE for success, FALSE otherwise; do_error will
- *           be called in the latter case
+ *  Returns: The number of rows written, or -2 after do_error
  *
  **************************************************************************/
-
-int dbd_st_execute(SV* sth, imp_sth_t* imp_sth)
+IV drizzle_st_copy_out(SV *sth, imp_sth_t *imp_sth, SV *fh, SV *attribs)
 {
-  char actual_row_num[64];
-  int i;
-  uint16_t colcount;
-  SV **statement;
-  D_imp_dbh_from_sth;
   D_imp_xxh(sth);
-#if defined (dTHR)
-  dTHR;
-#endif
-
-  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-    PerlIO_printf(DBILOGFP,
-      " -> dbd_st_execute for %08lx\n", (u_long) sth);
-
-  if (!SvROK(sth)  ||  SvTYPE(SvRV(sth)) != SVt_PVHV)
-    croak("Expected hash array");
+  D_imp_dbh_from_sth;
+  unsigned long chunk_bytes= COPY_OUT_CHUNK_BYTES;
+  bool csv= FALSE, header= FALSE, chop_blanks, utf8_fh;
+  bool *upgrade= NULL;
+  char sep, *out;
+  drizzle_column_st *col;
+  drizzle_return_t ret;
+  drizzle_row_t row;
+  size_t *lengths, len, need;
+  int num_fields= 0, i;
+  IV rows= 0;
+  PerlIO *fp;
+  SV *buf, **svp;
 
-  /* Free cached array attributes */
-  for (i= 0;  i < AV_ATTRIB_LAST;  i++)
+  if (attribs && SvROK(attribs) && SvTYPE(SvRV(attribs)) == SVt_PVHV)
   {
-    if (imp_sth->av_attr[i])
-      SvREFCNT_dec(imp_sth->av_attr[i]);
+    HV *hv= (HV*) SvRV(attribs);
 
-    imp_sth->av_attr[i]= Nullav;
+    if ((svp= hv_fetch(hv, "format", 6, FALSE)) && SvOK(*svp))
+    {
+      if (strEQ(SvPV_nolen(*svp), "csv"))
+        csv= TRUE;
+      else if (!strEQ(SvPV_nolen(*svp), "tsv"))
+      {
+        do_error(sth, JW_ERR_ARGUMENT,
+                 "drizzle_copy_out format must be 'tsv' or 'csv'", NULL);
+        return -2;
+      }
+    }
+    if ((svp= hv_fetch(hv, "chunk_bytes", 11, FALSE)) && SvTRUE(*svp))
+      chunk_bytes= SvUV(*svp);
+    if ((svp= hv_fetch(hv, "header", 6, FALSE)))
+      header= SvTRUE(*svp);
   }
 
-  statement= hv_fetch((HV*) SvRV(sth), "Statement", 9, FALSE);
+  if (!imp_sth->result)
+  {
+    do_error(sth, JW_ERR_SEQUENCE, "drizzle_copy_out() without execute()",
+             NULL);
+    return -2;
+  }
+  if (!(fp= IoOFP(sv_2io(fh))))
+  {
+    do_error(sth, JW_ERR_ARGUMENT,
+             "drizzle_copy_out expects a file handle open for writing", NULL);
+    return -2;
+  }
 
-  /*
-     Clean-up previous result set(s) for sth to prevent
-     'Commands out of sync' error
-  */
-  drizzle_st_free_result_sets(sth, imp_sth);
+  drizzle_st_lazy_done(imp_sth, FALSE);
+  sep= csv ? ',' : '\t';
+  chop_blanks= DBIc_is(imp_sth, DBIcf_ChopBlanks);
+  utf8_fh= PerlIO_isutf8(fp) ? TRUE : FALSE;
+  num_fields= drizzle_result_column_count(imp_sth->result);
+  buf= sv_2mortal(newSV(chunk_bytes + 1));
+  SvPOK_on(buf);
 
-  imp_sth->row_num= drizzle_st_internal_execute(
-                                                sth,
-                                                *statement,
-                                                NULL,
-                                                DBIc_NUM_PARAMS(imp_sth),
-                                                imp_sth->params,
-                                                &imp_sth->result,
-                                                imp_dbh->con,
-                                                imp_sth->unbuffered_result
-                                               );
+  /* Which columns are byte strings for fetch */
+  Newz(0, upgrade, num_fields ? num_fields : 1, bool);
+  drizzle_column_seek(imp_sth->result, 0);
+  for (i= 0; i < num_fields; i++)
+  {
+    col= drizzle_column_next(imp_sth->result);
+    upgrade[i]= utf8_fh && (!imp_dbh->enable_utf8 ||
+      (drizzle_column_flags(col) & DRIZZLE_COLUMN_FLAGS_BINARY));
+    if (header)
+    {
+      const char *name= drizzle_column_name(col);
+
+      len= strlen(name);
+      SvGROW(buf, SvCUR(buf) + 2*len + 4);
+      out= SvPVX(buf) + SvCUR(buf);
+      if (i)
+        *out++= sep;
+      out= copy_out_field(out, name, len, csv,
+                          utf8_fh && !imp_dbh->enable_utf8);
+      SvCUR_set(buf, out - SvPVX(buf));
+    }
+  }
+  if (header)
+    sv_catpvn(buf, "\n", 1);
 
-  colcount = 0;
-  if (imp_sth->result != NULL)
+  for (;;)
   {
-    colcount = drizzle_result_column_count(imp_sth->result);
+    row= drizzle_st_next_row(sth, imp_sth, &lengths, &ret);
+    while (!row && ret == DRIZZLE_RETURN_OK &&
+           (drizzle_st_next_page(sth, imp_sth) ||
+            drizzle_st_next_chunk(sth, imp_sth)))
+      row= drizzle_st_next_row(sth, imp_sth, &lengths, &ret);
+    if (!row)
+      break;
 
-    if (imp_sth->row_num+1 != (uint64_t )-1)
+    need= num_fields + 1;
+    for (i= 0; i < num_fields; i++)
+      need+= 2*lengths[i] + 2;
+    SvGROW(buf, SvCUR(buf) + need + 1);
+    out= SvPVX(buf) + SvCUR(buf);
+
+    for (i= 0; i < num_fields; i++)
     {
-      if (!colcount) {
-        // XXX serious sync issues arise when multiple cons are used w/ threading
-        imp_dbh->insert_id= drizzle_result_insert_id(imp_sth->result);
-      }
-      else
-      {
-        /** Store the result in the current statement handle */
-        DBIc_NUM_FIELDS(imp_sth)= colcount;
-        DBIc_ACTIVE_on(imp_sth);
-        imp_sth->done_desc= 0;
-      }
+      len= lengths[i];
+      if (chop_blanks && row[i])
+        len= chop_blanks_len(row[i], len);
+      if (i)
+        *out++= sep;
+      out= copy_out_field(out, row[i], len, csv, upgrade[i]);
     }
+    *out++= '\n';
+    SvCUR_set(buf, out - SvPVX(buf));
+    rows++;
 
-    imp_sth->warning_count = drizzle_result_warning_count(imp_sth->result);
+    if (imp_sth->release_fetched && imp_sth->rowbuf.active)
+      rowbuf_release_read(&imp_sth->rowbuf, imp_dbh);
+
+    if (SvCUR(buf) >= chunk_bytes && !copy_out_flush(sth, fp, buf))
+    {
+      Safefree(upgrade);
+      dbd_st_finish(sth, imp_sth);
+      return -2;
+    }
   }
+  Safefree(upgrade);
 
-  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+  if (ret != DRIZZLE_RETURN_OK)
   {
-    /* 
-      PerlIO_printf doesn't always handle imp_sth->row_num %llu 
-      consistantly!!
-    */
-    sprintf(actual_row_num, "%l", (long int) imp_sth->row_num);
-    PerlIO_printf(DBILOGFP,
-                  " <- dbd_st_execute returning imp_sth->row_num %s\n",
-                  actual_row_num);
+    if (ret != DRIZZLE_RETURN_TIMEOUT)
+      do_error(sth, drizzle_result_error_code(imp_sth->result),
+               drizzle_result_error(imp_sth->result),
+               drizzle_result_sqlstate(imp_sth->result));
+    dbd_st_finish(sth, imp_sth);
+    return -2;
   }
+  dbd_st_finish(sth, imp_sth);
 
-  return (int)imp_sth->row_num;
+  if (!copy_out_flush(sth, fp, buf))
+    return -2;
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBILOGFP, "\t\tdrizzle_copy_out wrote %ld rows\n",
+                  (long) rows);
+  return rows;
 }
 
- /**************************************************************************
- *
- *  Name:    dbd_describe
- *
- *  Purpose: Called from within the fetch method to describe the result
- *
- *  Input:   sth - statement handle being initialized
- *           imp_sth - our part of the statement handle, there's no
- *               need for supplying both; Tim just doesn't remove it
- *
- *  Returns: TRUE for success, FALSE otherwise; do_error will
- *           be called in the latter case
- *
- **************************************************************************/
+/*
+  Whether the len bytes at p are a number as JSON writes it
+*/
+static bool json_number(const char *p, size_t len)
+{
+  const char *end= p + len;
 
-int dbd_describe(SV* sth, imp_sth_t* imp_sth)
+  if (p < end && *p == '-')
+    p++;
+  if (p == end || !isDIGIT(*p))
+    return FALSE;
+  if (*p == '0')
+    p++;
+  else
+    while (p < end && isDIGIT(*p))
+      p++;
+  if (p < end && *p == '.')
+  {
+    if (++p == end || !isDIGIT(*p))
+      return FALSE;
+    while (p < end && isDIGIT(*p))
+      p++;
+  }
+  if (p < end && (*p == 'e' || *p == 'E'))
+  {
+    if (++p < end && (*p == '+' || *p == '-'))
+      p++;
+    if (p == end || !isDIGIT(*p))
+      return FALSE;
+    while (p < end && isDIGIT(*p))
+      p++;
+  }
+  return p == end;
+}
+
+/*
+  Writes len bytes from s to out as a JSON string. With upgrade, bytes
+  above 127 are characters of their own, as in a Perl byte string;
+  otherwise they are taken to be UTF-8 already. out needs room for
+  6*len+2 bytes. Returns the end of what was written.
+*/
+static char *json_string(char *out, const char *s, size_t len, bool upgrade)
 {
-  D_imp_xxh(sth);
-  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-    PerlIO_printf(DBILOGFP, "\t--> dbd_describe\n");
+  const char *end= s + len;
+  unsigned char c;
 
-  imp_sth->done_desc= 1;
-  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-    PerlIO_printf(DBILOGFP, "\t<- dbd_describe\n");
-  return TRUE;
+  *out++= '"';
+  for (; s < end; s++)
+  {
+    c= (unsigned char) *s;
+    if (c == '"' || c == '\\')
+    {
+      *out++= '\\';
+      *out++= (char) c;
+    }
+    else if (c < 0x20)
+    {
+      *out++= '\\';
+      switch (c)
+      {
+        case '\b': *out++= 'b'; break;
+        case '\f': *out++= 'f'; break;
+        case '\n': *out++= 'n'; break;
+        case '\r': *out++= 'r'; break;
+        case '\t': *out++= 't'; break;
+        default:
+          sprintf(out, "u%04x", c);
+          out+= 5;
+      }
+    }
+    else if (upgrade && c > 127)
+    {
+      *out++= (char) (0xc0 | (c >> 6));
+      *out++= (char) (0x80 | (c & 0x3f));
+    }
+    else
+      *out++= (char) c;
+  }
+  *out++= '"';
+  return out;
 }
 
-/**************************************************************************
+/***************************************************************************
  *
- *  Name:    dbd_st_fetch
+ *  Name:    drizzle_st_fetchall_json
  *
- *  Purpose: Called for fetching a result row
+ *  Purpose: Returns the rows left in the result of an executed statement
+ *           as a JSON array of objects or, with shape => 'arrays', of
+ *           arrays. The document is written in C straight from the rows;
+ *           the column names are escaped once. Values of numeric columns
+ *           are written as numbers, NULL as null. Text is UTF-8 where
+ *           fetch would return a character string, other bytes are
+ *           encoded as characters of their own.
  *
- *  Input:   sth - statement handle being initialized
+ *  Input:   sth - statement handle
  *           imp_sth - drivers private statement handle data
+ *           attribs - hash ref with shape, or undef
  *
- *  Returns: array of columns; the array is allocated by DBI via
- *           DBIS->get_fbav(imp_sth), even the values of the array
- *           are prepared, we just need to modify them appropriately
+ *  Returns: A new SV holding the UTF-8 encoded document, NULL after
+ *           do_error
  *
  **************************************************************************/
-
-AV*
-dbd_st_fetch(SV *sth, imp_sth_t* imp_sth)
+SV *drizzle_st_fetchall_json(SV *sth, imp_sth_t *imp_sth, SV *attribs)
 {
-  int num_fields, ChopBlanks, i;
-  size_t *lengths;
-  AV *av;
-  int av_length, av_readonly;
-  drizzle_row_t row;
-
-  D_imp_dbh_from_sth;
-  drizzle_con_st *con= imp_dbh->con;
-
   D_imp_xxh(sth);
-
+  D_imp_dbh_from_sth;
+  bool objects= TRUE, chop_blanks, first= TRUE;
+  bool *numeric, *upgrade;
+  drizzle_column_st *col;
   drizzle_return_t ret;
-  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-    PerlIO_printf(DBILOGFP, "\t-> dbd_st_fetch\n");
-
-
-  ChopBlanks = DBIc_is(imp_sth, DBIcf_ChopBlanks);
-
-  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-    PerlIO_printf(DBILOGFP,
-                  "\t\tdbd_st_fetch for %08lx, chopblanks %d\n",
-                  (u_long) sth, ChopBlanks);
-
-  if (!imp_sth->result || (imp_sth->unbuffered_result && !imp_sth->row))
+  drizzle_row_t row;
+  size_t *lengths, len, need;
+  STRLEN *name_end;
+  int num_fields, i;
+  SV *json, *names, **svp;
+  char *out;
+
+  if (attribs && SvROK(attribs) && SvTYPE(SvRV(attribs)) == SVt_PVHV &&
+      (svp= hv_fetch((HV*) SvRV(attribs), "shape", 5, FALSE)) && SvOK(*svp))
   {
-    do_error(sth, JW_ERR_SEQUENCE, "fetch() without execute()" ,NULL);
-    return Nullav;
+    if (strEQ(SvPV_nolen(*svp), "arrays"))
+      objects= FALSE;
+    else if (!strEQ(SvPV_nolen(*svp), "objects"))
+    {
+      do_error(sth, JW_ERR_ARGUMENT,
+               "drizzle_fetchall_json shape must be 'objects' or 'arrays'",
+               NULL);
+      return NULL;
+    }
   }
 
-  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+  if (!imp_sth->result)
   {
-    PerlIO_printf(DBILOGFP, "\tdbd_st_fetch result set details\n");
-    PerlIO_printf(DBILOGFP, "\tdrizzle_result_column_count=%d\n",
-                  drizzle_result_column_count(imp_sth->result));
-    PerlIO_printf(DBILOGFP, "\tdrizzle_result_row_count=%lu\n",
-                  drizzle_result_row_count(imp_sth->result));
-    PerlIO_printf(DBILOGFP, "\tdrizzle_result_affected_rows=%lu\n",
-                  drizzle_result_affected_rows(imp_sth->result));
+    do_error(sth, JW_ERR_SEQUENCE,
+             "drizzle_fetchall_json() without execute()", NULL);
+    return NULL;
   }
 
-  if ( imp_sth->row) {
-      row= imp_sth->row;
-      imp_sth->row= NULL;
-  } else {
-    if (imp_sth->unbuffered_result) {
-      // We dont buffer result, but we will buffer each row
-      row= drizzle_row_buffer(imp_sth->result, &ret);
-    } else {
-      row= drizzle_row_next(imp_sth->result);
-    } 
-  }
+  drizzle_st_lazy_done(imp_sth, FALSE);
+  chop_blanks= DBIc_is(imp_sth, DBIcf_ChopBlanks);
+  num_fields= drizzle_result_column_count(imp_sth->result);
+  Newz(0, numeric, num_fields ? num_fields : 1, bool);
+  Newz(0, upgrade, num_fields ? num_fields : 1, bool);
+  New(0, name_end, num_fields ? num_fields : 1, STRLEN);
 
-  if (!row)
+  /* "name": for each column, one after the other */
+  names= sv_2mortal(newSVpvn("", 0));
+  drizzle_column_seek(imp_sth->result, 0);
+  for (i= 0; i < num_fields; i++)
   {
-    if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    col= drizzle_column_next(imp_sth->result);
+    numeric[i]= native2sql(drizzle_column_type(col))->is_num;
+    upgrade[i]= !imp_dbh->enable_utf8 ||
+      (drizzle_column_flags(col) & DRIZZLE_COLUMN_FLAGS_BINARY);
+    if (objects)
     {
-      PerlIO_printf(DBILOGFP, "\tdbd_st_fetch, no more rows to fetch");
+      const char *name= drizzle_column_name(col);
+
+      len= strlen(name);
+      SvGROW(names, SvCUR(names) + 6*len + 4);
+      out= json_string(SvPVX(names) + SvCUR(names), name, len,
+                       !imp_dbh->enable_utf8);
+      *out++= ':';
+      SvCUR_set(names, out - SvPVX(names));
     }
-    if (imp_sth->unbuffered_result && ret != DRIZZLE_RETURN_OK)
-      do_error(sth, drizzle_result_error_code(imp_sth->result),
-               drizzle_result_error(imp_sth->result),
-               drizzle_result_sqlstate(imp_sth->result));
-
-    dbd_st_finish(sth, imp_sth);
-    return Nullav;
+    name_end[i]= SvCUR(names);
   }
 
-  num_fields= drizzle_result_column_count(imp_sth->result);
-  lengths= (size_t *)drizzle_row_field_sizes(imp_sth->result);
-
-  if ((av= DBIc_FIELDS_AV(imp_sth)) != Nullav)
+  json= newSV(8192);
+  sv_setpvn(json, "[", 1);
+  for (;;)
   {
-    av_length= av_len(av)+1;
+    row= drizzle_st_next_row(sth, imp_sth, &lengths, &ret);
+    while (!row && ret == DRIZZLE_RETURN_OK &&
+           (drizzle_st_next_page(sth, imp_sth) ||
+            drizzle_st_next_chunk(sth, imp_sth)))
+      row= drizzle_st_next_row(sth, imp_sth, &lengths, &ret);
+    if (!row)
+      break;
 
-    if (av_length != num_fields)              /* Resize array if necessary */
+    /* a comma and brackets, then per field a comma and the value: null
+       or the escaped text in quotes */
+    need= SvCUR(names) + 3;
+    for (i= 0; i < num_fields; i++)
+      need+= 6*lengths[i] + 5;
+    if (SvLEN(json) < SvCUR(json) + need + 1)
+      SvGROW(json, 2*(SvCUR(json) + need));
+    out= SvPVX(json) + SvCUR(json);
+
+    if (!first)
+      *out++= ',';
+    first= FALSE;
+    *out++= objects ? '{' : '[';
+    for (i= 0; i < num_fields; i++)
     {
-      if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-        PerlIO_printf(DBILOGFP, "\t<- dbd_st_fetch, size of results array(%d) != num_fields(%d)\n",
-                      av_length, num_fields);
-
-      if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-        PerlIO_printf(DBILOGFP, "\t<- dbd_st_fetch, result fields(%d)\n",
-                      DBIc_NUM_FIELDS(imp_sth));
-
-      av_readonly = SvREADONLY(av);
+      if (i)
+        *out++= ',';
+      if (objects)
+      {
+        STRLEN start= i ? name_end[i-1] : 0;
 
-      if (av_readonly)
-        SvREADONLY_off( av );              /* DBI sets this readonly */
+        Copy(SvPVX(names) + start, out, name_end[i] - start, char);
+        out+= name_end[i] - start;
+      }
 
-      while (av_length < num_fields)
+      len= lengths[i];
+      if (!row[i])
       {
-        av_store(av, av_length++, newSV(0));
+        Copy("null", out, 4, char);
+        out+= 4;
+        continue;
       }
-
-      while (av_length > num_fields)
+      if (chop_blanks)
+        len= chop_blanks_len(row[i], len);
+      if (numeric[i] && json_number(row[i], len))
       {
-        SvREFCNT_dec(av_pop(av));
-        av_length--;
+        Copy(row[i], out, len, char);
+        out+= len;
       }
-      if (av_readonly)
-        SvREADONLY_on(av);
+      else
+        out= json_string(out, row[i], len, upgrade[i]);
     }
-  }
+    *out++= objects ? '}' : ']';
+    SvCUR_set(json, out - SvPVX(json));
 
-  av= DBIS->get_fbav(imp_sth);
+    if (imp_sth->release_fetched && imp_sth->rowbuf.active)
+      rowbuf_release_read(&imp_sth->rowbuf, imp_dbh);
+  }
+  sv_catpvn(json, "]", 1);
+  Safefree(numeric);
+  Safefree(upgrade);
+  Safefree(name_end);
 
-  /* paranoid - just in case something else put it somewhere else */
-  drizzle_column_seek(imp_sth->result, 0);
-  for (i= 0;  i < num_fields; ++i)
+  if (ret != DRIZZLE_RETURN_OK)
   {
-    drizzle_field_t field= row[i];
-    drizzle_column_st *col= drizzle_column_next(imp_sth->result);
+    if (ret != DRIZZLE_RETURN_TIMEOUT)
+      do_error(sth, drizzle_result_error_code(imp_sth->result),
+               drizzle_result_error(imp_sth->result),
+               drizzle_result_sqlstate(imp_sth->result));
+    dbd_st_finish(sth, imp_sth);
+    SvREFCNT_dec(json);
+    return NULL;
+  }
+  dbd_st_finish(sth, imp_sth);
+
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBILOGFP, "\t\tdrizzle_fetchall_json built %lu bytes\n",
+                  (unsigned long) SvCUR(json));
+  return json;
+}
+
+/***************************************************************************
+ *
+ *  Name:    drizzle_st_each_row
+ *
+ *  Purpose: Calls code for each row left in the result of an executed
+ *           statement, with @_ aliased to the columns that fetch fills.
+ *           Rows are read with dbd_st_fetch directly rather than through
+ *           DBI's fetch method. Where perl has MULTICALL and code is not
+ *           an XSUB, the sub is entered once and run for every row;
+ *           otherwise it is called with call_sv. Stops early, leaving
+ *           the statement active, when code returns false.
+ *
+ *  Input:   sth - statement handle
+ *           imp_sth - drivers private statement handle data
+ *           code - code reference
+ *
+ *  Returns: The number of rows code was called for, or -2 after
+ *           do_error
+ *
+ **************************************************************************/
+IV drizzle_st_each_row(SV *sth, imp_sth_t *imp_sth, SV *code)
+{
+  D_imp_xxh(sth);
+  IV rows= 0;
+  AV *row;
+  CV *cv;
 
-    SV *sv= AvARRAY(av)[i]; /* Note: we (re)use the SV in the AV	*/
+  if (!SvROK(code) || SvTYPE(SvRV(code)) != SVt_PVCV)
+  {
+    do_error(sth, JW_ERR_ARGUMENT,
+             "drizzle_each_row expects a code reference", NULL);
+    return -2;
+  }
+  cv= (CV*) SvRV(code);
 
-    if (field)
+#ifdef dMULTICALL
+  if (!CvISXSUB(cv))
+  {
+    dSP;
+    dMULTICALL;
+    U8 gimme= G_SCALAR;
+    AV *args= newAV();
+    I32 i, n;
+
+    /* @_ of the sub is ours for the duration */
+    ENTER;
+    SAVEFREESV((SV*) args);
+    SAVESPTR(GvAV(PL_defgv));
+    GvAV(PL_defgv)= args;
+    PUSH_MULTICALL(cv);
+    while ((row= dbd_st_fetch(sth, imp_sth)))
     {
-      STRLEN len= lengths[i];
-      if (ChopBlanks)
-      {
-        while (len && field[len-1] == ' ')
-        {	--len; }
-      }
-      sv_setpvn(sv, field, len);
-      /* UTF8 */
-      /*HELMUT*/
-#if defined(sv_utf8_decode)
-        if (imp_dbh->enable_utf8 && !(drizzle_column_flags(col) & DRIZZLE_COLUMN_FLAGS_BINARY))
+      n= AvFILLp(row) + 1;
+      av_clear(args);
+      av_extend(args, n);
+      for (i= 0; i < n; i++)
+        AvARRAY(args)[i]= SvREFCNT_inc(AvARRAY(row)[i]);
+      AvFILLp(args)= n - 1;
+
+      rows++;
+      MULTICALL;
+      if (!SvTRUE(*PL_stack_sp))
+        break;
+    }
+    POP_MULTICALL;
+    LEAVE;
+    PERL_UNUSED_VAR(gimme);
+  }
+  else
 #endif
-          sv_utf8_decode(sv);
-      /* END OF UTF8 */
+  {
+    bool more= TRUE;
+    I32 i;
+
+    while (more && (row= dbd_st_fetch(sth, imp_sth)))
+    {
+      dSP;
+
+      ENTER;
+      SAVETMPS;
+      PUSHMARK(SP);
+      EXTEND(SP, AvFILLp(row) + 1);
+      for (i= 0; i <= AvFILLp(row); i++)
+        PUSHs(AvARRAY(row)[i]);
+      PUTBACK;
+
+      rows++;
+      call_sv((SV*) cv, G_SCALAR);
+      SPAGAIN;
+      more= SvTRUE(POPs);
+      PUTBACK;
+      FREETMPS;
+      LEAVE;
     }
-    else
-      (void) SvOK_off(sv);  /*  Field is NULL, return undef  */
   }
 
-  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-    PerlIO_printf(DBILOGFP, "\t<- dbd_st_fetch, %d cols\n", num_fields);
+  if (SvTRUE(DBIc_ERR(imp_xxh)))
+    return -2;
+  return rows;
+}
 
-  return av;
+/*
+  Makes the shared key SVs fetchrow_hashref stores the columns of res
+  under, for the given hash_key_cases
+*/
+static void drizzle_st_hash_keys(imp_sth_t *imp_sth, drizzle_result_st *res,
+                                 int key_case)
+{
+  drizzle_column_st *col;
+
+  if (imp_sth->hash_keys)
+    SvREFCNT_dec((SV*) imp_sth->hash_keys);
+  imp_sth->hash_keys= newAV();
+  if (imp_sth->reuse_hv)
+    hv_clear(imp_sth->reuse_hv);
+
+  drizzle_column_seek(res, 0);
+  while ((col= drizzle_column_next(res)))
+    av_push(imp_sth->hash_keys,
+            hash_key_sv(drizzle_column_name(col), key_case));
+  imp_sth->hash_keys_generation= imp_sth->meta_generation;
+  imp_sth->hash_keys_case= key_case;
+}
+
+/***************************************************************************
+ *
+ *  Name:    drizzle_st_fetchrow_hashref
+ *
+ *  Purpose: fetchrow_hashref without DBI's Perl code: the column names
+ *           are made shared, pre-hashed key SVs once per result, and each
+ *           row is stored into a hash sized for it. With
+ *           drizzle_reuse_hashref, the same hash is filled again for
+ *           every row instead.
+ *
+ *  Input:   sth - statement handle
+ *           imp_sth - drivers private statement handle data
+ *           keyattr - NAME, NAME_lc or NAME_uc, or NULL for
+ *               FetchHashKeyName
+ *
+ *  Returns: A new reference to the row hash, NULL at the end of the
+ *           result or after do_error
+ *
+ **************************************************************************/
+SV *drizzle_st_fetchrow_hashref(SV *sth, imp_sth_t *imp_sth, SV *keyattr)
+{
+  int key_case, i, num_fields;
+  SV *key;
+  AV *row;
+  HV *hv;
+  HE *he;
 
+  if ((key_case= hash_key_case(sth, keyattr)) < 0)
+    return NULL;
+
+  if (!(row= dbd_st_fetch(sth, imp_sth)))
+    return NULL;
+
+  if (!imp_sth->meta_checked)
+    drizzle_st_meta_check(imp_sth, imp_sth->result);
+  if (!imp_sth->hash_keys ||
+      imp_sth->hash_keys_generation != imp_sth->meta_generation ||
+      imp_sth->hash_keys_case != key_case)
+    drizzle_st_hash_keys(imp_sth, imp_sth->result, key_case);
+
+  num_fields= AvFILLp(row) + 1;
+  if (imp_sth->reuse_hashref)
+  {
+    if (!imp_sth->reuse_hv)
+      imp_sth->reuse_hv= newHV();
+    hv= imp_sth->reuse_hv;
+    for (i= 0; i < num_fields; i++)
+    {
+      key= AvARRAY(imp_sth->hash_keys)[i];
+      he= hv_fetch_ent(hv, key, TRUE, SvSHARED_HASH(key));
+      sv_setsv(HeVAL(he), AvARRAY(row)[i]);
+    }
+    return newRV_inc((SV*) hv);
+  }
+
+  hv= newHV();
+  hv_ksplit(hv, num_fields);
+  for (i= 0; i < num_fields; i++)
+  {
+    key= AvARRAY(imp_sth->hash_keys)[i];
+    (void) hv_store_ent(hv, key, newSVsv(AvARRAY(row)[i]),
+                        SvSHARED_HASH(key));
+  }
+  return newRV_noinc((SV*) hv);
 }
 
 /***************************************************************************
@@ -2290,6 +6806,8 @@ dbd_st_fetch(SV *sth, imp_sth_t* imp_sth)
 
 int dbd_st_finish(SV* sth, imp_sth_t* imp_sth) {
   D_imp_xxh(sth);
+  D_imp_dbh_from_sth;
+  int retval= 1;
 
 #if defined (dTHR)
   dTHR;
@@ -2315,12 +6833,16 @@ int dbd_st_finish(SV* sth, imp_sth_t* imp_sth) {
     drizzle_st_free_result_sets(sth, imp_sth);
   }
 
+  if (imp_dbh->combine_owner == imp_sth &&
+      !drizzle_db_flush_combined(sth, imp_dbh))
+    retval= 0;
+
   DBIc_ACTIVE_off(imp_sth);
   if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
   {
     PerlIO_printf(DBILOGFP, "\n<-- dbd_st_finish\n");
   }
-  return 1;
+  return retval;
 }
 
 
@@ -2339,6 +6861,7 @@ int dbd_st_finish(SV* sth, imp_sth_t* imp_sth) {
 
 void dbd_st_destroy(SV *sth, imp_sth_t *imp_sth) {
   D_imp_xxh(sth);
+  D_imp_dbh_from_sth;
 
 #if defined (dTHR)
   dTHR;
@@ -2353,11 +6876,31 @@ void dbd_st_destroy(SV *sth, imp_sth_t *imp_sth) {
     imp_sth->params= NULL;
   }
 
-  if (imp_sth->unbuffered_result && imp_sth->row)
-  {
-    drizzle_row_free(imp_sth->result, imp_sth->row);
-    imp_sth->row= NULL;
-  }
+  drizzle_st_lazy_done(imp_sth, FALSE);
+  drizzle_st_lazy_free(imp_sth);
+  drizzle_st_intern_free(imp_sth);
+  Safefree(imp_sth->fetch_text);
+  if (imp_sth->hash_keys)
+    SvREFCNT_dec((SV*) imp_sth->hash_keys);
+  imp_sth->hash_keys= NULL;
+  if (imp_sth->reuse_hv)
+    SvREFCNT_dec((SV*) imp_sth->reuse_hv);
+  imp_sth->reuse_hv= NULL;
+  if (imp_sth->intern_columns)
+    SvREFCNT_dec(imp_sth->intern_columns);
+  imp_sth->intern_columns= NULL;
+  if (imp_sth->result && imp_sth->owned_row)
+    drizzle_row_free(imp_sth->result, imp_sth->owned_row);
+  imp_sth->owned_row= NULL;
+  imp_sth->row= NULL;
+  rowbuf_free(&imp_sth->rowbuf, imp_dbh);
+  if (imp_sth->con)
+    drizzle_db_own_con(imp_dbh, imp_sth->con, imp_sth, NULL);
+  if (imp_dbh->combine_owner == imp_sth)
+    (void) drizzle_db_flush_combined(sth, imp_dbh);
+  if (imp_sth->combine_buf)
+    SvREFCNT_dec(imp_sth->combine_buf);
+  imp_sth->combine_buf= NULL;
   /* This causes a double-free */
   /*if (imp_sth->result)
   {
@@ -2373,6 +6916,9 @@ void dbd_st_destroy(SV *sth, imp_sth_t *imp_sth) {
       SvREFCNT_dec(imp_sth->av_attr[i]);
     imp_sth->av_attr[i]= Nullav;
   }
+  if (imp_sth->meta_sig)
+    SvREFCNT_dec(imp_sth->meta_sig);
+  imp_sth->meta_sig= NULL;
   /* let DBI know we've done it   */
   DBIc_IMPSET_off(imp_sth);
 }
@@ -2417,6 +6963,108 @@ dbd_st_STORE_attrib(
   {
     imp_sth->unbuffered_result= SvTRUE(valuesv);
   }
+  else if (strEQ(key, "drizzle_max_result_bytes"))
+  {
+    imp_sth->max_result_bytes= SvOK(valuesv) ? SvUV(valuesv) : 0;
+    retval= TRUE;
+  }
+  else if (strEQ(key, "drizzle_max_result_action"))
+  {
+    imp_sth->max_result_action= result_cap_action(valuesv);
+    retval= TRUE;
+  }
+  else if (strEQ(key, "drizzle_compact_rows"))
+  {
+    imp_sth->compact_rows= SvTRUE(valuesv);
+    retval= TRUE;
+  }
+  else if (strEQ(key, "drizzle_release_fetched"))
+  {
+    imp_sth->release_fetched= SvTRUE(valuesv);
+    retval= TRUE;
+  }
+  else if (strEQ(key, "drizzle_lazy_columns"))
+  {
+    imp_sth->lazy_columns= SvTRUE(valuesv);
+    imp_sth->fill_row= NULL;
+    retval= TRUE;
+  }
+  else if (strEQ(key, "drizzle_intern_columns"))
+  {
+    if (imp_sth->intern_columns)
+      SvREFCNT_dec(imp_sth->intern_columns);
+    imp_sth->intern_columns= SvOK(valuesv) ? newSVsv(valuesv) : NULL;
+    imp_sth->fill_row= NULL;
+    retval= TRUE;
+  }
+  else if (strEQ(key, "drizzle_bind_by_ref"))
+  {
+    imp_sth->bind_by_ref= SvTRUE(valuesv);
+    retval= TRUE;
+  }
+  else if (strEQ(key, "drizzle_reuse_hashref"))
+  {
+    imp_sth->reuse_hashref= SvTRUE(valuesv);
+    retval= TRUE;
+  }
+  else if (strEQ(key, "drizzle_datetime_as"))
+  {
+    int mode= datetime_as_mode(valuesv);
+
+    if (mode < 0)
+    {
+      do_error(sth, JW_ERR_ARGUMENT,
+               "drizzle_datetime_as must be 'string', 'epoch' or 'epoch_ms'",
+               NULL);
+      return FALSE;
+    }
+    imp_sth->datetime_as= mode;
+    imp_sth->fill_row= NULL;
+    retval= TRUE;
+  }
+  else if (strEQ(key, "drizzle_datetime_offset"))
+  {
+    IV offset;
+
+    if (!datetime_offset(valuesv, &offset))
+    {
+      do_error(sth, JW_ERR_ARGUMENT,
+               "drizzle_datetime_offset must be seconds or [+-]HH[:MM]", NULL);
+      return FALSE;
+    }
+    imp_sth->datetime_offset= offset;
+    retval= TRUE;
+  }
+  else if (strEQ(key, "drizzle_cancel_threshold"))
+  {
+    imp_sth->cancel_threshold= SvOK(valuesv) ? SvUV(valuesv) : 0;
+    retval= TRUE;
+  }
+  else if (strEQ(key, "drizzle_write_combine"))
+  {
+    D_imp_dbh_from_sth;
+
+    if (imp_dbh->combine_owner == imp_sth &&
+        !drizzle_db_flush_combined(sth, imp_dbh))
+      return FALSE;
+    write_combine_limits(imp_sth, valuesv);
+    retval= TRUE;
+  }
+  else if (strEQ(key, "drizzle_query_timeout"))
+  {
+    imp_sth->query_timeout= SvOK(valuesv) ? SvUV(valuesv) : 0;
+    retval= TRUE;
+  }
+  else if (strEQ(key, "drizzle_in_chunk"))
+  {
+    imp_sth->in_chunk= SvOK(valuesv) ? SvUV(valuesv) : 0;
+    retval= TRUE;
+  }
+  else if (strEQ(key, "drizzle_fetch_size"))
+  {
+    imp_sth->fetch_size= SvOK(valuesv) ? SvUV(valuesv) : 0;
+    retval= TRUE;
+  }
 
   if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
     PerlIO_printf(DBILOGFP,
@@ -2471,12 +7119,17 @@ dbd_st_FETCH_internal(
   AV *av= Nullav;
   drizzle_column_st *col;
 
+  /* Are the cached values for the columns of this result? */
+  if (cacheit && res && !imp_sth->meta_checked)
+    drizzle_st_meta_check(imp_sth, res);
+
   /* Are we asking for a legal value? */
   if (what < 0 ||  what >= AV_ATTRIB_LAST)
     do_error(sth, JW_ERR_NOT_IMPLEMENTED, "Not implemented", NULL);
 
   /* Return cached value, if possible */
-  else if (cacheit  &&  imp_sth->av_attr[what])
+  else if (cacheit  &&  imp_sth->av_attr[what]  &&  imp_sth->meta_checked  &&
+           imp_sth->av_attr_generation[what] == imp_sth->meta_generation)
     av= imp_sth->av_attr[what];
 
   /* Does this sth really have a result? */
@@ -2569,10 +7222,13 @@ dbd_st_FETCH_internal(
     }
 
     /* Ensure that this value is kept, decremented in
-     *  dbd_st_destroy and dbd_st_execute.  */
+     *  dbd_st_destroy or once the columns change.  */
     if (!cacheit)
       return sv_2mortal(newRV_noinc((SV*)av));
+    if (imp_sth->av_attr[what])
+      SvREFCNT_dec(imp_sth->av_attr[what]);
     imp_sth->av_attr[what]= av;
+    imp_sth->av_attr_generation[what]= imp_sth->meta_generation;
   }
 
   if (av == Nullav)
@@ -2692,6 +7348,8 @@ dbd_st_FETCH_internal(
 
         return sv_2mortal(my_ulonglong2str(imp_dbh->insert_id));
       }
+      else if (strEQ(key, "drizzle_in_chunk"))
+        retsv= sv_2mortal(newSVuv(imp_sth->in_chunk));
       break;
     case 17:
       if (strEQ(key, "drizzle_type_name"))
@@ -2702,16 +7360,68 @@ dbd_st_FETCH_internal(
         retsv= ST_FETCH_AV(AV_ATTRIB_IS_PRI_KEY);
       else if (strEQ(key, "drizzle_max_length"))
         retsv= ST_FETCH_AV(AV_ATTRIB_MAX_LENGTH);
-      else if (strEQ(key, "drizzle_unbuffered_result"))
-        retsv= boolSV(imp_sth->unbuffered_result);
+      else if (strEQ(key, "drizzle_fetch_size"))
+        retsv= sv_2mortal(newSVuv(imp_sth->fetch_size));
+      break;
+    case 19:
+      if (strEQ(key, "drizzle_datetime_as"))
+        retsv= sv_2mortal(newSVpv(
+          datetime_as_names[imp_sth->datetime_as], 0));
+      else if (strEQ(key, "drizzle_bind_by_ref"))
+        retsv= boolSV(imp_sth->bind_by_ref);
+      break;
+    case 20:
+      if (strEQ(key, "drizzle_compact_rows"))
+        retsv= boolSV(imp_sth->compact_rows);
+      else if (strEQ(key, "drizzle_lazy_columns"))
+        retsv= boolSV(imp_sth->lazy_columns);
       break;
     case 21:
       if (strEQ(key, "drizzle_warning_count"))
         retsv= sv_2mortal(newSViv((IV) imp_sth->warning_count));
+      else if (strEQ(key, "drizzle_query_timeout"))
+        retsv= sv_2mortal(newSVuv(imp_sth->query_timeout));
+      else if (strEQ(key, "drizzle_reuse_hashref"))
+        retsv= boolSV(imp_sth->reuse_hashref);
+      else if (strEQ(key, "drizzle_write_combine") &&
+               !imp_sth->combine_max_rows)
+        retsv= &sv_undef;
+      else if (strEQ(key, "drizzle_write_combine"))
+      {
+        HV *hv= newHV();
+
+        hv_store(hv, "max_rows", 8,
+                 newSVuv(imp_sth->combine_max_rows), 0);
+        hv_store(hv, "max_bytes", 9,
+                 newSVuv(imp_sth->combine_max_bytes), 0);
+        retsv= sv_2mortal(newRV_noinc((SV*) hv));
+      }
+      break;
+    case 22:
+      if (strEQ(key, "drizzle_intern_columns"))
+        retsv= imp_sth->intern_columns ?
+          sv_2mortal(newSVsv(imp_sth->intern_columns)) : &sv_undef;
+      break;
+    case 23:
+      if (strEQ(key, "drizzle_release_fetched"))
+        retsv= boolSV(imp_sth->release_fetched);
+      else if (strEQ(key, "drizzle_datetime_offset"))
+        retsv= sv_2mortal(newSViv(imp_sth->datetime_offset));
+      break;
+    case 24:
+      if (strEQ(key, "drizzle_max_result_bytes"))
+        retsv= sv_2mortal(my_ulonglong2str(imp_sth->max_result_bytes));
+      else if (strEQ(key, "drizzle_cancel_threshold"))
+        retsv= sv_2mortal(my_ulonglong2str(imp_sth->cancel_threshold));
       break;
     case 25:
       if (strEQ(key, "drizzle_is_auto_increment"))
         retsv = ST_FETCH_AV(AV_ATTRIB_IS_AUTO_INCREMENT);
+      else if (strEQ(key, "drizzle_unbuffered_result"))
+        retsv= boolSV(imp_sth->unbuffered_result);
+      else if (strEQ(key, "drizzle_max_result_action"))
+        retsv= sv_2mortal(newSVpv(
+          result_cap_action_names[imp_sth->max_result_action], 0));
       break;
     }
     break;
@@ -2797,7 +7507,8 @@ int dbd_bind_ph (SV *sth, imp_sth_t *imp_sth, SV *param, SV *value,
   int buffer_is_null= 0;
   int buffer_length= slen;
   unsigned int buffer_type= 0;
-  attribs= attribs;
+  bool by_ref= imp_sth->bind_by_ref;
+  SV **svp;
   maxlen= maxlen;
 
   if (param_num <= 0  ||  param_num > DBIc_NUM_PARAMS(imp_sth))
@@ -2810,7 +7521,7 @@ int dbd_bind_ph (SV *sth, imp_sth_t *imp_sth, SV *param, SV *value,
      This fixes the bug whereby no warning was issued upone binding a
      defined non-numeric as numeric
    */
-  if (SvOK(value) &&
+  if (SvOK(value) && !param_list(value) &&
       (sql_type == SQL_NUMERIC  ||
        sql_type == SQL_DECIMAL  ||
        sql_type == SQL_INTEGER  ||
@@ -2834,7 +7545,13 @@ int dbd_bind_ph (SV *sth, imp_sth_t *imp_sth, SV *param, SV *value,
     return FALSE;
   }
 
-  rc = bind_param(&imp_sth->params[idx], value, sql_type);
+  svp= DBD_ATTRIB_GET_SVP(attribs,
+                          "drizzle_bind_by_ref",
+                          strlen("drizzle_bind_by_ref"));
+  if (svp)
+    by_ref= SvTRUE(*svp);
+
+  rc = bind_param(&imp_sth->params[idx], value, sql_type, by_ref);
 
   return rc;
 }
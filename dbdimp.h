@@ -57,7 +57,63 @@ enum errMsgs {
     AS_ERR_EMBEDDED,
     TX_ERR_AUTOCOMMIT,
     TX_ERR_COMMIT,
-    TX_ERR_ROLLBACK
+    TX_ERR_ROLLBACK,
+    JW_ERR_RESULT_TOO_LARGE,
+    JW_ERR_ROW_POSITION,
+    JW_ERR_QUERY_TIMEOUT,
+    JW_ERR_ARGUMENT,
+    JW_ERR_IO
+};
+
+
+/*
+ *  What to do once a buffered result grows past drizzle_max_result_bytes
+ */
+enum result_cap_actions {
+    RESULT_CAP_ERROR = 0,        /*  free the rows and fail the execute   */
+    RESULT_CAP_STREAM,           /*  keep the rows, read the rest unbuffered */
+    RESULT_CAP_SPILL             /*  move the rows to a mmap'ed temp file */
+};
+
+
+/*
+ *  Reference points for drizzle_seek
+ */
+enum seek_whence {
+    SEEK_ROW_ABS = 0,            /*  from the first row                   */
+    SEEK_ROW_REL,                /*  from the current position            */
+    SEEK_ROW_END                 /*  from behind the last row             */
+};
+
+
+/*
+ *  How fetch returns DATE, DATETIME and TIMESTAMP columns, as set with
+ *  drizzle_datetime_as
+ */
+enum datetime_as_modes {
+    DATETIME_AS_STRING = 0,      /*  as the server sends them             */
+    DATETIME_AS_EPOCH,           /*  seconds since 1970, NV with fractions */
+    DATETIME_AS_EPOCH_MS         /*  milliseconds since 1970              */
+};
+
+
+/*
+ *  What drizzle_intern_columns does with a column of the current result
+ */
+enum intern_states {
+    INTERN_OFF = 0,              /*  fetch copies the value               */
+    INTERN_ON,                   /*  fetch returns a shared string        */
+    INTERN_SAMPLE                /*  shared, while distinct values are counted */
+};
+
+
+/*
+ *  Column names fetchrow_hashref uses as keys, after FetchHashKeyName
+ */
+enum hash_key_cases {
+    HASH_KEY_NAME = 0,           /*  NAME                                 */
+    HASH_KEY_NAME_LC,            /*  NAME_lc                              */
+    HASH_KEY_NAME_UC             /*  NAME_uc                              */
 };
 
 
@@ -85,6 +141,96 @@ enum av_attribs {
 };                         /*  purposes only                                */
 
 
+/*
+ *  Driver side row buffer, used instead of drizzle_result_buffer() when
+ *  drizzle_compact_rows is set or the size of a buffered result is capped.
+ *  Rows are kept as records in a list of chunks: a NULL bitmap, then a 32
+ *  bit length and the data of each non-NULL field. The index points to the
+ *  record of every row. Once spilled, the records live in a temporary file
+ *  that is mapped into memory when buffering completes.
+ */
+#define ROWBUF_CHUNK_SIZE 65536
+#define ROWBUF_BITMAP_SIZE(columns) (((columns) + 7) / 8)
+
+typedef struct rowbuf_chunk_st {
+    struct rowbuf_chunk_st *next;
+    size_t size;                 /*  bytes allocated for data             */
+    size_t used;                 /*  bytes of data in use                 */
+    char data[1];
+} rowbuf_chunk_t;
+
+typedef struct rowbuf_st {
+    bool active;                 /*  rows of the current result live here */
+    uint16_t columns;
+    uint64_t rows;               /*  rows stored                          */
+    uint64_t rows_read;          /*  rows handed out by rowbuf_next       */
+    uint64_t first_row;          /*  rows before this one were released   */
+    uint64_t bytes;              /*  memory held by the chunks            */
+    rowbuf_chunk_t *head;
+    rowbuf_chunk_t *tail;
+    char **index;                /*  record of each row                   */
+    uint64_t index_size;         /*  entries allocated in index           */
+    PerlIO *spill;               /*  temporary file, once spilled         */
+    size_t spill_len;            /*  bytes written to the spill file      */
+    char *map;                   /*  the spill file, mapped for reading   */
+    size_t map_len;
+    char **fields;               /*  the row handed out by rowbuf_next    */
+    size_t *lengths;
+} rowbuf_t;
+
+
+/*
+ *  Upper limit for drizzle_aux_connections
+ */
+#define MAX_AUX_CONNECTIONS 8
+
+/*
+ *  Most USE and SET statements kept to replay on auxiliary connections;
+ *  past that, queries are no longer routed to them
+ */
+#define MAX_SESSION_LOG 100
+
+
+/*
+ *  Flush limits of drizzle_write_combine, unless given
+ */
+#define WRITE_COMBINE_ROWS 1000
+#define WRITE_COMBINE_BYTES 1048576
+
+
+/*
+ *  Default for drizzle_max_packet_size, the size of statements built by
+ *  the driver, like those of drizzle_bulk_update
+ */
+#define DEFAULT_MAX_PACKET_SIZE 1048576
+
+
+/*
+ *  Keys per query of drizzle_multi_get, unless given
+ */
+#define MULTI_GET_CHUNK 1000
+
+
+/*
+ *  Bytes drizzle_copy_in reads from its file handle at a time
+ */
+#define COPY_IN_READ_SIZE 65536
+
+
+/*
+ *  Bytes drizzle_copy_out collects before each write, unless given
+ */
+#define COPY_OUT_CHUNK_BYTES 262144
+
+
+/*
+ *  Rows drizzle_intern_columns => 'auto' looks at, and how many distinct
+ *  values a column may have in them to stay interned
+ */
+#define INTERN_SAMPLE_ROWS 1000
+#define INTERN_MAX_DISTINCT 100
+
+
 struct imp_drh_st {
     dbih_drc_t com;         /* MUST be first element in structure   */
 };
@@ -112,11 +258,36 @@ struct imp_dbh_st {
     struct {
 	    unsigned int auto_reconnects_ok;
 	    unsigned int auto_reconnects_failed;
+	    uint64_t result_bytes;       /* held by driver side row buffers */
+	    unsigned int result_streams; /* capped results switched to streaming */
+	    unsigned int result_spills;  /* capped results spilled to a file */
+	    unsigned int aux_connects;   /* auxiliary connections opened */
+	    unsigned int queries_killed; /* KILL QUERY sent on a side connection */
     } stats;
     unsigned short int  bind_type_guessing;
     int unbuffered_result;
     uint64_t insert_id;
     bool enable_utf8;
+    unsigned int utf8_generation; /* bumped when enable_utf8 is set */
+    uint64_t max_result_bytes;   /* 0 means buffered results are not capped */
+    int max_result_action;       /* one of result_cap_actions */
+    bool compact_rows;           /* buffer results in a rowbuf_t */
+    bool release_fetched;        /* free buffered rows once fetched */
+    bool lazy_columns;           /* fill fetched columns on first read */
+    unsigned long in_chunk;      /* list values per execute, 0 for all */
+    uint64_t cancel_threshold;   /* unread rows before KILL QUERY, 0 never */
+    unsigned long query_timeout; /* ms a call may wait on the server, 0 forever */
+    unsigned long max_packet_size; /* longest statement the driver builds */
+    struct imp_sth_st *con_owner; /* sth streaming a result on con */
+    struct imp_sth_st *combine_owner; /* sth holding combined INSERT rows */
+    int aux_connections;         /* how many aux_con we may open */
+    int aux_count;               /* how many aux_con are open */
+    drizzle_con_st *aux_con[MAX_AUX_CONNECTIONS];
+    struct imp_sth_st *aux_owner[MAX_AUX_CONNECTIONS];
+    AV *session_log;             /* USE and SET statements run so far */
+    bool session_log_full;       /* MAX_SESSION_LOG reached, no routing */
+    I32 con_synced;              /* session_log entries run on con */
+    I32 aux_synced[MAX_AUX_CONNECTIONS];
 };
 
 
@@ -127,6 +298,9 @@ struct imp_dbh_st {
 typedef struct imp_sth_ph_st {
     SV* value;
     int type;
+    I32 list_offset;    /* slice of an array ref value that is sent, */
+    I32 list_count;     /* see drizzle_in_chunk; 0 for all of it     */
+    bool by_ref;        /* value is the caller's, see drizzle_bind_by_ref */
 } imp_sth_ph_t;
 
 /*
@@ -189,7 +363,63 @@ struct imp_sth_st {
     int   warning_count;         /* Number of warnings after execute()     */
     imp_sth_ph_t* params;        /* Pointer to parameter array             */
     AV* av_attr[AV_ATTRIB_LAST]; /* For caching array attributes        */
+    unsigned long av_attr_generation[AV_ATTRIB_LAST];
+                                 /* meta_generation each av_attr is for    */
+    SV   *meta_sig;              /* column metadata of the last result     */
+    unsigned long meta_generation; /* bumped whenever meta_sig changes     */
+    bool  meta_checked;          /* meta_sig is that of the current result */
+    AV   *hash_keys;             /* shared keys for fetchrow_hashref       */
+    unsigned long hash_keys_generation; /* meta_generation of hash_keys    */
+    int   hash_keys_case;        /* one of hash_key_cases for hash_keys    */
+    bool  reuse_hashref;         /* fetchrow_hashref returns reuse_hv      */
+    HV   *reuse_hv;              /* the hash drizzle_reuse_hashref fills   */
     int   unbuffered_result;     /* TRUE if we should avoid using libdrizzle buffering */
+    bool  streaming;             /* remaining rows are read off the wire   */
+    drizzle_row_t owned_row;     /* last row from drizzle_row_buffer       */
+    size_t *row_lengths;         /* field sizes of the read ahead row      */
+    uint64_t max_result_bytes;   /* cap for buffered results, 0 for none   */
+    int   max_result_action;     /* one of result_cap_actions              */
+    bool  compact_rows;          /* buffer rows ourselves, see rowbuf_t    */
+    bool  release_fetched;       /* free rowbuf chunks behind the cursor   */
+    bool  lazy_columns;          /* fill columns when they are first read  */
+    SV  **lazy_svs;              /* row array SVs carrying the lazy magic  */
+    char *lazy_pending;          /* per column, not filled from lazy_row   */
+    int   lazy_count;            /* entries in lazy_svs and lazy_pending   */
+    drizzle_row_t lazy_row;      /* last fetched row, NULL once it is gone */
+    size_t *lazy_lengths;        /* field sizes of lazy_row                */
+    SV   *intern_columns;        /* drizzle_intern_columns, or NULL        */
+    char *intern;                /* per column, one of intern_states       */
+    HV  **intern_seen;           /* per sampled column, values so far      */
+    int   intern_count;          /* entries in intern and intern_seen      */
+    bool  intern_sampling;       /* some column is INTERN_SAMPLE           */
+    unsigned long intern_rows;   /* rows fetched while sampling            */
+    int   datetime_as;           /* one of datetime_as_modes               */
+    IV    datetime_offset;       /* seconds east of UTC the values are in  */
+    bool  bind_by_ref;           /* bind_param keeps the caller's SV       */
+    void (*fill_row)(imp_sth_t *, AV *, drizzle_row_t, size_t *, int);
+                                 /* fetch plan for the result, or NULL     */
+    char *fetch_text;            /* per column, decoded with enable_utf8   */
+    bool  plan_chop;             /* ChopBlanks when the plan was made      */
+    unsigned int plan_utf8;      /* utf8_generation of the dbh then        */
+    rowbuf_t rowbuf;             /* driver side buffer for the result      */
+    drizzle_con_st *con;         /* connection the result was read from    */
+    unsigned long fetch_size;    /* rows per page, 0 to read all at once   */
+    unsigned long in_chunk;      /* list values per execute, 0 for all     */
+    int   in_param;              /* placeholder split by in_chunk, or -1   */
+    uint64_t cancel_threshold;   /* rows skipped on finish before a KILL   */
+    unsigned long query_timeout; /* ms a call may wait, 0 for no limit     */
+    double deadline;             /* when the running query times out       */
+    bool  paged;                 /* result is read a page at a time        */
+    uint64_t page_offset;        /* row number of the first row in page    */
+    uint64_t page_rows;          /* rows in the current page               */
+    unsigned long combine_max_rows;  /* drizzle_write_combine, 0 if off     */
+    unsigned long combine_max_bytes;
+    STRLEN combine_values;       /* offset of the VALUES row, 0 if none    */
+    STRLEN combine_values_len;
+    SV   *combine_buf;           /* multi-row INSERT built so far          */
+    unsigned long combine_rows;  /* rows in combine_buf                    */
+    unsigned long combine_first; /* execute call of the first of them      */
+    unsigned long combine_calls; /* combined execute calls so far          */
 };
 
 
@@ -257,5 +487,26 @@ extern int drizzle_dr_connect(
 
 extern int drizzle_db_reconnect(SV*);
 int drizzle_st_free_result_sets (SV * sth, imp_sth_t * imp_sth);
+drizzle_con_st *drizzle_db_pick_con(SV *h, imp_dbh_t *imp_dbh,
+                                    imp_sth_t *imp_sth);
+drizzle_con_st *drizzle_db_open_aux(SV *h, imp_dbh_t *imp_dbh);
+HV *drizzle_db_multi_get(SV *dbh, imp_dbh_t *imp_dbh, SV *statement,
+                         SV *keys, SV *attribs);
+int drizzle_db_flush_combined(SV *h, imp_dbh_t *imp_dbh);
+IV drizzle_db_bulk_update(SV *dbh, imp_dbh_t *imp_dbh, char *table,
+                          char *key_col, SV *rows);
+IV drizzle_db_bulk_delete(SV *dbh, imp_dbh_t *imp_dbh, char *table,
+                          char *key_col, SV *keys);
+IV drizzle_db_copy_in(SV *dbh, imp_dbh_t *imp_dbh, char *table, SV *columns,
+                      SV *fh, SV *attribs);
+SV *drizzle_db_select(SV *dbh, imp_dbh_t *imp_dbh, SV *statement,
+                      const char *what, int num_params, imp_sth_ph_t *params);
+IV drizzle_st_tell(SV *sth, imp_sth_t *imp_sth);
+int drizzle_st_seek(SV *sth, imp_sth_t *imp_sth, IV offset, int whence);
+AV *drizzle_st_fetch_range(SV *sth, imp_sth_t *imp_sth, IV start, IV count);
+IV drizzle_st_copy_out(SV *sth, imp_sth_t *imp_sth, SV *fh, SV *attribs);
+SV *drizzle_st_fetchall_json(SV *sth, imp_sth_t *imp_sth, SV *attribs);
+IV drizzle_st_each_row(SV *sth, imp_sth_t *imp_sth, SV *code);
+SV *drizzle_st_fetchrow_hashref(SV *sth, imp_sth_t *imp_sth, SV *keyattr);
 static char *safe_hv_fetch(HV *hv, const char *name, int name_length);
 int parse_number(char *string, STRLEN len, char **end);
@@ -255,13 +255,19 @@ do(dbh, statement, attr=Nullsv, ...)
       params[i].type= SQL_VARCHAR;
     }
   }
-  retval = drizzle_st_internal_execute(dbh, statement, attr, num_params,
-                                       params, &result, imp_dbh->con, 0);
+  if (!drizzle_db_flush_combined(dbh, imp_dbh))
+    retval= -2;
+  else
+  {
+    retval = drizzle_st_internal_execute(dbh, statement, attr, num_params,
+                                         params, &result,
+                                         drizzle_db_pick_con(dbh, imp_dbh, NULL),
+                                         0);
+    drizzle_result_free(result);
+  }
   if (params)
     Safefree(params);
 
-  drizzle_result_free(result);
-
   /* remember that dbd_st_execute must return <= -2 for error	*/
   if (retval == 0)		/* ok with no rows affected	*/
     XST_mPV(0, "0E0");	/* (true but zero)		*/
@@ -298,6 +304,115 @@ ping(dbh)
 
 
 
+void
+drizzle_bulk_update(dbh, table, key_col, rows)
+    SV* dbh
+    char* table
+    char* key_col
+    SV* rows
+  PROTOTYPE: $$$$
+  CODE:
+{
+  D_imp_dbh(dbh);
+  IV retval = drizzle_db_bulk_update(dbh, imp_dbh, table, key_col, rows);
+  if (retval == 0)
+    XST_mPV(0, "0E0");
+  else if (retval < -1)
+    XST_mUNDEF(0);
+  else
+    XST_mIV(0, retval);
+}
+
+
+void
+drizzle_bulk_delete(dbh, table, key_col, keys)
+    SV* dbh
+    char* table
+    char* key_col
+    SV* keys
+  PROTOTYPE: $$$$
+  CODE:
+{
+  D_imp_dbh(dbh);
+  IV retval = drizzle_db_bulk_delete(dbh, imp_dbh, table, key_col, keys);
+  if (retval == 0)
+    XST_mPV(0, "0E0");
+  else if (retval < -1)
+    XST_mUNDEF(0);
+  else
+    XST_mIV(0, retval);
+}
+
+
+SV*
+drizzle_multi_get(dbh, statement, keys, attr=Nullsv)
+    SV* dbh
+    SV* statement
+    SV* keys
+    SV* attr
+  PROTOTYPE: $$$;$
+  CODE:
+{
+  D_imp_dbh(dbh);
+  HV *hv = drizzle_db_multi_get(dbh, imp_dbh, statement, keys, attr);
+  RETVAL = hv ? newRV_noinc((SV*) hv) : &sv_undef;
+}
+  OUTPUT:
+    RETVAL
+
+
+void
+drizzle_copy_in(dbh, table, columns, fh, attr=Nullsv)
+    SV* dbh
+    char* table
+    SV* columns
+    SV* fh
+    SV* attr
+  PROTOTYPE: $$$$;$
+  CODE:
+{
+  D_imp_dbh(dbh);
+  IV retval = drizzle_db_copy_in(dbh, imp_dbh, table, columns, fh, attr);
+  if (retval == 0)
+    XST_mPV(0, "0E0");
+  else if (retval < -1)
+    XST_mUNDEF(0);
+  else
+    XST_mIV(0, retval);
+}
+
+
+SV*
+_select(dbh, statement, what, ...)
+    SV* dbh
+    SV* statement
+    char* what
+  PROTOTYPE: $$$@
+  CODE:
+{
+  D_imp_dbh(dbh);
+  int num_params= items - 3, i;
+  struct imp_sth_ph_st* params= NULL;
+  SV *rv;
+
+  if (num_params)
+  {
+    Newz(0, params, num_params, struct imp_sth_ph_st);
+    for (i= 0;  i < num_params;  i++)
+    {
+      params[i].value= ST(i+3);
+      params[i].type= SQL_VARCHAR;
+    }
+  }
+  rv = drizzle_db_select(dbh, imp_dbh, statement, what, num_params, params);
+  if (params)
+    Safefree(params);
+  RETVAL = rv ? rv : &sv_undef;
+}
+  OUTPUT:
+    RETVAL
+
+
 void
 quote(dbh, str, type=NULL)
     SV* dbh
@@ -340,24 +455,143 @@ dataseek(sth, pos)
   PROTOTYPE: $$
   CODE:
 {
-  drizzle_return_t ret;
   D_imp_sth(sth);
-  if (imp_sth->result) {
-    drizzle_row_seek(imp_sth->result, pos);
-    if (ret != DRIZZLE_RETURN_OK) {
-      RETVAL = 0;
-      do_error(sth, drizzle_result_error_code(imp_sth->result), drizzle_result_error(imp_sth->result), drizzle_result_sqlstate(imp_sth->result));
-    } else { 
-      RETVAL = 1;
-    }  
-  } else {
+  RETVAL = drizzle_st_seek(sth, imp_sth, pos, SEEK_ROW_ABS);
+}
+  OUTPUT:
+    RETVAL
+
+int
+drizzle_seek(sth, offset, whence="abs")
+    SV* sth
+    IV offset
+    char* whence
+  CODE:
+{
+  D_imp_sth(sth);
+  if (strEQ(whence, "abs"))
+    RETVAL = drizzle_st_seek(sth, imp_sth, offset, SEEK_ROW_ABS);
+  else if (strEQ(whence, "rel"))
+    RETVAL = drizzle_st_seek(sth, imp_sth, offset, SEEK_ROW_REL);
+  else if (strEQ(whence, "end"))
+    RETVAL = drizzle_st_seek(sth, imp_sth, offset, SEEK_ROW_END);
+  else
+  {
     RETVAL = 0;
-    do_error(sth, JW_ERR_NOT_ACTIVE, "Statement not active" ,NULL);
+    do_error(sth, JW_ERR_ROW_POSITION,
+             "whence must be one of 'abs', 'rel' or 'end'", NULL);
   }
 }
   OUTPUT:
     RETVAL
 
+SV*
+drizzle_tell(sth)
+    SV* sth
+  CODE:
+{
+  D_imp_sth(sth);
+  IV pos = drizzle_st_tell(sth, imp_sth);
+  RETVAL = pos < 0 ? &sv_undef : newSViv(pos);
+}
+  OUTPUT:
+    RETVAL
+
+SV*
+drizzle_fetch_range(sth, start, count)
+    SV* sth
+    IV start
+    IV count
+  CODE:
+{
+  D_imp_sth(sth);
+  AV *av = drizzle_st_fetch_range(sth, imp_sth, start, count);
+  RETVAL = av ? newRV_noinc((SV*) av) : &sv_undef;
+}
+  OUTPUT:
+    RETVAL
+
+SV*
+drizzle_fetch_prev(sth)
+    SV* sth
+  CODE:
+{
+  D_imp_sth(sth);
+  IV pos = drizzle_st_tell(sth, imp_sth);
+  AV *av;
+  RETVAL = &sv_undef;
+  if (pos > 0 && (av = drizzle_st_fetch_range(sth, imp_sth, pos - 1, -1)))
+  {
+    if (av_len(av) >= 0)
+      RETVAL = SvREFCNT_inc(*av_fetch(av, 0, FALSE));
+    SvREFCNT_dec((SV*) av);
+  }
+}
+  OUTPUT:
+    RETVAL
+
+void
+drizzle_copy_out(sth, fh, attr=Nullsv)
+    SV* sth
+    SV* fh
+    SV* attr
+  PROTOTYPE: $$;$
+  CODE:
+{
+  D_imp_sth(sth);
+  IV retval = drizzle_st_copy_out(sth, imp_sth, fh, attr);
+  if (retval == 0)
+    XST_mPV(0, "0E0");
+  else if (retval < -1)
+    XST_mUNDEF(0);
+  else
+    XST_mIV(0, retval);
+}
+
+SV*
+drizzle_fetchall_json(sth, attr=Nullsv)
+    SV* sth
+    SV* attr
+  PROTOTYPE: $;$
+  CODE:
+{
+  D_imp_sth(sth);
+  SV *json = drizzle_st_fetchall_json(sth, imp_sth, attr);
+  RETVAL = json ? json : &sv_undef;
+}
+  OUTPUT:
+    RETVAL
+
+void
+drizzle_each_row(sth, code)
+    SV* sth
+    SV* code
+  PROTOTYPE: $$
+  CODE:
+{
+  D_imp_sth(sth);
+  IV retval = drizzle_st_each_row(sth, imp_sth, code);
+  if (retval == 0)
+    XST_mPV(0, "0E0");
+  else if (retval < -1)
+    XST_mUNDEF(0);
+  else
+    XST_mIV(0, retval);
+}
+
+SV*
+fetchrow_hashref(sth, keyattr=Nullsv)
+    SV* sth
+    SV* keyattr
+  CODE:
+{
+  D_imp_sth(sth);
+  SV *rv = drizzle_st_fetchrow_hashref(sth, imp_sth, keyattr);
+  RETVAL = rv ? rv : &sv_undef;
+}
+  OUTPUT:
+    RETVAL
+
 void
 rows(sth)
     SV* sth
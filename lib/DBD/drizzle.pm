@@ -33,6 +33,13 @@ sub driver{
 				   'Attribution' => 'DBD::drizzle by Patrick Galbraith and Clint Byrum'
 				 });
 
+    DBD::drizzle::db->install_method($_)
+      for qw(drizzle_bulk_update drizzle_bulk_delete drizzle_multi_get
+             drizzle_copy_in);
+    DBD::drizzle::st->install_method($_)
+      for qw(drizzle_seek drizzle_tell drizzle_fetch_range drizzle_fetch_prev
+             drizzle_copy_out drizzle_fetchall_json drizzle_each_row);
+
     $drh;
 }
 
@@ -228,6 +235,52 @@ sub prepare {
     $sth;
 }
 
+# The select helpers run simple queries without a statement handle;
+# statement handles and attributes go through DBI as usual, and so does
+# everything while drizzle_max_result_bytes caps the results of the dbh.
+sub _select_via_sth {
+    my($dbh, $statement, $attr)= @_;
+    return ref $statement || ($attr && %$attr) ||
+	$dbh->{drizzle_max_result_bytes};
+}
+
+sub selectrow_array {
+    my($dbh, $statement, $attr, @bind)= @_;
+    return $dbh->SUPER::selectrow_array(@_[1 .. $#_])
+	if _select_via_sth($dbh, $statement, $attr);
+    my $row= DBD::drizzle::db::_select($dbh, $statement, 'row', @bind)
+	or return;
+    return wantarray ? @$row : $row->[0];
+}
+
+sub selectrow_arrayref {
+    my($dbh, $statement, $attr, @bind)= @_;
+    return $dbh->SUPER::selectrow_arrayref(@_[1 .. $#_])
+	if _select_via_sth($dbh, $statement, $attr);
+    return DBD::drizzle::db::_select($dbh, $statement, 'row', @bind);
+}
+
+sub selectrow_hashref {
+    my($dbh, $statement, $attr, @bind)= @_;
+    return $dbh->SUPER::selectrow_hashref(@_[1 .. $#_])
+	if _select_via_sth($dbh, $statement, $attr);
+    return DBD::drizzle::db::_select($dbh, $statement, 'row_hash', @bind);
+}
+
+sub selectcol_arrayref {
+    my($dbh, $statement, $attr, @bind)= @_;
+    return $dbh->SUPER::selectcol_arrayref(@_[1 .. $#_])
+	if _select_via_sth($dbh, $statement, $attr);
+    return DBD::drizzle::db::_select($dbh, $statement, 'col', @bind);
+}
+
+sub selectall_arrayref {
+    my($dbh, $statement, $attr, @bind)= @_;
+    return $dbh->SUPER::selectall_arrayref(@_[1 .. $#_])
+	if _select_via_sth($dbh, $statement, $attr);
+    return DBD::drizzle::db::_select($dbh, $statement, 'all', @bind);
+}
+
 sub db2ANSI {
     my $self = shift;
     my $type = shift;
@@ -1040,6 +1093,131 @@ important if you modify access privileges or create new users.
 =back
 
 
+=head2 Bulk Changes
+
+=over
+
+=item drizzle_bulk_update
+
+    $rows = $dbh->drizzle_bulk_update($table, $key_col, {
+        17 => { status => 'paid', amount => 12.5 },
+        42 => { status => 'void' },
+    });
+
+Updates the rows whose C<$key_col> equals one of the keys of the hash,
+setting the columns given for each key. Instead of one statement per row,
+the driver sends a few statements of the form
+
+    UPDATE $table SET status = CASE $key_col WHEN '17' THEN 'paid'
+      WHEN '42' THEN 'void' ELSE status END, amount = CASE ...
+      WHERE $key_col IN ('17','42')
+
+each no longer than C<drizzle_max_packet_size>. Values are quoted like
+those bound to placeholders, so numbers are only left unquoted with
+C<drizzle_bind_type_guessing>. The table and column names are used as
+given; quote them with quote_identifier() if needed. Returns the number of
+rows changed, "0E0" for none, or undef on error. The statements are not
+wrapped in a transaction; with AutoCommit on, a failure leaves the
+earlier ones applied.
+
+=item drizzle_bulk_delete
+
+    $rows = $dbh->drizzle_bulk_delete($table, $key_col, \@keys);
+
+Deletes the rows whose C<$key_col> is one of C<@keys>, with as few
+C<DELETE FROM $table WHERE $key_col IN (...)> statements as
+C<drizzle_max_packet_size> allows. Quoting and the return value are as
+for drizzle_bulk_update.
+
+=item drizzle_multi_get
+
+    $rows = $dbh->drizzle_multi_get(
+        "SELECT id, name, email FROM users WHERE id IN (?)", \@ids,
+        { chunk => 500, key_col => 'id', parallel => 4 });
+    print $rows->{42}{email};
+
+Looks up many keys with few round trips. The statement must have a
+single placeholder, which is bound to C<chunk> keys at a time as a list
+(see L</LIST PLACEHOLDERS>); C<chunk> defaults to 1000. The rows of all
+queries are returned in a hash reference, each row as a hash of column
+name => value stored under the value of its C<key_col> column, by
+default the first column; a C<key_col> that is not a column of the
+result is an error. Keys without a row are missing from the hash;
+when several rows have the same key, one of them is kept. The rows are
+built in C, converted as fetch() would.
+
+With C<parallel> above 1, up to that many queries run at the same time:
+one on the database handle's connection, the others on auxiliary
+connections (see C<drizzle_aux_connections>, which limits how many may be
+opened). As with those, this only happens while AutoCommit is on; within
+a transaction the queries run one after the other. A single connection
+cannot pipeline queries in libdrizzle. C<drizzle_query_timeout> applies
+to the whole call. Returns undef on error, after the remaining queries
+have been read.
+
+=item drizzle_copy_in
+
+    open my $fh, '<', 'users.csv' or die $!;
+    $rows = $dbh->drizzle_copy_in('users', [qw(id name email)], $fh,
+        { format => 'csv', header => 1 });
+
+Loads the lines read from a file handle into a table. The lines are
+split into fields in C and sent as multi-row
+C<INSERT INTO $table (id,name,email) VALUES (...),(...)> statements of up
+to C<batch_bytes> bytes, by default C<drizzle_max_packet_size>. Each line
+must have one field per column. Fields are quoted like values bound to
+placeholders, so numbers are only left unquoted with
+C<drizzle_bind_type_guessing>.
+
+C<format> is C<tsv>, the default, or C<csv>:
+
+=over
+
+=item tsv
+
+Fields are separated by tabs. C<\t>, C<\n>, C<\r>, C<\0> and C<\\> stand
+for a tab, newline, carriage return, NUL and backslash, and a field of
+just C<\N> is NULL. This is what C<SELECT ... INTO OUTFILE> writes.
+
+=item csv
+
+Fields are separated by commas and may be enclosed in double quotes, with
+a double quote inside written twice. A quoted field may hold commas and
+newlines. An empty unquoted field is NULL, an empty quoted one is the
+empty string.
+
+=back
+
+Lines may end in CRLF, and empty lines are skipped. With C<header> the
+first line is skipped as well.
+
+libdrizzle cannot pipeline, so each INSERT is sent when the previous one
+has been answered. Returns the number of rows inserted, "0E0" for none,
+or undef on error. A malformed line stops the load with an error naming
+its line number; an error from the server names the lines of the failed
+INSERT. The INSERTs are not wrapped in a transaction; with AutoCommit on,
+the earlier ones stay applied.
+
+=back
+
+=head2 Select Helpers
+
+  my ($name) = $dbh->selectrow_array(
+      "SELECT name FROM users WHERE id = ?", undef, $id);
+
+selectrow_array(), selectrow_arrayref(), selectrow_hashref(),
+selectcol_arrayref() and selectall_arrayref() called with an SQL string
+and no attributes (C<undef> or C<{}>) run the query the way do() does,
+without making a statement handle, and turn the rows into Perl data
+directly. They return the same values as DBI's own versions, with
+ChopBlanks, C<drizzle_enable_utf8> and C<FetchHashKeyName> of the
+database handle applied. This saves the cost of setting up and tearing
+down a statement handle for each of many small lookups. Given a
+statement handle or attributes such as C<Slice>, C<Columns> or
+C<MaxRows>, or while C<drizzle_max_result_bytes> is set on the database
+handle, they work through a statement handle as usual.
+
+
 =head1 DATABASE HANDLES
 
 The DBD::drizzle driver supports the following attributes of database
@@ -1077,6 +1255,31 @@ server.
 
 The number of times that DBD::drizzle tried to reconnect to drizzle but failed.
 
+=item aux_connects
+
+The number of auxiliary connections opened because of
+C<drizzle_aux_connections>.
+
+=item queries_killed
+
+The number of queries stopped with KILL QUERY, see
+C<drizzle_cancel_threshold> and C<drizzle_query_timeout>.
+
+=item result_bytes
+
+The number of bytes currently held in result buffers of statements running
+under C<drizzle_compact_rows> or C<drizzle_max_result_bytes>.
+
+=item result_streams
+
+The number of results that hit C<drizzle_max_result_bytes> and switched to
+streaming.
+
+=item result_spills
+
+The number of results that hit C<drizzle_max_result_bytes> and were spilled
+to a temporary file.
+
 =back
 
 The DBD::drizzle driver also supports the following attribute(s) of database
@@ -1119,6 +1322,303 @@ for $dbh using several ways:
 It is possible to set/unset the C<drizzle_use_result> attribute after 
 creation of statement handle. See below.
 
+=item drizzle_compact_rows
+
+When set, buffered results are read by the driver into large chunks of
+memory it manages itself, instead of being kept by libdrizzle as several
+separately allocated blocks per row. Each row is stored as a NULL bitmap
+followed by the length and data of each non-NULL column, and an index of
+the rows keeps C<dataseek> cheap. For results of millions of rows this
+takes noticeably less memory and less time to buffer. It can be given in
+the DSN, set on the database handle, or passed to prepare() and set on the
+statement handle.
+
+  my $sth = $dbh->prepare($query, { drizzle_compact_rows => 1 });
+
+=item drizzle_release_fetched
+
+For forward-only loops over large buffered results. The rows are buffered
+by the driver as with C<drizzle_compact_rows>, and the memory holding rows
+that have been fetched is released as the loop goes on, so the memory
+used by the result shrinks instead of staying at its full size until
+finish(). Unlike C<drizzle_use_result> the connection is free as soon as
+execute() returns. Once a row has been fetched, C<dataseek> can no longer
+go back to it. Like C<drizzle_compact_rows> this can be given in the DSN,
+on the database handle or per statement.
+
+=item drizzle_lazy_columns
+
+  my $sth = $dbh->prepare("SELECT * FROM wide_table",
+                          { drizzle_lazy_columns => 1 });
+
+For wide rows of which only a few columns are used. fetch() then leaves
+the values of the row array to be filled in when they are first read,
+so columns that are never looked at are never copied, chopped or decoded.
+A column of a row has to be read before the next row is fetched; after
+that, columns not read yet are undef. finish() fills in what is left of
+the last row. Columns bound with bind_col() are filled right away. Like
+C<drizzle_compact_rows> this can be given in the DSN, on the database
+handle or per statement.
+
+=item drizzle_reuse_hashref
+
+  my $sth = $dbh->prepare($query, { drizzle_reuse_hashref => 1 });
+  $sth->execute;
+  while (my $row = $sth->fetchrow_hashref) {
+      $total += $row->{amount};
+  }
+
+fetchrow_hashref() is implemented by the driver: the column names are
+turned into shared hash keys once per result (or once for as long as a
+re-executed statement returns the same columns) and each row hash is
+made with room for all columns up front, instead of going through
+DBI's Perl code for every row. C<FetchHashKeyName> and the
+C<NAME>, C<NAME_lc> or C<NAME_uc> argument work as usual. With
+C<drizzle_reuse_hashref> the same hash is returned for every row, with
+its values replaced, which saves making a hash per row for loops that
+only read each row before fetching the next. Do not keep the hash or
+change it then. This is a statement attribute only.
+
+=item drizzle_bind_by_ref
+
+  my $sth = $dbh->prepare("INSERT INTO log (id, message) VALUES (?, ?)",
+                          { drizzle_bind_by_ref => 1 });
+  $sth->bind_param(1, $id);
+  $sth->bind_param(2, $message);
+  while (($id, $message) = next_entry()) {
+      $sth->execute;
+  }
+
+Normally bind_param() and execute() with arguments copy each value,
+reusing the copy made for the last execute where they can. With
+C<drizzle_bind_by_ref> the variables themselves are kept instead and
+their values are read when the statement is executed, so big strings
+are not copied and changing a bound variable changes what the next
+execute() sends. It can also be given to a single bind_param() call,
+as in C<< $sth->bind_param(1, $blob, { drizzle_bind_by_ref => 1 }) >>.
+This is a statement attribute only.
+
+=item drizzle_intern_columns
+
+  my $sth = $dbh->prepare("SELECT status, country, amount FROM orders",
+                          { drizzle_intern_columns => [ 'status', 1 ] });
+
+For big results with columns that take only a few values, like status
+codes or country names. The values of the columns given, by name or by
+number counting from 0, are made shared strings, so rows with the same
+value, and copies of it as made by fetchall_arrayref() or
+selectall_arrayref(), use a single string buffer instead of one each.
+With C<< drizzle_intern_columns => 'auto' >> the driver looks at the
+first 1000 rows and keeps doing this for each column that is not
+numeric and had at most 100 different values in them. This is a
+statement attribute only.
+
+=item drizzle_datetime_as
+
+=item drizzle_datetime_offset
+
+  my $sth = $dbh->prepare("SELECT created, value FROM samples",
+                          { drizzle_datetime_as => 'epoch' });
+
+By default DATE, DATETIME and TIMESTAMP columns are fetched as the
+strings the server sends. With C<drizzle_datetime_as> set to C<epoch>
+the driver parses them itself and returns the seconds since 1970-01-01
+00:00:00 UTC, as a number with a fraction for values that have one;
+with C<epoch_ms> it returns whole milliseconds. C<string> is the
+default. This saves parsing every value again with DateTime or
+Time::Local in Perl. Values that are no valid date, like
+C<0000-00-00>, are still returned as strings.
+
+The values are taken to be UTC unless C<drizzle_datetime_offset> says
+how far ahead of UTC they are, in seconds or as C<+HH:MM>:
+
+  my $sth = $dbh->prepare($query, { drizzle_datetime_as     => 'epoch_ms',
+                                    drizzle_datetime_offset => '+02:00' });
+
+Both are statement attributes only. prepare() fails, and so does setting
+them on the statement, with any other value.
+
+=item drizzle_max_result_action
+
+By default a result is read completely into client memory by execute(),
+however large it is. Setting C<drizzle_max_result_bytes> makes the driver
+read the rows itself and keep track of how much memory they take. When the
+limit is exceeded, C<drizzle_max_result_action> decides what happens:
+
+  error   execute() fails, the result is discarded (the default)
+  stream  the rows read so far are kept, the rest is read from the
+          server one row at a time as you fetch, just like with
+          drizzle_use_result
+  spill   the rows are moved to a temporary file, which is read back
+          through mmap() once the whole result is in; on systems
+          without mmap() this is the same as 'stream'
+
+Note that a streamed result keeps the connection busy until all rows have
+been fetched or the statement is finished, and that C<< $sth->rows >> only
+counts the rows buffered at execute() time. Both attributes may be given
+in the DSN, set on the database handle, or passed to prepare() and set on
+the statement handle.
+
+  $dbh->{drizzle_max_result_bytes} = 64 * 1024 * 1024;
+  $dbh->{drizzle_max_result_action} = 'spill';
+
+=item drizzle_cancel_threshold
+
+When a statement streaming an unbuffered result is finished before all
+rows have been fetched, the rows left still have to be read off the
+connection before it can be used again; for a big result that takes as
+long as fetching them. With C<drizzle_cancel_threshold> set to a number
+of rows, once that many rows have been skipped the driver opens a short
+lived second connection and sends C<KILL QUERY> for the first one, so the
+server stops sending. The threshold keeps the cost of the extra
+connection away from results that are nearly done anyway. The attribute
+can be given in the DSN, set on the database handle, or passed to
+prepare() and set on the statement handle; 0, the default, never kills.
+
+=item drizzle_query_timeout
+
+The number of milliseconds a statement may take, from sending the query
+until its result has been read. The driver talks to the server in
+non-blocking mode and checks the deadline while waiting; when it passes,
+the query is stopped with C<KILL QUERY> on a short lived second
+connection and the statement fails with the error "Query exceeded
+drizzle_query_timeout" and SQLSTATE C<HYT00>. For streaming results the
+deadline covers the whole fetch, however steadily the rows arrive. Like C<drizzle_cancel_threshold> it can
+be given in the DSN, set on the database handle, or passed to prepare()
+and set on the statement handle; 0, the default, waits forever. Stopped
+queries are counted in C<queries_killed>.
+
+  my $sth = $dbh->prepare("SELECT * FROM big JOIN bigger",
+                          { drizzle_query_timeout => 5000 });
+
+=item drizzle_write_combine
+
+A statement handle attribute that makes repeated executes of an INSERT
+(or REPLACE) with a single C<VALUES (?, ...)> row cheap: with AutoCommit
+off, execute() does not run the statement but adds its row to a multi-row
+INSERT kept in memory, and returns 1. The rows are sent as one statement
+once C<max_rows> rows or C<max_bytes> bytes have been collected, and
+before commit(), finish(), the destruction of the handle, or anything
+else running on the database handle. rollback() and disconnect() drop
+them. The value is a hash reference; limits not given default to 1000
+rows and 1MB, and a false value turns combining off again.
+
+  $dbh->{AutoCommit} = 0;
+  my $sth = $dbh->prepare("INSERT INTO log (ts, msg) VALUES (?, ?)",
+                          { drizzle_write_combine => { max_rows => 500 } });
+  $sth->execute($_->{ts}, $_->{msg}) for @entries;
+  $dbh->commit;
+
+The catch is that errors show up late: a failing row makes the whole
+multi-row INSERT fail when it is sent, which may be during a later
+execute() or commit() and on another handle. The error message then
+names the range of execute calls, counted from 1 since prepare(), whose
+rows were lost, like "Combined INSERT of execute calls 501 to 1000
+failed: Duplicate entry ...". Statements that are not of this form, like
+INSERT ... SELECT or ON DUPLICATE KEY UPDATE, and all statements with
+AutoCommit on, are executed as usual. C<drizzle_insertid> is that of the
+combined INSERT.
+
+=item drizzle_fetch_size
+
+When set to a number of rows on a statement, a SELECT with an ORDER BY
+is read from the server a page of that many rows at a time: execute()
+runs the query with C<LIMIT 0, fetch_size> appended, and whenever the
+rows of a page have all been fetched, the query is run again for the
+next page. In between, the
+connection is free for other statements, and the client never holds more
+than one page in memory. This is meant for slow consumers of big results,
+where C<drizzle_unbuffered_result> would keep the connection busy for a
+long time.
+
+  my $sth = $dbh->prepare("SELECT * FROM log ORDER BY id",
+                          { drizzle_fetch_size => 10000 });
+
+libdrizzle has no server side cursors, so this is an emulation, and some
+care is needed:
+
+=over
+
+=item *
+
+Each page is a new query. Unless the ORDER BY is unique, like one on the
+primary key, rows may be returned twice or skipped, and rows changed by
+others between pages will show. Within a transaction with a consistent
+snapshot the latter does not happen.
+
+=item *
+
+The server finds and skips the rows of all earlier pages for each page,
+so the work done grows with the square of the number of pages. Use pages
+of many thousand rows, or a C<WHERE id E<gt> ?> query of your own for
+very big results.
+
+=item *
+
+Statements without an ORDER BY of their own (one in a subquery does not
+count), statements that already have a LIMIT, or use INTO, FOR UPDATE or
+LOCK IN SHARE MODE, and anything but a SELECT, are executed as usual.
+
+=item *
+
+C<< $sth->rows >> counts the rows of the pages read so far,
+C<drizzle_max_result_bytes> does not apply, and the result cannot be
+positioned with C<drizzle_seek>.
+
+=back
+
+This is a statement attribute only: pass it to prepare() or set it on
+the statement handle.
+
+=item drizzle_in_chunk
+
+The most values of a list placeholder (see L</LIST PLACEHOLDERS>) that
+are sent with one query. When a longer list is bound, the statement is
+run once per chunk of the list: statements without a result, like DELETE,
+run them all within execute(), and C<< $sth->rows >> is the total. For a
+SELECT, the next chunk is queried once the rows of the previous one have
+all been fetched, so the rows come as one result, though not in a global
+order. Such a result cannot be positioned with C<drizzle_seek>, and
+C<drizzle_fetch_size> does not apply. 0, the default, sends any list in
+one query. Only the longest list of a statement is split. The attribute
+can be given in the DSN, set on the database handle, or passed to
+prepare() and set on the statement handle.
+
+=item drizzle_aux_connections
+
+While a statement streams an unbuffered result (see C<drizzle_unbuffered_result>
+and C<drizzle_max_result_bytes>), the connection is busy until every row
+has been read, and any other query on the same database handle fails.
+Setting C<drizzle_aux_connections> to a number up to 8 lets the driver run
+such queries on up to that many auxiliary connections instead. These are
+opened on demand with the same host, credentials and schema as the main
+connection, and kept for reuse until disconnect.
+
+  $dbh->{drizzle_aux_connections} = 2;
+  my $outer = $dbh->prepare("SELECT id FROM big", { drizzle_unbuffered_result => 1 });
+  $outer->execute;
+  while (my ($id) = $outer->fetchrow_array) {
+    $dbh->do("UPDATE small SET seen = 1 WHERE id = ?", undef, $id);
+  }
+
+Since the auxiliary connections are separate sessions, they are only used
+while AutoCommit is on; within a transaction everything stays on the main
+connection. So that they have the same schema and session variables,
+the C<USE> and C<SET> statements run on the database handle (other than
+C<SET TRANSACTION>) while C<drizzle_aux_connections> is set are kept and
+run on each auxiliary connection before it is used, and on the main
+connection for those that ran elsewhere; set it before running any that
+the auxiliary connections need. At most 100 such statements are kept.
+After that the driver warns and no longer uses auxiliary connections for
+the database handle.
+
+=item drizzle_max_packet_size
+
+The longest statement, in bytes, the driver builds on its own, as
+drizzle_bulk_update and drizzle_bulk_delete do. It should not exceed the
+server's C<max_allowed_packet>. Defaults to 1MB; it can be given in the
+DSN or set on the database handle.
+
 =item drizzle_enable_utf8
 
 This attribute determines whether DBD::drizzle should assume strings
@@ -1440,6 +1940,109 @@ number of columns of your results vary. Varying numbers of columns could
 result in your script crashing. This is something that will be fixed soon.
 
 
+=head1 LIST PLACEHOLDERS
+
+An array reference bound to a placeholder is sent as the comma separated
+list of its elements, so one statement serves lists of any length:
+
+  my $sth = $dbh->prepare("SELECT * FROM users WHERE id IN (?)");
+  $sth->execute(\@ids);
+  $sth->bind_param(1, [1, 2, 3], SQL_INTEGER);
+
+Each element is quoted and escaped like a value bound by itself, and
+undef becomes NULL. With a numeric type given to bind_param(), or with
+C<drizzle_bind_type_guessing>, elements that are numbers are sent
+unquoted. An empty list is sent as C<NULL>, which C<IN (NULL)> never
+matches. Blessed array references are bound as strings as before. See
+C<drizzle_in_chunk> for splitting very long lists.
+
+=head1 SCROLLABLE CURSORS
+
+Buffered results (that is, anything but C<drizzle_use_result> and
+results that switched to streaming under C<drizzle_max_result_bytes>)
+can be read in any order. The position is the number of the row the
+next fetch returns, counting from 0.
+
+  $pos = $sth->drizzle_tell;
+
+returns the current position.
+
+  $sth->drizzle_seek($offset, $whence);
+
+moves it, where C<$whence> is C<'abs'> (the default) to count from the
+first row, C<'rel'> to count from the current position, or C<'end'> to
+count from behind the last row. Seeking outside of the result fails.
+The older C<< $sth->func($pos, 'dataseek') >> is the same as an absolute
+seek.
+
+  $rows = $sth->drizzle_fetch_range($start, $count);
+
+returns a reference to an array of up to C<$count> rows starting at row
+C<$start>, each row being an array reference. With a negative C<$count>
+the rows are returned backwards, from C<$start> down. Finally
+
+  $sth->drizzle_seek(0, 'end');
+  while (my $row = $sth->drizzle_fetch_prev) {
+    ...
+  }
+
+walks a result backwards. With C<drizzle_release_fetched>, rows already
+fetched cannot be revisited.
+
+=head1 ROW CALLBACKS
+
+  $sth->execute;
+  $rows = $sth->drizzle_each_row(sub {
+      my ($host, $bytes) = @_;
+      $total{$host} += $bytes;
+      1;
+  });
+
+calls the sub for each row not fetched yet, with C<@_> aliased to the
+column values, the same scalars fetchrow_arrayref returns (and that
+bind_col binds). The rows are read without going through DBI's fetch
+method for each one, and on perls with C<MULTICALL> the sub is set up
+only once for the whole loop. The loop stops when the sub returns false,
+so end it with a true value; the statement then stays active and the
+remaining rows can be fetched as usual. Returns the number of rows the
+sub was called for, "0E0" for none, or undef on error.
+
+=head1 EXPORTING RESULTS
+
+  $sth = $dbh->prepare("SELECT * FROM orders", { drizzle_use_result => 1 });
+  $sth->execute;
+  open my $fh, '>', 'orders.tsv' or die $!;
+  $rows = $sth->drizzle_copy_out($fh, { format => 'tsv', header => 1 });
+
+writes the rows of an executed statement that have not been fetched yet
+to a file handle, one line per row, in the C<tsv> or C<csv> format
+drizzle_copy_in reads (see L</Bulk Changes>). With C<header> a line of
+column names comes first. The lines are built in C straight from the
+rows, without making a Perl value per field, and written to the handle
+whenever C<chunk_bytes> (256k by default) have been collected. This works
+with buffered and C<drizzle_use_result> results alike, as well as with
+C<drizzle_fetch_size> and C<drizzle_in_chunk>.
+
+ChopBlanks applies as for fetch. Text columns are written as the server
+sends them, which is UTF-8 with C<drizzle_enable_utf8>; give the file
+handle a C<:utf8> layer in that case. On such a handle, binary columns
+are encoded as print would encode them. The statement is finished
+afterwards. Returns the number of rows written, "0E0" for none, or undef
+on error.
+
+  $json = $sth->drizzle_fetchall_json({ shape => 'objects' });
+
+returns the rows not fetched yet as one JSON document, built in C without
+the Perl rows a JSON encoder would otherwise walk: by default an array of
+objects keyed by column name, with C<< shape => 'arrays' >> an array of
+arrays in column order. Values of numeric columns (see C<drizzle_is_num>)
+are written as JSON numbers, NULL as null, everything else as strings.
+The result is a UTF-8 encoded byte string, ready to be sent as it is;
+text columns are taken as UTF-8 with C<drizzle_enable_utf8>, otherwise
+each byte is a character of its own, as C<encode_json> would treat the
+values fetch returns. ChopBlanks applies, and the statement is finished
+afterwards. Returns undef on error.
+
 =head1 MULTITHREADING
 
 The multithreading capabilities of DBD::drizzle depend completely
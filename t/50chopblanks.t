@@ -21,7 +21,7 @@ if ($@) {
     plan skip_all => 
         "ERROR: $DBI::errstr. Can't continue test";
 }
-plan tests => 29; 
+plan tests => 33; 
 
 ok $dbh->do("DROP TABLE IF EXISTS $table"), "drop table if exists $table";
 
@@ -62,6 +62,15 @@ for $ref (@$rows) {
 	cmp_ok $$ref[1], 'eq', $n, "should have blanks chopped";
 
 }
+# Changing ChopBlanks within a result applies to the next row
+ok ($sth2= $dbh->prepare("SELECT id, name FROM $table ORDER BY id"));
+$sth2->{'ChopBlanks'} = 0;
+ok $sth2->execute;
+$sth2->fetchrow_arrayref;
+is $sth2->fetchrow_arrayref->[1], ' ', "not chopped";
+$sth2->{'ChopBlanks'} = 1;
+is $sth2->fetchrow_arrayref->[1], ' a b c', "chopped after setting ChopBlanks";
+
 ok $sth->finish;
 ok $sth2->finish;
 $dbh->{AutoCommit} = 1;
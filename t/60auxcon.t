@@ -0,0 +1,66 @@
+#!perl -w
+# vim: ft=perl
+#
+#   This is testing drizzle_aux_connections
+#
+
+use strict;
+use DBI;
+use Test::More;
+use lib 't', '.';
+require 'lib.pl';
+
+use vars qw($test_dsn $test_user $test_password $table);
+
+my $dbh;
+eval {$dbh= DBI->connect($test_dsn, $test_user, $test_password,
+                      { RaiseError => 1, PrintError => 0, AutoCommit => 1 });};
+if ($@) {
+    plan skip_all =>
+        "ERROR: $DBI::errstr. Can't continue test";
+}
+plan tests => 17;
+
+ok $dbh->do("DROP TABLE IF EXISTS $table"), "drop table if exists $table";
+
+ok $dbh->do("CREATE TABLE $table (id INT, seen INT)"), "create table $table";
+
+ok $dbh->do("INSERT INTO $table (id, seen) VALUES (1, 0), (2, 0), (3, 0)"),
+  "insert rows";
+
+# Without auxiliary connections session statements are not kept, so these
+# do not use up the log and stop routing below
+ok !grep({ !$dbh->do("SET \@dbd_unkept = $_") } 1 .. 101),
+  "session statements without auxiliary connections";
+
+$dbh->{drizzle_aux_connections}= 1;
+is $dbh->{drizzle_aux_connections}, 1, "attribute set";
+
+my $outer= $dbh->prepare("SELECT id FROM $table ORDER BY id",
+                         { drizzle_unbuffered_result => 1 });
+ok $outer->execute, "execute unbuffered";
+
+my $inner= $dbh->prepare("SELECT COUNT(*) FROM $table WHERE id >= ?");
+my @counts;
+while (my ($id)= $outer->fetchrow_array) {
+  ok $inner->execute($id), "nested execute for $id";
+  push @counts, $inner->fetchrow_array;
+}
+is_deeply \@counts, [3, 2, 1], "nested results";
+is $dbh->{drizzle_dbd_stats}->{aux_connects}, 1, "one auxiliary connection";
+
+# Session variables are carried over, both ways
+ok $dbh->do('SET @dbd_aux = 42'), "set a session variable";
+ok $outer->execute, "execute unbuffered again";
+$outer->fetchrow_array;
+is $dbh->selectrow_array('SELECT @dbd_aux'), 42,
+  "auxiliary connection has the variable";
+$dbh->do('SET @dbd_aux = 43');
+$outer->finish;
+is $dbh->selectrow_array('SELECT @dbd_aux'), 43,
+  "main connection has what was set on the auxiliary one";
+is $dbh->{drizzle_dbd_stats}->{aux_connects}, 1, "still one connection";
+
+ok $dbh->do("DROP TABLE $table"), "drop table $table";
+
+$dbh->disconnect;
@@ -0,0 +1,78 @@
+#!perl -w
+# vim: ft=perl
+#
+#   This is testing drizzle_bind_by_ref
+#
+
+use strict;
+use DBI;
+use Test::More;
+use lib 't', '.';
+require 'lib.pl';
+
+use vars qw($test_dsn $test_user $test_password $table);
+
+my $dbh;
+eval {$dbh= DBI->connect($test_dsn, $test_user, $test_password,
+                      { RaiseError => 1, PrintError => 0, AutoCommit => 1 });};
+if ($@) {
+    plan skip_all =>
+        "ERROR: $DBI::errstr. Can't continue test";
+}
+plan tests => 12;
+
+ok $dbh->do("DROP TABLE IF EXISTS $table"), "drop table if exists $table";
+
+ok $dbh->do("CREATE TABLE $table (id INT PRIMARY KEY, name VARCHAR(64))"),
+  "create table $table";
+
+my ($id, $name);
+my $sth= $dbh->prepare("INSERT INTO $table (id, name) VALUES (?, ?)",
+                       { drizzle_bind_by_ref => 1 });
+ok $sth->{drizzle_bind_by_ref}, "attribute is set";
+$sth->bind_param(1, $id);
+$sth->bind_param(2, $name);
+for (1 .. 3) {
+    ($id, $name)= ($_, "name $_");
+    $sth->execute;
+}
+
+# Copies by default, reusing the copy between executes
+$sth= $dbh->prepare("INSERT INTO $table (id, name) VALUES (?, ?)");
+ok !$sth->{drizzle_bind_by_ref}, "attribute is off by default";
+($id, $name)= (4, "name 4");
+$sth->bind_param(1, $id);
+$sth->bind_param(2, $name);
+($id, $name)= (5, "name 5");
+ok $sth->execute, "execute with copied values";
+ok $sth->execute(6, "name 6"), "execute with arguments";
+ok $sth->execute(7, "name 7"), "execute with arguments again";
+
+# Per bind_param
+$sth->bind_param(1, $id, { drizzle_bind_by_ref => 1 });
+$sth->bind_param(2, $name);
+$id= 8;
+ok $sth->execute, "execute with one value by reference";
+
+is_deeply $dbh->selectall_arrayref("SELECT id, name FROM $table ORDER BY id"),
+  [ [1, 'name 1'], [2, 'name 2'], [3, 'name 3'], [4, 'name 4'],
+    [6, 'name 6'], [7, 'name 7'], [8, 'name 5'] ], "rows";
+
+# A tied value that grows each time it is read is read once per execute,
+# so the statement holds it as it was measured
+{
+    package GrowingScalar;
+    sub TIESCALAR { my $n= 0; return bless \$n, shift }
+    sub FETCH { my $self= shift; return 'x' x (10 ** ++$$self) }
+    sub STORE {}
+}
+tie my $growing, 'GrowingScalar';
+$sth= $dbh->prepare("SELECT LENGTH(?)", { drizzle_bind_by_ref => 1 });
+$sth->bind_param(1, $growing);
+ok $sth->execute, "execute with a tied value";
+like scalar($sth->fetchrow_array), qr/^10+$/, "one value of the tied scalar";
+$sth->finish;
+
+ok $dbh->do("DROP TABLE $table"), "drop table $table";
+
+$dbh->disconnect;
@@ -0,0 +1,57 @@
+#!perl -w
+# vim: ft=perl
+#
+#   This is testing drizzle_bulk_update and drizzle_bulk_delete
+#
+
+use strict;
+use DBI;
+use Test::More;
+use lib 't', '.';
+require 'lib.pl';
+
+use vars qw($test_dsn $test_user $test_password $table);
+
+my $dbh;
+eval {$dbh= DBI->connect($test_dsn, $test_user, $test_password,
+                      { RaiseError => 1, PrintError => 0, AutoCommit => 1 });};
+if ($@) {
+    plan skip_all =>
+        "ERROR: $DBI::errstr. Can't continue test";
+}
+plan tests => 12;
+
+ok $dbh->do("DROP TABLE IF EXISTS $table"), "drop table if exists $table";
+
+ok $dbh->do("CREATE TABLE $table (id INT PRIMARY KEY, name VARCHAR(64), n INT)"),
+  "create table $table";
+
+my $sth= $dbh->prepare("INSERT INTO $table (id, name, n) VALUES (?, ?, 0)");
+$sth->execute($_, "row $_") for 1 .. 100;
+
+# Small packets force several statements
+$dbh->{drizzle_max_packet_size}= 512;
+is $dbh->{drizzle_max_packet_size}, 512, "packet size set";
+
+my %rows= map { $_ => { n => $_ * 2 } } 1 .. 50;
+$rows{3}= { name => "it's three" };
+is $dbh->drizzle_bulk_update($table, 'id', \%rows), 50, "updated 50 rows";
+
+my ($sum)= $dbh->selectrow_array("SELECT SUM(n) FROM $table");
+is $sum, (50 * 51) - 6, "values set by key";
+my ($name, $n)= $dbh->selectrow_array("SELECT name, n FROM $table WHERE id = 3");
+is $name, "it's three", "quoted value stored";
+is $n, 0, "columns not given are left alone";
+
+is $dbh->drizzle_bulk_update($table, 'id', {}), '0E0', "nothing to update";
+ok !eval { $dbh->drizzle_bulk_update($table, 'id', { 1 => 2 }); 1 },
+  "rows must be hash references";
+
+is $dbh->drizzle_bulk_delete($table, 'id', [ 1 .. 60, 1000 ]), 60,
+  "deleted 60 rows";
+my ($count)= $dbh->selectrow_array("SELECT COUNT(*) FROM $table");
+is $count, 40, "the rest remains";
+
+ok $dbh->do("DROP TABLE $table"), "drop table $table";
+
+$dbh->disconnect;
@@ -0,0 +1,61 @@
+#!perl -w
+# vim: ft=perl
+#
+#   This is testing drizzle_cancel_threshold
+#
+
+use strict;
+use DBI;
+use Test::More;
+use Time::HiRes qw(time);
+use lib 't', '.';
+require 'lib.pl';
+
+use vars qw($test_dsn $test_user $test_password $table);
+
+my $dbh;
+eval {$dbh= DBI->connect($test_dsn, $test_user, $test_password,
+                      { RaiseError => 1, PrintError => 0, AutoCommit => 1 });};
+if ($@) {
+    plan skip_all =>
+        "ERROR: $DBI::errstr. Can't continue test";
+}
+plan tests => 10;
+
+ok $dbh->do("DROP TABLE IF EXISTS $table"), "drop table if exists $table";
+
+ok $dbh->do("CREATE TABLE $table (id INT)"), "create table $table";
+
+ok $dbh->do("INSERT INTO $table (id) VALUES " .
+            join(', ', map { "($_)" } 1 .. 1000)),
+  "insert rows";
+
+# a million rows, far more than are read
+my $query= "SELECT a.id, b.id FROM $table a, $table b";
+
+my $sth= $dbh->prepare($query, { drizzle_unbuffered_result => 1,
+                                 drizzle_cancel_threshold  => 1000 });
+is $sth->{drizzle_cancel_threshold}, 1000, "attribute set through prepare";
+ok $sth->execute, "execute unbuffered";
+$sth->fetchrow_arrayref for 1 .. 3;
+
+my $killed= $dbh->{drizzle_dbd_stats}->{queries_killed};
+my $start= time;
+ok $sth->finish, "finish after a few rows";
+my $took= time - $start;
+ok $dbh->{drizzle_dbd_stats}->{queries_killed} > $killed || $took < 1,
+  "query killed or finished quickly";
+is $dbh->selectrow_array("SELECT COUNT(*) FROM $table"), 1000,
+  "connection usable after finish";
+
+# without a threshold the rest is read off the connection
+$sth= $dbh->prepare($query, { drizzle_unbuffered_result => 1 });
+$sth->execute;
+$sth->fetchrow_arrayref;
+$killed= $dbh->{drizzle_dbd_stats}->{queries_killed};
+$sth->finish;
+is $dbh->{drizzle_dbd_stats}->{queries_killed}, $killed, "nothing killed";
+
+ok $dbh->do("DROP TABLE $table"), "drop table $table";
+
+$dbh->disconnect;
@@ -0,0 +1,79 @@
+#!perl -w
+# vim: ft=perl
+#
+#   This is testing drizzle_compact_rows and drizzle_release_fetched
+#
+
+use strict;
+use DBI;
+use Test::More;
+use lib 't', '.';
+require 'lib.pl';
+
+use vars qw($test_dsn $test_user $test_password $table);
+
+my $dbh;
+eval {$dbh= DBI->connect($test_dsn, $test_user, $test_password,
+                      { RaiseError => 1, PrintError => 0, AutoCommit => 1 });};
+if ($@) {
+    plan skip_all =>
+        "ERROR: $DBI::errstr. Can't continue test";
+}
+plan tests => 25;
+
+ok $dbh->do("DROP TABLE IF EXISTS $table"), "drop table if exists $table";
+
+ok $dbh->do("CREATE TABLE $table (id INT, name VARCHAR(64), note VARCHAR(64))"),
+  "create table $table";
+
+my $sth= $dbh->prepare("INSERT INTO $table (id, name, note) VALUES (?, ?, ?)");
+for my $id (1 .. 100) {
+  $sth->execute($id, $id % 3 ? "name $id" : '', $id % 2 ? undef : "note $id");
+}
+ok $sth->finish;
+
+$sth= $dbh->prepare("SELECT id, name, note FROM $table ORDER BY id",
+                    { drizzle_compact_rows => 1 });
+ok $sth->{drizzle_compact_rows}, "attribute set through prepare";
+ok $sth->execute, "execute";
+is $sth->rows, 100, "rows";
+
+my $rows= $sth->fetchall_arrayref;
+is scalar(@$rows), 100, "fetched all rows";
+is_deeply $rows->[0], [1, 'name 1', undef], "NULL column";
+is_deeply $rows->[1], [2, 'name 2', 'note 2'], "all columns set";
+is_deeply $rows->[2], [3, '', undef], "empty string is not NULL";
+
+ok $sth->execute, "execute again";
+ok $sth->func(49, 'dataseek'), "dataseek";
+is_deeply $sth->fetchrow_arrayref, [50, 'name 50', 'note 50'], "row after dataseek";
+ok $sth->finish;
+
+$sth->{drizzle_release_fetched}= 1;
+ok $sth->execute, "execute with drizzle_release_fetched";
+my $count= 0;
+$count++ while $sth->fetchrow_arrayref;
+is $count, 100, "fetched all rows while releasing them";
+is $dbh->{drizzle_dbd_stats}->{result_bytes}, 0, "buffer released";
+ok $sth->execute, "execute again";
+$sth->fetchrow_arrayref for 1 .. 10;
+ok !eval { $sth->func(0, 'dataseek') }, "cannot seek back to released rows";
+$sth->finish;
+
+# 500 rows of 1k span several buffer chunks, released while reading
+$sth= $dbh->prepare("SELECT a.id, REPEAT('x', 1000) FROM $table a, $table b " .
+                    "WHERE b.id <= 5", { drizzle_release_fetched => 1 });
+ok $sth->execute, "execute a result of several chunks";
+my $full= $dbh->{drizzle_dbd_stats}->{result_bytes};
+ok $full > 4 * 65536, "result spans several chunks";
+$sth->fetchrow_arrayref for 1 .. 300;
+ok $dbh->{drizzle_dbd_stats}->{result_bytes} < $full,
+  "fetched chunks released before the end of the result";
+$count= 300;
+$count++ while $sth->fetchrow_arrayref;
+is $count, 500, "fetched the rest";
+is $dbh->{drizzle_dbd_stats}->{result_bytes}, 0, "buffer released at the end";
+
+ok $dbh->do("DROP TABLE $table"), "drop table $table";
+
+$dbh->disconnect;
@@ -0,0 +1,68 @@
+#!perl -w
+# vim: ft=perl
+#
+#   This is testing drizzle_copy_in
+#
+
+use strict;
+use DBI;
+use Test::More;
+use lib 't', '.';
+require 'lib.pl';
+
+use vars qw($test_dsn $test_user $test_password $table);
+
+my $dbh;
+eval {$dbh= DBI->connect($test_dsn, $test_user, $test_password,
+                      { RaiseError => 1, PrintError => 0, AutoCommit => 1 });};
+if ($@) {
+    plan skip_all =>
+        "ERROR: $DBI::errstr. Can't continue test";
+}
+plan tests => 14;
+
+ok $dbh->do("DROP TABLE IF EXISTS $table"), "drop table if exists $table";
+
+ok $dbh->do("CREATE TABLE $table (id INT PRIMARY KEY, name VARCHAR(64))"),
+  "create table $table";
+
+my $tsv= join '', map { "$_\trow $_\n" } 1 .. 200;
+$tsv.= "201\ttab\\there\r\n\n202\t\\N\n203\tit's";
+open my $fh, '<', \$tsv or die $!;
+is $dbh->drizzle_copy_in($table, [qw(id name)], $fh, { batch_bytes => 512 }),
+  203, "tsv rows inserted";
+
+my ($count)= $dbh->selectrow_array("SELECT COUNT(*) FROM $table");
+is $count, 203, "all rows there";
+my $names= $dbh->selectall_hashref(
+  "SELECT id, name FROM $table WHERE id > 200", 'id');
+is $names->{201}{name}, "tab\there", "escapes and CRLF";
+ok !defined $names->{202}{name}, "\\N is NULL";
+is $names->{203}{name}, "it's", "last line without newline";
+
+ok $dbh->do("DELETE FROM $table"), "emptied $table";
+
+my $csv= qq{id,name\n1,"a, b"\n2,"say ""hi"""\n3,"two\nlines"\n4,\n5,""\n};
+open $fh, '<', \$csv or die $!;
+is $dbh->drizzle_copy_in($table, [qw(id name)], $fh,
+                         { format => 'csv', header => 1 }),
+  5, "csv rows inserted";
+$names= $dbh->selectall_hashref("SELECT id, name FROM $table", 'id');
+is_deeply [ map { $names->{$_}{name} } 1 .. 5 ],
+  [ 'a, b', 'say "hi"', "two\nlines", undef, '' ], "csv quoting";
+
+my $bad= "10,x\n11,y,z\n";
+open $fh, '<', \$bad or die $!;
+ok !eval { $dbh->drizzle_copy_in($table, [qw(id name)], $fh,
+                                 { format => 'csv' }); 1 },
+  "extra field fails";
+like $dbh->errstr, qr/line 2/, "error names the line";
+
+$bad= "20\ta\n1\tduplicate\n";
+open $fh, '<', \$bad or die $!;
+ok !eval { $dbh->drizzle_copy_in($table, [qw(id name)], $fh); 1 },
+  "server error fails";
+
+ok $dbh->do("DROP TABLE $table"), "drop table $table";
+
+$dbh->disconnect;
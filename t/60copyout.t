@@ -0,0 +1,63 @@
+#!perl -w
+# vim: ft=perl
+#
+#   This is testing drizzle_copy_out
+#
+
+use strict;
+use DBI;
+use Test::More;
+use lib 't', '.';
+require 'lib.pl';
+
+use vars qw($test_dsn $test_user $test_password $table);
+
+my $dbh;
+eval {$dbh= DBI->connect($test_dsn, $test_user, $test_password,
+                      { RaiseError => 1, PrintError => 0, AutoCommit => 1 });};
+if ($@) {
+    plan skip_all =>
+        "ERROR: $DBI::errstr. Can't continue test";
+}
+plan tests => 12;
+
+ok $dbh->do("DROP TABLE IF EXISTS $table"), "drop table if exists $table";
+
+ok $dbh->do("CREATE TABLE $table (id INT PRIMARY KEY, name VARCHAR(64))"),
+  "create table $table";
+
+my $sth= $dbh->prepare("INSERT INTO $table (id, name) VALUES (?, ?)");
+$sth->execute(1, "plain");
+$sth->execute(2, "tab\there");
+$sth->execute(3, undef);
+$sth->execute(4, 'say "hi", ok');
+$sth->execute(5, "");
+
+$sth= $dbh->prepare("SELECT id, name FROM $table ORDER BY id");
+ok $sth->execute, "execute select";
+my $out= '';
+open my $fh, '>', \$out or die $!;
+is $sth->drizzle_copy_out($fh, { header => 1 }), 5, "tsv rows written";
+close $fh;
+is $out, qq{id\tname\n1\tplain\n2\ttab\\there\n3\t\\N\n4\tsay "hi", ok\n5\t\n},
+  "tsv output";
+ok !$sth->{Active}, "statement finished";
+
+ok $sth->execute, "execute again";
+$out= '';
+open $fh, '>', \$out or die $!;
+is $sth->drizzle_copy_out($fh, { format => 'csv', chunk_bytes => 8 }), 5,
+  "csv rows written in small chunks";
+close $fh;
+is $out, qq{1,plain\n2,tab\there\n3,\n4,"say ""hi"", ok"\n5,""\n},
+  "csv output";
+
+# What is written reads back in
+ok $dbh->do("DELETE FROM $table"), "emptied $table";
+open $fh, '<', \$out or die $!;
+is $dbh->drizzle_copy_in($table, [qw(id name)], $fh, { format => 'csv' }), 5,
+  "copied back in";
+
+ok $dbh->do("DROP TABLE $table"), "drop table $table";
+
+$dbh->disconnect;
@@ -0,0 +1,76 @@
+#!perl -w
+# vim: ft=perl
+#
+#   This is testing drizzle_datetime_as
+#
+
+use strict;
+use DBI;
+use Test::More;
+use lib 't', '.';
+require 'lib.pl';
+
+use vars qw($test_dsn $test_user $test_password $table);
+
+my $dbh;
+eval {$dbh= DBI->connect($test_dsn, $test_user, $test_password,
+                      { RaiseError => 1, PrintError => 0, AutoCommit => 1 });};
+if ($@) {
+    plan skip_all =>
+        "ERROR: $DBI::errstr. Can't continue test";
+}
+plan tests => 17;
+
+ok $dbh->do("DROP TABLE IF EXISTS $table"), "drop table if exists $table";
+
+ok $dbh->do("CREATE TABLE $table (id INT PRIMARY KEY, d DATE, " .
+            "dt DATETIME, name VARCHAR(64))"),
+  "create table $table";
+
+my $sth= $dbh->prepare("INSERT INTO $table (id, d, dt, name) VALUES (?, ?, ?, ?)");
+$sth->execute(1, '1970-01-02', '2001-09-09 01:46:40', '2001-09-09');
+$sth->execute(2, '1969-12-31', '2000-02-29 12:00:00', undef);
+$sth->execute(3, undef, undef, 'x');
+
+my $query= "SELECT d, dt, name FROM $table ORDER BY id";
+
+is_deeply $dbh->selectall_arrayref($query),
+  [ [ '1970-01-02', '2001-09-09 01:46:40', '2001-09-09' ],
+    [ '1969-12-31', '2000-02-29 12:00:00', undef ],
+    [ undef, undef, 'x' ] ], "strings by default";
+
+$sth= $dbh->prepare($query, { drizzle_datetime_as => 'epoch' });
+is $sth->{drizzle_datetime_as}, 'epoch', "attribute set";
+ok $sth->execute, "execute select";
+is_deeply $sth->fetchall_arrayref,
+  [ [ 86400, 1000000000, '2001-09-09' ],
+    [ -86400, 951825600, undef ],
+    [ undef, undef, 'x' ] ], "epoch, other columns unchanged";
+
+$sth->{drizzle_datetime_as}= 'epoch_ms';
+ok $sth->execute, "execute again";
+is_deeply $sth->fetchrow_arrayref, [ 86400000, 1000000000000, '2001-09-09' ],
+  "epoch_ms";
+$sth->finish;
+
+$sth= $dbh->prepare($query, { drizzle_datetime_as => 'epoch',
+                              drizzle_datetime_offset => '+01:00' });
+is $sth->{drizzle_datetime_offset}, 3600, "offset parsed";
+ok $sth->execute, "execute with offset";
+is_deeply $sth->fetchrow_arrayref, [ 82800, 999996400, '2001-09-09' ],
+  "offset applied";
+$sth->finish;
+
+ok !eval { $dbh->prepare($query, { drizzle_datetime_as => 'epoc' }) },
+  "unknown mode rejected";
+like $@, qr/drizzle_datetime_as must be/, "error names the attribute";
+ok !eval { $dbh->prepare($query, { drizzle_datetime_offset => 'CET' }) },
+  "malformed offset rejected";
+$sth= $dbh->prepare($query, { drizzle_datetime_as => 'epoch' });
+ok !eval { $sth->{drizzle_datetime_offset}= '+1:0'; 1 },
+  "malformed offset not stored";
+is $sth->{drizzle_datetime_offset}, 0, "offset unchanged";
+
+ok $dbh->do("DROP TABLE $table"), "drop table $table";
+
+$dbh->disconnect;
@@ -0,0 +1,54 @@
+#!perl -w
+# vim: ft=perl
+#
+#   This is testing drizzle_each_row
+#
+
+use strict;
+use DBI;
+use Test::More;
+use lib 't', '.';
+require 'lib.pl';
+
+use vars qw($test_dsn $test_user $test_password $table);
+
+my $dbh;
+eval {$dbh= DBI->connect($test_dsn, $test_user, $test_password,
+                      { RaiseError => 1, PrintError => 0, AutoCommit => 1 });};
+if ($@) {
+    plan skip_all =>
+        "ERROR: $DBI::errstr. Can't continue test";
+}
+plan tests => 11;
+
+ok $dbh->do("DROP TABLE IF EXISTS $table"), "drop table if exists $table";
+
+ok $dbh->do("CREATE TABLE $table (id INT PRIMARY KEY, name VARCHAR(64))"),
+  "create table $table";
+
+my $sth= $dbh->prepare("INSERT INTO $table (id, name) VALUES (?, ?)");
+$sth->execute($_, "row $_") for 1 .. 10;
+
+$sth= $dbh->prepare("SELECT id, name FROM $table ORDER BY id");
+ok $sth->execute, "execute select";
+my @seen;
+is $sth->drizzle_each_row(sub { push @seen, "$_[0]:$_[1]"; 1 }), 10,
+  "called for every row";
+is_deeply \@seen, [ map { "$_:row $_" } 1 .. 10 ], "columns in \@_";
+ok !$sth->{Active}, "statement finished";
+
+ok $sth->execute, "execute again";
+my $calls= 0;
+is $sth->drizzle_each_row(sub { ++$calls < 3 }), 3, "stops on false";
+is_deeply $sth->fetchrow_arrayref, [ 4, 'row 4' ], "rest can be fetched";
+$sth->finish;
+
+$sth->execute;
+my $last;
+$sth->bind_col(1, \$last);
+$sth->drizzle_each_row(sub { 1 });
+is $last, 10, "bound columns are set";
+
+ok $dbh->do("DROP TABLE $table"), "drop table $table";
+
+$dbh->disconnect;
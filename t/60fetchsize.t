@@ -0,0 +1,62 @@
+#!perl -w
+# vim: ft=perl
+#
+#   This is testing drizzle_fetch_size
+#
+
+use strict;
+use DBI;
+use Test::More;
+use lib 't', '.';
+require 'lib.pl';
+
+use vars qw($test_dsn $test_user $test_password $table);
+
+my $dbh;
+eval {$dbh= DBI->connect($test_dsn, $test_user, $test_password,
+                      { RaiseError => 1, PrintError => 0, AutoCommit => 1 });};
+if ($@) {
+    plan skip_all =>
+        "ERROR: $DBI::errstr. Can't continue test";
+}
+plan tests => 14;
+
+ok $dbh->do("DROP TABLE IF EXISTS $table"), "drop table if exists $table";
+
+ok $dbh->do("CREATE TABLE $table (id INT)"), "create table $table";
+
+ok $dbh->do("INSERT INTO $table (id) VALUES (1), (2), (3), (4), (5)"),
+  "insert rows";
+
+my $sth= $dbh->prepare("SELECT id FROM $table ORDER BY id",
+                       { drizzle_fetch_size => 2 });
+is $sth->{drizzle_fetch_size}, 2, "attribute set through prepare";
+ok $sth->execute, "execute";
+is $sth->rows, 2, "first page read";
+
+my @ids;
+while (my ($id)= $sth->fetchrow_array) {
+  push @ids, $id;
+  # the connection is free between pages
+  $dbh->do("SELECT 1") if $id == 2;
+}
+is_deeply \@ids, [1 .. 5], "all pages fetched";
+
+# an exact multiple of the page size ends with an empty page
+$sth->{drizzle_fetch_size}= 5;
+ok $sth->execute, "execute with a single full page";
+is scalar(@{$sth->fetchall_arrayref}), 5, "fetched one page";
+
+$sth= $dbh->prepare("SELECT id FROM $table ORDER BY id LIMIT 3",
+                    { drizzle_fetch_size => 2 });
+ok $sth->execute, "execute with a LIMIT of its own";
+is scalar(@{$sth->fetchall_arrayref}), 3, "LIMIT is left alone";
+
+$sth= $dbh->prepare("SELECT id FROM $table", { drizzle_fetch_size => 2 });
+ok $sth->execute, "execute without ORDER BY";
+is $sth->rows, 5, "not paged without ORDER BY";
+$sth->finish;
+
+ok $dbh->do("DROP TABLE $table"), "drop table $table";
+
+$dbh->disconnect;
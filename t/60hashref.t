@@ -0,0 +1,61 @@
+#!perl -w
+# vim: ft=perl
+#
+#   This is testing fetchrow_hashref and drizzle_reuse_hashref
+#
+
+use strict;
+use DBI;
+use Test::More;
+use lib 't', '.';
+require 'lib.pl';
+
+use vars qw($test_dsn $test_user $test_password $table);
+
+my $dbh;
+eval {$dbh= DBI->connect($test_dsn, $test_user, $test_password,
+                      { RaiseError => 1, PrintError => 0, AutoCommit => 1 });};
+if ($@) {
+    plan skip_all =>
+        "ERROR: $DBI::errstr. Can't continue test";
+}
+plan tests => 12;
+
+ok $dbh->do("DROP TABLE IF EXISTS $table"), "drop table if exists $table";
+
+ok $dbh->do("CREATE TABLE $table (id INT PRIMARY KEY, Name VARCHAR(64))"),
+  "create table $table";
+
+my $sth= $dbh->prepare("INSERT INTO $table (id, Name) VALUES (?, ?)");
+$sth->execute($_, $_ == 2 ? undef : "name $_") for 1 .. 3;
+
+$sth= $dbh->prepare("SELECT id, Name FROM $table ORDER BY id");
+ok $sth->execute, "execute select";
+is_deeply $sth->fetchrow_hashref, { id => 1, Name => 'name 1' }, "NAME";
+is_deeply $sth->fetchrow_hashref('NAME_lc'), { id => 2, name => undef },
+  "NAME_lc";
+is_deeply $sth->fetchrow_hashref('NAME_uc'), { ID => 3, NAME => 'name 3' },
+  "NAME_uc";
+ok !defined $sth->fetchrow_hashref, "end of result";
+
+ok $sth->execute, "execute again";
+my $first= $sth->fetchrow_hashref;
+my $second= $sth->fetchrow_hashref;
+isnt $first, $second, "a new hash for each row";
+$sth->finish;
+
+$sth= $dbh->prepare("SELECT id, Name FROM $table ORDER BY id",
+                    { drizzle_reuse_hashref => 1 });
+$sth->execute;
+my @ids;
+my %seen;
+while (my $row= $sth->fetchrow_hashref) {
+    push @ids, $row->{id};
+    $seen{$row}++;
+}
+is_deeply \@ids, [ 1, 2, 3 ], "drizzle_reuse_hashref";
+is scalar(keys %seen), 1, "one hash for all rows";
+
+ok $dbh->do("DROP TABLE $table"), "drop table $table";
+
+$dbh->disconnect;
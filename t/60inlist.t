@@ -0,0 +1,60 @@
+#!perl -w
+# vim: ft=perl
+#
+#   This is testing array references bound to IN (?) and drizzle_in_chunk
+#
+
+use strict;
+use DBI qw(:sql_types);
+use Test::More;
+use lib 't', '.';
+require 'lib.pl';
+
+use vars qw($test_dsn $test_user $test_password $table);
+
+my $dbh;
+eval {$dbh= DBI->connect($test_dsn, $test_user, $test_password,
+                      { RaiseError => 1, PrintError => 0, AutoCommit => 1 });};
+if ($@) {
+    plan skip_all =>
+        "ERROR: $DBI::errstr. Can't continue test";
+}
+plan tests => 13;
+
+ok $dbh->do("DROP TABLE IF EXISTS $table"), "drop table if exists $table";
+
+ok $dbh->do("CREATE TABLE $table (id INT, name VARCHAR(64))"),
+  "create table $table";
+
+my $sth= $dbh->prepare("INSERT INTO $table (id, name) VALUES (?, ?)");
+$sth->execute($_, "n'$_") for 1 .. 20;
+
+$sth= $dbh->prepare("SELECT id FROM $table WHERE id IN (?) ORDER BY id");
+ok $sth->execute([3, 1, 2]), "execute with a list";
+is_deeply $sth->fetchall_arrayref, [[1], [2], [3]], "list expanded";
+
+ok $sth->execute([]), "execute with an empty list";
+is_deeply $sth->fetchall_arrayref, [], "empty list matches nothing";
+
+$sth->bind_param(1, [5, 6, undef], SQL_INTEGER);
+ok $sth->execute, "numeric list";
+is_deeply $sth->fetchall_arrayref, [[5], [6]], "numeric list expanded";
+
+my $names= $dbh->selectcol_arrayref(
+  "SELECT id FROM $table WHERE name IN (?) ORDER BY id", undef,
+  ["n'4", "n'7"]);
+is_deeply $names, [4, 7], "strings are escaped";
+
+# Chunked SELECT and DELETE
+$sth= $dbh->prepare("SELECT id FROM $table WHERE id IN (?)",
+                    { drizzle_in_chunk => 3 });
+is $sth->{drizzle_in_chunk}, 3, "chunk size set";
+ok $sth->execute([1 .. 10]), "chunked select";
+is scalar(@{$sth->fetchall_arrayref}), 10, "rows of all chunks fetched";
+
+$sth= $dbh->prepare("DELETE FROM $table WHERE id IN (?)",
+                    { drizzle_in_chunk => 4 });
+is $sth->execute([11 .. 20]), 10, "chunked delete counts the rows of all chunks";
+
+$dbh->do("DROP TABLE $table");
+$dbh->disconnect;
@@ -0,0 +1,70 @@
+#!perl -w
+# vim: ft=perl
+#
+#   This is testing drizzle_intern_columns
+#
+
+use strict;
+use DBI;
+use Test::More;
+use B;
+use lib 't', '.';
+require 'lib.pl';
+
+use vars qw($test_dsn $test_user $test_password $table);
+
+my $dbh;
+eval {$dbh= DBI->connect($test_dsn, $test_user, $test_password,
+                      { RaiseError => 1, PrintError => 0, AutoCommit => 1 });};
+if ($@) {
+    plan skip_all =>
+        "ERROR: $DBI::errstr. Can't continue test";
+}
+plan tests => 16;
+
+ok $dbh->do("DROP TABLE IF EXISTS $table"), "drop table if exists $table";
+
+ok $dbh->do("CREATE TABLE $table (id INT PRIMARY KEY, status VARCHAR(16), " .
+            "name VARCHAR(64))"),
+  "create table $table";
+
+my $sth= $dbh->prepare("INSERT INTO $table (id, status, name) VALUES (?, ?, ?)");
+$sth->execute($_, $_ % 3 ? 'open' : 'closed', $_ % 5 ? "name $_" : undef)
+  for 1 .. 1200;
+
+# A fetched value is interned when it uses a shared string buffer
+sub is_shared {
+    my $sv= B::svref_2object(\$_[0]);
+    return $sv->LEN == 0 && ($sv->FLAGS & B::SVf_IsCOW()) ? 1 : 0;
+}
+
+my @expected= map { [ $_, $_ % 3 ? 'open' : 'closed',
+                      $_ % 5 ? "name $_" : undef ] } 1 .. 1200;
+
+$sth= $dbh->prepare("SELECT id, status, name FROM $table ORDER BY id",
+                    { drizzle_intern_columns => [ 'status', 2 ] });
+is_deeply $sth->{drizzle_intern_columns}, [ 'status', 2 ], "attribute set";
+ok $sth->execute, "execute select";
+my $rows= $sth->fetchall_arrayref;
+is_deeply $rows, \@expected, "named and numbered columns";
+ok is_shared($rows->[0][1]), "named column is interned";
+ok is_shared($rows->[0][2]), "numbered column is interned";
+ok !is_shared($rows->[0][0]), "other columns are not";
+
+$sth->{drizzle_intern_columns}= 'auto';
+is $sth->{drizzle_intern_columns}, 'auto', "attribute changed";
+ok $sth->execute, "execute again";
+$rows= $sth->fetchall_arrayref;
+is_deeply $rows, \@expected, "auto";
+ok is_shared($rows->[1100][1]), "few distinct values are interned";
+ok !is_shared($rows->[1100][2]), "many distinct values are not";
+ok !is_shared($rows->[1100][0]), "numbers are not";
+
+is_deeply $dbh->selectall_arrayref(
+            "SELECT status FROM $table WHERE id <= 3 ORDER BY id",
+            { drizzle_intern_columns => 'auto' }),
+  [ ['open'], ['open'], ['closed'] ], "fewer rows than the sample";
+
+ok $dbh->do("DROP TABLE $table"), "drop table $table";
+
+$dbh->disconnect;
@@ -0,0 +1,63 @@
+#!perl -w
+# vim: ft=perl
+#
+#   This is testing drizzle_fetchall_json
+#
+
+use strict;
+use DBI;
+use Test::More;
+use lib 't', '.';
+require 'lib.pl';
+
+use vars qw($test_dsn $test_user $test_password $table);
+
+my $dbh;
+eval {$dbh= DBI->connect($test_dsn, $test_user, $test_password,
+                      { RaiseError => 1, PrintError => 0, AutoCommit => 1 });};
+if ($@) {
+    plan skip_all =>
+        "ERROR: $DBI::errstr. Can't continue test";
+}
+plan tests => 12;
+
+ok $dbh->do("DROP TABLE IF EXISTS $table"), "drop table if exists $table";
+
+ok $dbh->do("CREATE TABLE $table (id INT PRIMARY KEY, name VARCHAR(64), " .
+            "price DECIMAL(6,2))"),
+  "create table $table";
+
+my $sth= $dbh->prepare("INSERT INTO $table (id, name, price) VALUES (?, ?, ?)");
+$sth->execute(1, qq{say "hi"\n}, '1.50');
+$sth->execute(2, undef, undef);
+
+$sth= $dbh->prepare("SELECT id, name, price FROM $table ORDER BY id");
+ok $sth->execute, "execute select";
+is $sth->drizzle_fetchall_json,
+  '[{"id":1,"name":"say \"hi\"\n","price":1.50},' .
+  '{"id":2,"name":null,"price":null}]',
+  "objects";
+ok !$sth->{Active}, "statement finished";
+
+ok $sth->execute, "execute again";
+is $sth->drizzle_fetchall_json({ shape => 'arrays' }),
+  '[[1,"say \"hi\"\n",1.50],[2,null,null]]', "arrays";
+
+$sth= $dbh->prepare("SELECT id FROM $table WHERE id > 10");
+$sth->execute;
+is $sth->drizzle_fetchall_json, '[]', "no rows";
+
+# A wide row of NULLs writes more than the values are long
+my $cols= join ', ', map { "c$_ INT" } 1 .. 200;
+ok $dbh->do("DROP TABLE $table"), "drop table $table";
+ok $dbh->do("CREATE TABLE $table ($cols)"), "create wide table $table";
+$dbh->do("INSERT INTO $table (c1) VALUES (NULL)") for 1 .. 50;
+$sth= $dbh->prepare("SELECT * FROM $table");
+$sth->execute;
+my $nulls= '[' . join(',', ('null') x 200) . ']';
+is $sth->drizzle_fetchall_json({ shape => 'arrays' }),
+  '[' . join(',', ($nulls) x 50) . ']', "rows of NULLs";
+
+ok $dbh->do("DROP TABLE $table"), "drop table $table";
+
+$dbh->disconnect;
@@ -0,0 +1,58 @@
+#!perl -w
+# vim: ft=perl
+#
+#   This is testing drizzle_lazy_columns
+#
+
+use strict;
+use DBI;
+use Test::More;
+use lib 't', '.';
+require 'lib.pl';
+
+use vars qw($test_dsn $test_user $test_password $table);
+
+my $dbh;
+eval {$dbh= DBI->connect($test_dsn, $test_user, $test_password,
+                      { RaiseError => 1, PrintError => 0, AutoCommit => 1 });};
+if ($@) {
+    plan skip_all =>
+        "ERROR: $DBI::errstr. Can't continue test";
+}
+plan tests => 13;
+
+ok $dbh->do("DROP TABLE IF EXISTS $table"), "drop table if exists $table";
+
+ok $dbh->do("CREATE TABLE $table (id INT PRIMARY KEY, a VARCHAR(64), " .
+            "b VARCHAR(64))"),
+  "create table $table";
+
+my $sth= $dbh->prepare("INSERT INTO $table (id, a, b) VALUES (?, ?, ?)");
+$sth->execute($_, "a $_", $_ % 2 ? undef : "b $_") for 1 .. 4;
+
+$sth= $dbh->prepare("SELECT id, a, b FROM $table ORDER BY id",
+                    { drizzle_lazy_columns => 1 });
+ok $sth->{drizzle_lazy_columns}, "attribute set";
+ok $sth->execute, "execute select";
+
+my $row= $sth->fetchrow_arrayref;
+is $row->[1], 'a 1', "column read on demand";
+ok !defined $row->[2], "NULL column";
+is_deeply $sth->fetchrow_arrayref, [ 2, 'a 2', 'b 2' ], "whole row";
+is_deeply [ $sth->fetchrow_array ], [ 3, 'a 3', undef ], "fetchrow_array";
+is_deeply $sth->fetchrow_hashref, { id => 4, a => 'a 4', b => 'b 4' },
+  "fetchrow_hashref";
+ok !$sth->fetchrow_arrayref, "end of result";
+
+is_deeply $dbh->selectrow_arrayref(
+            "SELECT id, a FROM $table WHERE id = 2",
+            { drizzle_lazy_columns => 1 }),
+  [ 2, 'a 2' ], "columns kept after finish";
+
+is_deeply $dbh->selectall_arrayref("SELECT id FROM $table ORDER BY id",
+                                   { drizzle_lazy_columns => 1 }),
+  [ [1], [2], [3], [4] ], "selectall_arrayref";
+
+ok $dbh->do("DROP TABLE $table"), "drop table $table";
+
+$dbh->disconnect;
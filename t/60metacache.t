@@ -0,0 +1,70 @@
+#!perl -w
+# vim: ft=perl
+#
+#   This is testing that cached column attributes follow the columns
+#
+
+use strict;
+use DBI;
+use Test::More;
+use lib 't', '.';
+require 'lib.pl';
+
+use vars qw($test_dsn $test_user $test_password $table);
+
+my $dbh;
+eval {$dbh= DBI->connect($test_dsn, $test_user, $test_password,
+                      { RaiseError => 1, PrintError => 0, AutoCommit => 1 });};
+if ($@) {
+    plan skip_all =>
+        "ERROR: $DBI::errstr. Can't continue test";
+}
+plan tests => 18;
+
+ok $dbh->do("DROP TABLE IF EXISTS $table"), "drop table if exists $table";
+
+ok $dbh->do("CREATE TABLE $table (id INT, name VARCHAR(64))"),
+  "create table $table";
+
+ok $dbh->do("INSERT INTO $table (id, name) VALUES (1, 'one')"), "insert row";
+
+my $sth= $dbh->prepare("SELECT * FROM $table");
+ok $sth->execute, "execute";
+$sth->fetchall_arrayref;
+my $names= $sth->{NAME};
+my $types= $sth->{TYPE};
+is_deeply $names, [ 'id', 'name' ], "NAME";
+
+ok $sth->execute, "execute again";
+$sth->fetchall_arrayref;
+is 0+$sth->{NAME}, 0+$names, "same NAME array for the same columns";
+is 0+$sth->{TYPE}, 0+$types, "same TYPE array for the same columns";
+
+ok $dbh->do("ALTER TABLE $table ADD COLUMN extra INT"), "add a column";
+ok $sth->execute, "execute after the columns changed";
+$sth->fetchall_arrayref;
+is_deeply $sth->{NAME}, [ 'id', 'name', 'extra' ], "NAME follows";
+is scalar(@{$sth->{TYPE}}), 3, "TYPE follows";
+
+SKIP: {
+  eval {
+    $dbh->do("DROP PROCEDURE IF EXISTS dbd_drizzle_meta");
+    $dbh->do("CREATE PROCEDURE dbd_drizzle_meta() BEGIN " .
+             "SELECT 1 AS a; SELECT 'x' AS b, 2 AS c; END");
+    1;
+  } or skip "no stored procedures", 5;
+
+  $sth= $dbh->prepare("CALL dbd_drizzle_meta()");
+  ok $sth->execute, "execute with two result sets";
+  is_deeply $sth->{NAME}, [ 'a' ], "NAME of the first";
+  $sth->fetchall_arrayref;
+  ok $sth->more_results, "more_results";
+  is_deeply $sth->{NAME}, [ 'b', 'c' ], "NAME of the second";
+  is scalar(@{$sth->{TYPE}}), 2, "TYPE of the second";
+  $sth->finish;
+  $dbh->do("DROP PROCEDURE dbd_drizzle_meta");
+}
+
+ok $dbh->do("DROP TABLE $table"), "drop table $table";
+
+$dbh->disconnect;
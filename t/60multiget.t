@@ -0,0 +1,59 @@
+#!perl -w
+# vim: ft=perl
+#
+#   This is testing drizzle_multi_get
+#
+
+use strict;
+use DBI;
+use Test::More;
+use lib 't', '.';
+require 'lib.pl';
+
+use vars qw($test_dsn $test_user $test_password $table);
+
+my $dbh;
+eval {$dbh= DBI->connect($test_dsn, $test_user, $test_password,
+                      { RaiseError => 1, PrintError => 0, AutoCommit => 1 });};
+if ($@) {
+    plan skip_all =>
+        "ERROR: $DBI::errstr. Can't continue test";
+}
+plan tests => 14;
+
+ok $dbh->do("DROP TABLE IF EXISTS $table"), "drop table if exists $table";
+
+ok $dbh->do("CREATE TABLE $table (id INT, name VARCHAR(64))"),
+  "create table $table";
+
+my $sth= $dbh->prepare("INSERT INTO $table (id, name) VALUES (?, ?)");
+$sth->execute($_, "name $_") for 1 .. 100;
+
+my $sql= "SELECT name, id FROM $table WHERE id IN (?)";
+my $rows= $dbh->drizzle_multi_get($sql, [1 .. 50, 500], { chunk => 7 });
+is ref $rows, 'HASH', "got a hash";
+ok exists $rows->{'name 5'}, "first column is the key";
+
+$rows= $dbh->drizzle_multi_get($sql, [1 .. 50, 500],
+                               { chunk => 7, key_col => 'id' });
+is scalar(keys %$rows), 50, "one row per key found";
+is $rows->{42}{name}, 'name 42', "row hash has the columns";
+ok !exists $rows->{500}, "missing keys are left out";
+
+$dbh->{drizzle_aux_connections}= 2;
+$rows= $dbh->drizzle_multi_get($sql, [1 .. 100],
+                               { chunk => 10, key_col => 'id', parallel => 3 });
+is scalar(keys %$rows), 100, "parallel lookups";
+ok $dbh->{drizzle_dbd_stats}->{aux_connects} >= 1, "used auxiliary connections";
+
+is_deeply $dbh->drizzle_multi_get($sql, []), {}, "no keys";
+
+ok !eval { $dbh->drizzle_multi_get("SELECT 1", [1]); 1 },
+  "statement needs a placeholder";
+ok !eval { $dbh->drizzle_multi_get($sql, [1], { key_col => 'nosuch' }); 1 },
+  "key_col must be a column of the result";
+like $dbh->errstr, qr/key_col 'nosuch' not in result/, "error names key_col";
+
+ok $dbh->do("DROP TABLE $table"), "drop table $table";
+
+$dbh->disconnect;
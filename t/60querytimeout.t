@@ -0,0 +1,56 @@
+#!perl -w
+# vim: ft=perl
+#
+#   This is testing drizzle_query_timeout
+#
+
+use strict;
+use DBI;
+use Test::More;
+use lib 't', '.';
+require 'lib.pl';
+
+use vars qw($test_dsn $test_user $test_password);
+
+my $dbh;
+eval {$dbh= DBI->connect($test_dsn, $test_user, $test_password,
+                      { RaiseError => 1, PrintError => 0, AutoCommit => 1 });};
+if ($@) {
+    plan skip_all =>
+        "ERROR: $DBI::errstr. Can't continue test";
+}
+plan tests => 14;
+
+is $dbh->{drizzle_query_timeout}, 0, "no timeout by default";
+
+my $sth= $dbh->prepare("SELECT SLEEP(3)", { drizzle_query_timeout => 200 });
+is $sth->{drizzle_query_timeout}, 200, "timeout set through prepare";
+
+my $start= time;
+ok !eval { $sth->execute; 1 }, "execute past the timeout fails";
+like $sth->errstr, qr/drizzle_query_timeout/, "error names the timeout";
+is $sth->state, 'HYT00', "sqlstate is HYT00";
+ok time - $start < 3, "did not wait for the query";
+ok $dbh->{drizzle_dbd_stats}->{queries_killed} >= 1, "query was killed";
+
+ok $dbh->do("SELECT 1"), "connection is usable after the timeout";
+
+$dbh->{drizzle_query_timeout}= 5000;
+ok $dbh->do("SELECT SLEEP(0)"), "fast query within the timeout";
+
+# Rows of 20k each arrive 0.3s apart: each one well within the timeout,
+# all six of them not
+$sth= $dbh->prepare("SELECT SLEEP(0.3), REPEAT('x', 20000) FROM " .
+                    "(SELECT 1 UNION ALL SELECT 2 UNION ALL SELECT 3 UNION ALL " .
+                    "SELECT 4 UNION ALL SELECT 5 UNION ALL SELECT 6) AS t",
+                    { drizzle_unbuffered_result => 1,
+                      drizzle_query_timeout     => 1000 });
+ok $sth->execute, "execute a slow streamed result";
+my $fetched= 0;
+ok !eval { $fetched++ while $sth->fetchrow_arrayref; 1 },
+  "fetch past the deadline fails";
+is $sth->state, 'HYT00', "sqlstate is HYT00";
+ok $fetched < 6, "not all rows were fetched";
+ok $dbh->do("SELECT 1"), "connection is usable after the timeout";
+
+$dbh->disconnect;
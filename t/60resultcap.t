@@ -0,0 +1,71 @@
+#!perl -w
+# vim: ft=perl
+#
+#   This is testing drizzle_max_result_bytes and drizzle_max_result_action
+#
+
+use strict;
+use DBI;
+use Test::More;
+use lib 't', '.';
+require 'lib.pl';
+
+use vars qw($test_dsn $test_user $test_password $table);
+
+my $dbh;
+eval {$dbh= DBI->connect($test_dsn, $test_user, $test_password,
+                      { RaiseError => 1, PrintError => 0, AutoCommit => 1 });};
+if ($@) {
+    plan skip_all =>
+        "ERROR: $DBI::errstr. Can't continue test";
+}
+plan tests => 20;
+
+ok $dbh->do("DROP TABLE IF EXISTS $table"), "drop table if exists $table";
+
+ok $dbh->do("CREATE TABLE $table (id INT, name VARCHAR(255))"),
+  "create table $table";
+
+my $sth= $dbh->prepare("INSERT INTO $table (id, name) VALUES (?, ?)");
+for my $id (1 .. 200) {
+  $sth->execute($id, 'x' x 200);
+}
+ok $sth->finish;
+
+my $query= "SELECT id, name FROM $table ORDER BY id";
+
+# Below the cap, the result is buffered as usual
+$sth= $dbh->prepare($query, { drizzle_max_result_bytes => 1024 * 1024 });
+is $sth->{drizzle_max_result_bytes}, 1024 * 1024, "cap set through prepare";
+is $sth->{drizzle_max_result_action}, 'error', "default action is error";
+ok $sth->execute, "execute below the cap";
+is $sth->rows, 200, "all rows buffered";
+is scalar(@{$sth->fetchall_arrayref}), 200, "fetched all rows";
+
+# Above the cap with the default action
+$sth->{drizzle_max_result_bytes}= 1000;
+ok !eval { $sth->execute; 1 }, "execute above the cap fails";
+like $sth->errstr, qr/drizzle_max_result_bytes/, "error names the limit";
+ok $dbh->do("SELECT 1"), "connection is usable after the error";
+
+# Switch to streaming
+$sth->{drizzle_max_result_action}= 'stream';
+ok $sth->execute, "execute with stream";
+my $rows= $sth->fetchall_arrayref;
+is scalar(@$rows), 200, "streamed all rows";
+is $rows->[199][0], 200, "rows arrive in order";
+ok $dbh->{drizzle_dbd_stats}->{result_streams} >= 1, "stream was counted";
+
+# Spill to a temporary file
+$dbh->{drizzle_max_result_bytes}= 1000;
+$dbh->{drizzle_max_result_action}= 'spill';
+$sth= $dbh->prepare($query);
+is $sth->{drizzle_max_result_action}, 'spill', "action inherited from dbh";
+ok $sth->execute, "execute with spill";
+$rows= $sth->fetchall_arrayref;
+is scalar(@$rows), 200, "fetched all spilled rows";
+is $rows->[0][1], 'x' x 200, "spilled values are intact";
+
+ok $dbh->do("DROP TABLE $table"), "drop table $table";
+
+$dbh->disconnect;
@@ -0,0 +1,65 @@
+#!perl -w
+# vim: ft=perl
+#
+#   This is testing drizzle_seek, drizzle_tell, drizzle_fetch_range and
+#   drizzle_fetch_prev
+#
+
+use strict;
+use DBI;
+use Test::More;
+use lib 't', '.';
+require 'lib.pl';
+
+use vars qw($test_dsn $test_user $test_password $table);
+
+my $dbh;
+eval {$dbh= DBI->connect($test_dsn, $test_user, $test_password,
+                      { RaiseError => 1, PrintError => 0, AutoCommit => 1 });};
+if ($@) {
+    plan skip_all =>
+        "ERROR: $DBI::errstr. Can't continue test";
+}
+plan tests => 3 + 2 * 14 + 1;
+
+ok $dbh->do("DROP TABLE IF EXISTS $table"), "drop table if exists $table";
+
+ok $dbh->do("CREATE TABLE $table (id INT)"), "create table $table";
+
+ok $dbh->do("INSERT INTO $table (id) VALUES (1), (2), (3), (4), (5)"),
+  "insert rows";
+
+for my $compact (0, 1) {
+  my $sth= $dbh->prepare("SELECT id FROM $table ORDER BY id",
+                         { drizzle_compact_rows => $compact });
+  ok $sth->execute, "execute, compact rows $compact";
+  is $sth->drizzle_tell, 0, "starts at row 0";
+
+  $sth->fetchrow_arrayref for 1 .. 2;
+  is $sth->drizzle_tell, 2, "tell after two fetches";
+
+  ok $sth->drizzle_seek(1, 'rel'), "relative seek";
+  is $sth->fetchrow_arrayref->[0], 4, "row after relative seek";
+
+  ok $sth->drizzle_seek(-1, 'end'), "seek from the end";
+  is $sth->fetchrow_arrayref->[0], 5, "last row";
+
+  ok !eval { $sth->drizzle_seek(6) }, "seek past the end fails";
+
+  is_deeply $sth->drizzle_fetch_range(1, 3), [[2], [3], [4]], "range";
+  is_deeply $sth->drizzle_fetch_range(3, -10), [[4], [3], [2], [1]],
+    "backwards range";
+  is_deeply $sth->drizzle_fetch_range(4, 10), [[5]], "range stops at the end";
+
+  ok $sth->drizzle_seek(0, 'end'), "seek to the end";
+  my @ids;
+  while (my $row= $sth->drizzle_fetch_prev) {
+    push @ids, $row->[0];
+  }
+  is_deeply \@ids, [5, 4, 3, 2, 1], "reverse iteration";
+  ok $sth->finish;
+}
+
+ok $dbh->do("DROP TABLE $table"), "drop table $table";
+
+$dbh->disconnect;
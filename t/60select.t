@@ -0,0 +1,72 @@
+#!perl -w
+# vim: ft=perl
+#
+#   This is testing the select helpers that run without a statement handle
+#
+
+use strict;
+use DBI;
+use Test::More;
+use lib 't', '.';
+require 'lib.pl';
+
+use vars qw($test_dsn $test_user $test_password $table);
+
+my $dbh;
+eval {$dbh= DBI->connect($test_dsn, $test_user, $test_password,
+                      { RaiseError => 1, PrintError => 0, AutoCommit => 1 });};
+if ($@) {
+    plan skip_all =>
+        "ERROR: $DBI::errstr. Can't continue test";
+}
+plan tests => 18;
+
+ok $dbh->do("DROP TABLE IF EXISTS $table"), "drop table if exists $table";
+
+ok $dbh->do("CREATE TABLE $table (id INT PRIMARY KEY, Name VARCHAR(64))"),
+  "create table $table";
+
+my $sth= $dbh->prepare("INSERT INTO $table (id, Name) VALUES (?, ?)");
+$sth->execute($_, $_ == 2 ? undef : "name $_") for 1 .. 3;
+
+my $query= "SELECT id, Name FROM $table WHERE id = ?";
+
+is_deeply [ $dbh->selectrow_array($query, undef, 1) ], [ 1, 'name 1' ],
+  "selectrow_array";
+is scalar($dbh->selectrow_array("SELECT Name FROM $table WHERE id = 3")),
+  'name 3', "selectrow_array in scalar context";
+is_deeply [ $dbh->selectrow_array($query, {}, 4) ], [], "no row";
+is_deeply $dbh->selectrow_arrayref($query, undef, 2), [ 2, undef ],
+  "selectrow_arrayref";
+is_deeply $dbh->selectrow_hashref($query, undef, 3),
+  { id => 3, Name => 'name 3' }, "selectrow_hashref";
+ok !defined $dbh->selectrow_hashref($query, undef, 4), "no row hash";
+is_deeply $dbh->selectcol_arrayref("SELECT id FROM $table ORDER BY id"),
+  [ 1, 2, 3 ], "selectcol_arrayref";
+is_deeply $dbh->selectall_arrayref("SELECT id, Name FROM $table ORDER BY id"),
+  [ [ 1, 'name 1' ], [ 2, undef ], [ 3, 'name 3' ] ], "selectall_arrayref";
+is_deeply $dbh->selectall_arrayref("SELECT id FROM $table WHERE id > 9"),
+  [], "empty result";
+
+is_deeply $dbh->selectall_arrayref("SELECT id, Name FROM $table ORDER BY id",
+                                   { Slice => {} }),
+  [ { id => 1, Name => 'name 1' }, { id => 2, Name => undef },
+    { id => 3, Name => 'name 3' } ], "Slice goes through DBI";
+$sth= $dbh->prepare($query);
+is_deeply $dbh->selectrow_arrayref($sth, undef, 1), [ 1, 'name 1' ],
+  "statement handle goes through DBI";
+
+ok !eval { $dbh->selectrow_array("SELECT nosuchcolumn FROM $table"); 1 },
+  "errors are raised";
+
+$dbh->{drizzle_max_result_bytes}= 10;
+ok !eval { $dbh->selectall_arrayref("SELECT id, Name FROM $table"); 1 },
+  "drizzle_max_result_bytes applies";
+is $DBI::state, 'HY001', "result too large";
+$dbh->{drizzle_max_result_bytes}= 0;
+is scalar(@{$dbh->selectall_arrayref("SELECT id FROM $table")}), 3,
+  "without the cap again";
+
+ok $dbh->do("DROP TABLE $table"), "drop table $table";
+
+$dbh->disconnect;
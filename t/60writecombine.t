@@ -0,0 +1,67 @@
+#!perl -w
+# vim: ft=perl
+#
+#   This is testing drizzle_write_combine
+#
+
+use strict;
+use DBI;
+use Test::More;
+use lib 't', '.';
+require 'lib.pl';
+
+use vars qw($test_dsn $test_user $test_password $table);
+
+my $dbh;
+eval {$dbh= DBI->connect($test_dsn, $test_user, $test_password,
+                      { RaiseError => 1, PrintError => 0, AutoCommit => 0 });};
+if ($@) {
+    plan skip_all =>
+        "ERROR: $DBI::errstr. Can't continue test";
+}
+plan tests => 15;
+
+ok $dbh->do("DROP TABLE IF EXISTS $table"), "drop table if exists $table";
+
+ok $dbh->do("CREATE TABLE $table (id INT PRIMARY KEY, name VARCHAR(64))"),
+  "create table $table";
+
+my $sth= $dbh->prepare("INSERT INTO $table (id, name) VALUES (?, ?)",
+                       { drizzle_write_combine => { max_rows => 10 } });
+is $sth->{drizzle_write_combine}->{max_rows}, 10, "max_rows set";
+is $sth->{drizzle_write_combine}->{max_bytes}, 1048576, "max_bytes default";
+
+for my $id (1 .. 15) {
+  $sth->execute($id, "it's $id");
+}
+my ($count)= $dbh->selectrow_array("SELECT COUNT(*) FROM $table");
+is $count, 15, "another statement flushes the rows";
+
+$sth->execute(16, 'x');
+ok $dbh->commit, "commit flushes";
+($count)= $dbh->selectrow_array("SELECT COUNT(*) FROM $table");
+is $count, 16, "committed rows are there";
+
+$sth->execute(17, 'y');
+ok $dbh->rollback, "rollback";
+($count)= $dbh->selectrow_array("SELECT COUNT(*) FROM $table");
+is $count, 16, "rollback drops combined rows";
+
+# A duplicate key fails the whole batch, reported with its execute calls
+$sth->execute(100, 'a');
+$sth->execute(1, 'dup');
+ok !eval { $dbh->commit; 1 }, "commit fails on the deferred error";
+like $dbh->errstr, qr/execute calls \d+ to \d+/, "error names the calls";
+ok $dbh->rollback, "rollback after error";
+
+# Statements that cannot be combined run right away
+my $sel= $dbh->prepare("INSERT INTO $table SELECT id + 1000, name FROM $table",
+                       { drizzle_write_combine => {} });
+is $sel->execute, 16, "INSERT ... SELECT is not combined";
+
+$sth->{drizzle_write_combine}= 0;
+ok !defined $sth->{drizzle_write_combine}, "combining turned off";
+
+ok $dbh->do("DROP TABLE $table"), "drop table $table";
+
+$dbh->disconnect;